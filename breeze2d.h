@@ -41,23 +41,42 @@
 #error "The single or double floating-precision must be set"
 #endif
 
-#if !defined(HAVE_FFTW) && !defined(HAVE_FFTW_MKL)
-#error "The FFTW or MKL library must be turned on as FFT backend"
+#if !defined(HAVE_FFTW) && !defined(HAVE_FFTW_MKL) && !defined(HAVE_MKL_DFTI) && !defined(HAVE_BUILTIN_FFT)
+#error "The FFTW, MKL or in-tree FFT must be turned on as FFT backend"
 #endif
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846264338327
 #endif
 
+#ifdef HAVE_MPI
+// The C interface of MPI only, also in C++.
+#ifndef OMPI_SKIP_MPICXX
+#define OMPI_SKIP_MPICXX
+#endif
+#ifndef MPICH_SKIP_MPICXX
+#define MPICH_SKIP_MPICXX
+#endif
+#include <mpi.h>
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif // __cplusplus
 
+#include <breeze2d_timing.h>
 #include <breeze2d_poisson.h>
+#include <breeze2d_async.h>
+#include <breeze2d_executor.h>
+#include <breeze2d_elliptic.h>
+#include <breeze2d_project.h>
 #include <breeze2d_interop.h>
+#include <breeze2d_ooc.h>
+#ifdef HAVE_MPI
+#include <breeze2d_mpi.h>
+#endif
 #include <breeze2d_status.h>
-#include <breeze2d_timing.h>
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,385 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BREEZE2D_HPP
+#define BREEZE2D_HPP
+
+#include <breeze2d.h>
+#include <poisson2d/fft/wrapper.h>
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// C++ front-end of the 2D Poisson equation FFT solver
+// (header-only, requires C++14). Boundary condition kinds
+// and, optionally, grid dimensions are template parameters,
+// so that small fixed-size subdomains get the transform sizes,
+// shutter loop bounds and mode table fixed at compile time,
+// and keep all scratch arrays inside the solver object.
+namespace breeze2d
+{
+	// Grid dimension known only at runtime.
+	enum { dynamic = -1 };
+
+	// Boundary condition kinds.
+	struct dirichlet { };
+	struct neumann { };
+
+	// Defines exception thrown by solvers, with
+	// the BREEZE2D_* status code of the failure.
+	class error : public std::runtime_error
+	{
+		int status_;
+
+	public :
+
+		error(int status, const char* what) :
+			std::runtime_error(what), status_(status) { }
+
+		int status() const { return status_; }
+	};
+
+	namespace detail
+	{
+		// Sine evaluated by the compiler (Taylor series,
+		// accurate to long double precision on [0, pi / 2]).
+		constexpr long double sin(long double x)
+		{
+			long double term = x, sum = x;
+			for (int i = 1; i < 16; i++)
+			{
+				term *= -x * x / ((2 * i) * (2 * i + 1));
+				sum += term;
+			}
+			return sum;
+		}
+
+		// X b.c. define the transform kind, the half-angle of
+		// mode p and the inverse transform normalization.
+		template<typename BCKind>
+		struct bc_x;
+
+		// Dirichlet b.c. by X: sine transform over m inner points.
+		template<>
+		struct bc_x<dirichlet>
+		{
+			static fft_kind kind() { return FFT_RODFT00; }
+
+			static constexpr long double theta(int p, int m)
+			{
+				return M_PI * (p + 1) / (2.0L * (m + 1));
+			}
+
+			static constexpr long double norm(int m)
+			{
+				return 0.5L / (m + 1);
+			}
+		};
+
+		// Y b.c. define the shutter ground coefficients
+		// and the top boundary value.
+		template<typename BCKind>
+		struct bc_y;
+
+		// Dirichlet b.c. by Y: by and ey are the values
+		// on the lower and upper boundary rows.
+		template<>
+		struct bc_y<dirichlet>
+		{
+			template<typename Real>
+			static void ground(Real& alpha, Real& beta, Real g, Real hy)
+			{
+				alpha = 0.0; beta = g;
+			}
+
+			template<typename Real>
+			static Real top(Real alpha, Real beta, Real g, Real hy)
+			{
+				return g;
+			}
+		};
+
+		// Neumann b.c. by Y: by and ey are the normal derivatives
+		// between the boundary and the outermost inner rows.
+		template<>
+		struct bc_y<neumann>
+		{
+			template<typename Real>
+			static void ground(Real& alpha, Real& beta, Real g, Real hy)
+			{
+				alpha = 1.0; beta = -hy * g;
+			}
+
+			template<typename Real>
+			static Real top(Real alpha, Real beta, Real g, Real hy)
+			{
+				return (beta + hy * g) / (1.0 - alpha);
+			}
+		};
+
+		template<int Size>
+		struct plus_one
+		{
+			enum { value = (Size == dynamic) ? dynamic : Size + 1 };
+		};
+
+		// Scratch array: in place, when the size is static,
+		// on the heap otherwise.
+		template<typename Real, int Size>
+		class buffer
+		{
+			Real data_[Size];
+
+		public :
+
+			explicit buffer(int size) { assert(size == Size); }
+
+			Real* data() { return data_; }
+
+			Real& operator[](int i) { return data_[i]; }
+		};
+
+		template<typename Real>
+		class buffer<Real, dynamic>
+		{
+			std::vector<Real> data_;
+
+		public :
+
+			explicit buffer(int size) : data_(size) { }
+
+			Real* data() { return &data_[0]; }
+
+			Real& operator[](int i) { return data_[i]; }
+		};
+
+		// Table of sin^2(theta_p) for all X modes: evaluated
+		// by the compiler, when the number of modes is static.
+		template<typename Real, typename BCKindX, int M>
+		class modes
+		{
+			struct table
+			{
+				Real value[M];
+
+				constexpr table() : value()
+				{
+					for (int p = 0; p < M; p++)
+					{
+						long double s = sin(bc_x<BCKindX>::theta(p, M));
+						value[p] = s * s;
+					}
+				}
+			};
+
+		public :
+
+			explicit modes(int m) { assert(m == M); }
+
+			const Real* data() const
+			{
+				static constexpr table t;
+				return t.value;
+			}
+		};
+
+		template<typename Real, typename BCKindX>
+		class modes<Real, BCKindX, dynamic>
+		{
+			std::vector<Real> value;
+
+		public :
+
+			explicit modes(int m) : value(m)
+			{
+				for (int p = 0; p < m; p++)
+				{
+					Real s = std::sin(bc_x<BCKindX>::theta(p, m));
+					value[p] = s * s;
+				}
+			}
+
+			const Real* data() const { return &value[0]; }
+		};
+	}
+
+	// The 2D Poisson equation FFT solver, layered over the same
+	// transform kernels as poisson2d_fft_solver: 1D transform
+	// by X and shutter by Y. Note m and n are the numbers of
+	// INNER grid points, as in breeze2d_poisson_solver_init.
+	// Like the C solver, the solver object keeps pointers to the
+	// data arrays, and the right hand side is destroyed by solve.
+	template<typename Real, typename BCKindX, typename BCKindY,
+		int M = dynamic, int N = dynamic>
+	class poisson_solver
+	{
+		static_assert(std::is_same<Real, real>::value,
+			"Real must match the library precision (HAVE_SINGLE or HAVE_DOUBLE)");
+		static_assert(std::is_same<BCKindX, dirichlet>::value,
+			"Only Dirichlet b.c. by X are supported, as in the C solver");
+
+		int m_, n_;
+		Real hx, hy;
+		Real *rhs, *solution;
+
+		// Transformed boundary conditions.
+		detail::buffer<Real, M> cby, cey;
+
+		// Shutter coefficients.
+		detail::buffer<Real, detail::plus_one<N>::value> alpha, beta;
+
+		detail::modes<Real, BCKindX, M> modes;
+
+		fft_plan *plan_main, *plan_bc, *plan_ec;
+
+		// Release the created plans.
+		void dispose()
+		{
+			if (plan_main) fft_dispose(plan_main);
+			if (plan_bc) fft_dispose(plan_bc);
+			if (plan_ec) fft_dispose(plan_ec);
+		}
+
+		// Grid dimensions: compile-time constants,
+		// when specified as template arguments.
+		int m() const { return (M == dynamic) ? m_ : M; }
+		int n() const { return (N == dynamic) ? n_ : N; }
+
+		// Solve m 3-diagonal systems of n equations
+		// using shutter method in real space.
+		void shutter(Real* rhs, Real* solution)
+		{
+			const int m = this->m(), n = this->n();
+			const Real r = hy / hx;
+			const Real norm = detail::bc_x<BCKindX>::norm(m);
+			const Real* sin2 = modes.data();
+
+			for (int p = 0; p < m; p++)
+			{
+				Real b = 2.0 + 4.0 * r * r * sin2[p];
+
+				detail::bc_y<BCKindY>::ground(alpha[0], beta[0], cby[p], hy);
+
+				for (int k = 1; k <= n; k++)
+				{
+					Real val = 1.0 / (b - alpha[k - 1]);
+
+					alpha[k] = val;
+					beta[k] = (beta[k - 1] -
+						hy * hy * rhs[p + (k - 1) * m]) * val;
+				}
+
+				Real next = norm * detail::bc_y<BCKindY>::top(
+					alpha[n], beta[n], cey[p], hy);
+
+				for (int k = n; k >= 1; k--)
+				{
+					next = alpha[k] * next + norm * beta[k];
+					solution[p + (k - 1) * m] = next;
+				}
+			}
+		}
+
+	public :
+
+		// Initialize solver for the specified problem size and data arrays.
+		// Throws breeze2d::error, if transforms cannot be planned.
+		// @param m - The problem X grid dimension, excluding boundaries
+		// @param n - The problem Y grid dimension, excluding boundaries
+		// @param hx - The problem X grid step
+		// @param hy - The problem Y grid step
+		// @param by - The Y lower side boundary m x 1 array
+		// @param ey - The Y upper side boundary m x 1 array
+		// @param rhs - The right hand side m x n array
+		// @param solution - The problem solution m x n array
+		poisson_solver(int m, int n, Real hx, Real hy,
+			Real* by, Real* ey, Real* rhs, Real* solution) :
+
+			m_(m), n_(n), hx(hx), hy(hy), rhs(rhs), solution(solution),
+			cby(m), cey(m), alpha(n + 1), beta(n + 1), modes(m)
+		{
+			assert((M == dynamic) || (m == M));
+			assert((N == dynamic) || (n == N));
+
+			// Small subdomains are transformed in the calling thread.
+			// The number of threads of plans created afterwards
+			// by other solvers is kept.
+			fft_init_threads();
+			int nthreads = fft_get_plan_nthreads();
+			fft_plan_with_nthreads(1);
+
+			const fft_kind kind = detail::bc_x<BCKindX>::kind();
+			plan_main = fft_create_multi(this->m(), this->n(),
+				rhs, solution, this->m(), this->m(), kind, FFT_MEASURE);
+			plan_bc = fft_create(this->m(), by, cby.data(), kind, FFT_MEASURE);
+			plan_ec = fft_create(this->m(), ey, cey.data(), kind, FFT_MEASURE);
+			fft_plan_with_nthreads(nthreads);
+			if (!plan_main || !plan_bc || !plan_ec)
+			{
+				dispose();
+				throw error(BREEZE2D_FFT_PLAN_CREATION_FAILED,
+					"FFT plan creation failed");
+			}
+		}
+
+		// Initialize solver with grid dimensions given by template arguments.
+		poisson_solver(Real hx, Real hy,
+			Real* by, Real* ey, Real* rhs, Real* solution) :
+
+			poisson_solver(M, N, hx, hy, by, ey, rhs, solution)
+		{
+			static_assert((M != dynamic) && (N != dynamic),
+				"Grid dimensions must be specified");
+		}
+
+		poisson_solver(const poisson_solver&) = delete;
+		poisson_solver& operator=(const poisson_solver&) = delete;
+
+		~poisson_solver()
+		{
+			dispose();
+		}
+
+		// Solve 2D Poisson equation with the given right hand
+		// side. Place result to the output array specified in
+		// solver configuration.
+		void solve()
+		{
+			// Compute coefficients for the right hand side
+			// and boundary conditions.
+			fft_forward(plan_main);
+			fft_forward(plan_bc);
+			fft_forward(plan_ec);
+
+			// Solve 3-diagonal systems, using rhs as scratch.
+			shutter(solution, rhs);
+
+			// Compute result using inverse transform
+			// on 3-diagonal systems solutions.
+			fft_inverse(plan_main);
+		}
+	};
+}
+
+#endif // BREEZE2D_HPP
+
@@ -0,0 +1,146 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BREEZE2D_ASYNC_H
+#define BREEZE2D_ASYNC_H
+
+#ifndef BREEZE2D_H
+#error Please always include <breeze2d.h>, and never include other BREEZE2D headers
+#endif
+
+/**
+ * The asynchronous solve request handle.
+ */
+typedef void* breeze2d_poisson_request;
+
+/**
+ * Start solving 2D Poisson equation with the given right hand
+ * side on the internal solver thread pool, and return without
+ * waiting for the solution. Solves of the same solver are
+ * performed one after another, in the order of submission,
+ * while solves of different solvers may run concurrently.
+ * @param desc - The solver configuration
+ * @return The request handle to wait for completion.
+ *
+ * Note the solver data arrays (right hand side, solution and
+ * boundary conditions) are owned by the solver from submission
+ * until breeze2d_poisson_wait returns, or breeze2d_poisson_test
+ * reports completion: they must be neither read nor written
+ * meanwhile. The solver must not be used synchronously or
+ * disposed, until all its requests are completed. Each request
+ * handle must be released with breeze2d_poisson_wait.
+ */
+breeze2d_poisson_request breeze2d_poisson_solve_async(
+	breeze2d_poisson_solver desc);
+
+/**
+ * Wait for the asynchronous solve to complete, and
+ * release the request handle.
+ * @param request - The request handle
+ */
+void breeze2d_poisson_wait(breeze2d_poisson_request request);
+
+/**
+ * Check if the asynchronous solve is completed, without
+ * waiting. The request handle is NOT released: once completed,
+ * breeze2d_poisson_wait returns at once and releases it.
+ * @param request - The request handle
+ * @return 1, if solve is completed, 0 otherwise.
+ */
+int breeze2d_poisson_test(breeze2d_poisson_request request);
+
+/**
+ * Set the number of threads of the internal solver thread
+ * pool, the maximum number of solves in flight (2 by default).
+ * Each solve also uses OpenMP threads, as synchronous solve.
+ * The pool may only grow.
+ * @param nthreads - The number of pool threads
+ */
+void breeze2d_poisson_async_set_nthreads(int nthreads);
+
+/**
+ * Wait for all submitted solves to complete, and stop the
+ * internal solver thread pool threads, e.g. before unloading
+ * the library. Request handles still need to be released with
+ * breeze2d_poisson_wait. The next breeze2d_poisson_solve_async
+ * starts the pool again. Must not be called concurrently with
+ * other asynchronous solve functions.
+ */
+void breeze2d_poisson_async_finalize();
+
+/**
+ * The solve queue handle.
+ */
+typedef void* breeze2d_solve_queue;
+
+/**
+ * Create the solve queue for throughput of many solves of
+ * different sizes: persistent workers, each with its own
+ * deque of jobs, stealing from the deques of others when idle.
+ * A small job runs on a single worker, without OpenMP threads,
+ * a job of split or more grid points runs its parallel loops
+ * on all workers: other workers take its loop iterations,
+ * until it is completed.
+ * @param nworkers - The number of workers, or 0 for
+ * the number of processors
+ * @param split - The grid size (m * n) of jobs to run on all
+ * workers, or 0 for the default (65536)
+ * @return The solve queue handle, or NULL, if workers
+ * could not be started.
+ *
+ * Note FFTW plans keep the number of threads they were
+ * planned with, regardless of the job size.
+ */
+breeze2d_solve_queue breeze2d_solve_queue_init(int nworkers, long split);
+
+/**
+ * Submit the solve job to the queue, and return without waiting.
+ * @param queue - The solve queue handle
+ * @param desc - The solver configuration (FFT solver, if arrays given)
+ * @param rhs - The right hand side array to bind to the solver before
+ * solve (see breeze2d_poisson_solver_set_arrays), or NULL to keep the
+ * bound arrays
+ * @param solution - The solution array, or rhs for in-place solve
+ * @param callback - The function to call on worker thread after the
+ * solve, or NULL
+ * @param arg - The callback argument
+ *
+ * Note each solver may have only one job in the queue at a time,
+ * that is, the next job of the same solver may be submitted from
+ * the callback of the previous one, or after barrier.
+ */
+void breeze2d_solve_queue_submit(breeze2d_solve_queue queue,
+	breeze2d_poisson_solver desc, real* rhs, real* solution,
+	void (*callback)(breeze2d_poisson_solver desc, void* arg), void* arg);
+
+/**
+ * Wait for all submitted jobs to complete (including jobs submitted
+ * from callbacks meanwhile). Must not be called from callbacks.
+ * @param queue - The solve queue handle
+ */
+void breeze2d_solve_queue_wait(breeze2d_solve_queue queue);
+
+/**
+ * Wait for all submitted jobs to complete, stop workers and
+ * release the solve queue.
+ * @param queue - The solve queue handle
+ */
+void breeze2d_solve_queue_dispose(breeze2d_solve_queue queue);
+
+#endif // BREEZE2D_ASYNC_H
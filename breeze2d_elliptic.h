@@ -0,0 +1,109 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BREEZE2D_ELLIPTIC_H
+#define BREEZE2D_ELLIPTIC_H
+
+#ifndef BREEZE2D_H
+#error Please always include <breeze2d.h>, and never include other BREEZE2D headers
+#endif
+
+/**
+ * Defines identifier for elliptic solver based on
+ * preconditioned conjugate gradient method
+ * (symmetric problems).
+ */
+#define BREEZE2D_ELLIPTIC_PCG		0
+
+/**
+ * Defines identifier for elliptic solver based on
+ * preconditioned stabilized biconjugate gradient method.
+ */
+#define BREEZE2D_ELLIPTIC_BICGSTAB	1
+
+/**
+ * The 2D variable-coefficient elliptic equation solver descriptor.
+ */
+typedef void* breeze2d_elliptic_solver;
+
+/**
+ * Initialize iterative solver of 2D elliptic equation
+ * div(k grad phi) = f, with face coefficients k (e.g. 1 / rho
+ * for density-weighted pressure equation), and phi = 0 on
+ * the boundary. The 2D Poisson equation solver of the same grid
+ * is used as preconditioner: it must be initialized with zero
+ * boundary conditions and dense arrays. Preconditioner right hand
+ * side and solution arrays serve as iteration vectors, and all other vectors are
+ * allocated here, so that solve allocates no memory.
+ * Note m and n are the numbers of INNER grid points,
+ * i.e. including boundaries the total number is + 2.
+ * @param method - The iterative method to use
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param hx - The problem X grid step
+ * @param hy - The problem Y grid step
+ * @param kx - The coefficient (m + 1) x n array on cell X faces,
+ * kx[j * (m + 1) + i] is the face between points i - 1 and i of row j
+ * @param ky - The coefficient m x (n + 1) array on cell Y faces,
+ * ky[j * m + i] is the face between points i of rows j - 1 and j
+ * @param precond - The preconditioner solver configuration
+ * @return The solver configuration.
+ */
+breeze2d_elliptic_solver breeze2d_elliptic_solver_init(int method,
+	unsigned int m, unsigned int n, real hx, real hy,
+	const real* kx, const real* ky, breeze2d_poisson_solver precond);
+
+/**
+ * Set the convergence criteria: the residual norm relative
+ * to the right hand side norm, and the iterations limit.
+ * @param desc - The solver configuration
+ * @param tolerance - The relative residual norm to reach
+ * @param maxiters - The maximum number of iterations
+ */
+void breeze2d_elliptic_solver_set_tolerance(breeze2d_elliptic_solver desc,
+	real tolerance, int maxiters);
+
+/**
+ * Release resources used by the specified solver instance.
+ * @param desc - The solver configuration
+ */
+void breeze2d_elliptic_solver_dispose(breeze2d_elliptic_solver desc);
+
+/**
+ * Solve 2D elliptic equation with the given right hand side.
+ * @param desc - The solver configuration
+ * @param f - The right hand side m x n array
+ * @param phi - The solution m x n array, holding
+ * the initial guess on entry
+ * @return The number of iterations performed, or minus the number
+ * of iterations performed, if tolerance was not reached: -maxiters
+ * at the iterations limit, greater on the method breakdown.
+ */
+int breeze2d_elliptic_solve(breeze2d_elliptic_solver desc,
+	const real* f, real* phi);
+
+/**
+ * Get the relative residual norm reached by the last solve.
+ * @param desc - The solver configuration
+ * @return The residual norm relative to the right hand side norm.
+ */
+real breeze2d_elliptic_residual(breeze2d_elliptic_solver desc);
+
+#endif // BREEZE2D_ELLIPTIC_H
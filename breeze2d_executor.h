@@ -0,0 +1,74 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BREEZE2D_EXECUTOR_H
+#define BREEZE2D_EXECUTOR_H
+
+#ifndef BREEZE2D_H
+#error Please always include <breeze2d.h>, and never include other BREEZE2D headers
+#endif
+
+/**
+ * Defines external executor of the library parallel loops
+ * (transforms of row blocks, shutter sweeps of modes, vector
+ * updates and residual norms of iterative solvers), e.g. the
+ * thread pool of the application, used instead of OpenMP.
+ */
+typedef struct
+{
+	/**
+	 * Run task(arg, index) for each index from 0 to ntasks - 1,
+	 * and return once all of them are completed. Tasks are
+	 * independent, and may run in any order, concurrently or not.
+	 * The number of tasks never exceeds nthreads.
+	 */
+	void (*run)(void* context, int ntasks,
+		void (*task)(void* arg, int index), void* arg);
+
+	/**
+	 * The context passed to run.
+	 */
+	void* context;
+
+	/**
+	 * The number of tasks run is able to perform concurrently.
+	 */
+	int nthreads;
+}
+breeze2d_executor;
+
+/**
+ * Set the external executor of the library parallel loops, or
+ * restore OpenMP threads, if NULL. Solvers size their per-thread
+ * workspace and plan transforms for the executor in effect at
+ * init, so it should be set before creating solvers, and must
+ * not be changed while solves are in flight. Setting it is
+ * thread-safe: each parallel loop runs entirely on the executor
+ * in effect at its start.
+ * @param executor - The executor (copied), or NULL
+ *
+ * Note FFTW threads are replaced by the executor only if FFTW
+ * supports threads callback (3.3.9 or newer). MKL threads and
+ * the task graph of BREEZE2D_POISSON_PIPELINE solves are not
+ * replaced: with the executor set, pipelined solvers use
+ * the staged solve.
+ */
+void breeze2d_set_executor(const breeze2d_executor* executor);
+
+#endif // BREEZE2D_EXECUTOR_H
@@ -0,0 +1,98 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BREEZE2D_MPI_H
+#define BREEZE2D_MPI_H
+
+#ifndef BREEZE2D_H
+#error Please always include <breeze2d.h>, and never include other BREEZE2D headers
+#endif
+
+/**
+ * The distributed 2D Poisson equation solver descriptor.
+ */
+typedef void* breeze2d_poisson_mpi_solver;
+
+/**
+ * Get the rows of the grid owned by the calling process: the n
+ * rows by Y are split between processes of the communicator into
+ * contiguous slabs, in the order of ranks.
+ * @param comm - The communicator
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param first - The index of the first owned row (filled on exit)
+ * @param count - The number of owned rows (filled on exit)
+ */
+void breeze2d_poisson_mpi_get_rows(MPI_Comm comm, unsigned int n,
+	unsigned int* first, unsigned int* count);
+
+/**
+ * Initialize 2D Poisson equation solver distributed between
+ * processes of the communicator (collective), with Dirichlet
+ * boundary conditions by X (zero) and by Y. Each process holds
+ * its slab of rows (see breeze2d_poisson_mpi_get_rows) of the
+ * right hand side and solution, m x count arrays. Transforms
+ * by X are local to slabs, and the 3-diagonal systems by Y are
+ * solved after all-to-all transpose, each process owning all
+ * rows of a range of modes, then transposed back. Transposes
+ * overlap with transforms and shutter sweeps.
+ * @param comm - The communicator (duplicated)
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param hx - The X grid step
+ * @param hy - The Y grid step
+ * @param by - The bottom boundary condition, m values, used
+ * on the first process only (may be NULL on others)
+ * @param ey - The top boundary condition, m values, used
+ * on the last process only (may be NULL on others)
+ * @param rhs - The right hand side slab, overwritten by solve
+ * @param solution - The solution slab, or rhs for in-place solve
+ * @return The solver configuration, or NULL on all processes,
+ * if initialization failed on any of them.
+ */
+breeze2d_poisson_mpi_solver breeze2d_poisson_mpi_solver_init(MPI_Comm comm,
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* by, real* ey, real* rhs, real* solution);
+
+/**
+ * Solve 2D Poisson equation with the given right hand side
+ * (collective).
+ * @param desc - The solver configuration
+ */
+void breeze2d_poisson_mpi_solve(breeze2d_poisson_mpi_solver desc);
+
+/**
+ * Get the time spent by the calling process in solves, since
+ * init, by stage: transforms by X, 3-diagonal systems by Y, and
+ * waiting for transposes (communication not hidden by overlap).
+ * @param desc - The solver configuration
+ * @param transform - The time of transforms in seconds (filled on exit)
+ * @param shutter - The time of shutter sweeps in seconds (filled on exit)
+ * @param wait - The time of waiting for transposes in seconds
+ * (filled on exit)
+ */
+void breeze2d_poisson_mpi_get_times(breeze2d_poisson_mpi_solver desc,
+	double* transform, double* shutter, double* wait);
+
+/**
+ * Release resources used by the specified solver (collective).
+ * @param desc - The solver configuration
+ */
+void breeze2d_poisson_mpi_solver_dispose(breeze2d_poisson_mpi_solver desc);
+
+#endif // BREEZE2D_MPI_H
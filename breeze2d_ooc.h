@@ -0,0 +1,104 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BREEZE2D_OOC_H
+#define BREEZE2D_OOC_H
+
+#ifndef BREEZE2D_H
+#error Please always include <breeze2d.h>, and never include other BREEZE2D headers
+#endif
+
+#include <stddef.h>
+
+/**
+ * The out-of-core 2D Poisson equation solver descriptor.
+ */
+typedef void* breeze2d_poisson_ooc_solver;
+
+/**
+ * Defines statistics of the last out-of-core solve.
+ */
+typedef struct
+{
+	/**
+	 * The number of bytes read from and written to files.
+	 */
+	size_t bytes_read, bytes_written;
+
+	/**
+	 * The solve time, the time of reads and writes (performed
+	 * by the I/O thread, meanwhile with computations), and the
+	 * time computations waited for them, in seconds.
+	 */
+	double time, io_time, io_wait;
+}
+breeze2d_poisson_ooc_stats;
+
+/**
+ * Initialize 2D Poisson equation solver for grids kept in files,
+ * with Dirichlet boundary conditions by X (zero) and by Y. The
+ * right hand side and solution are m x n arrays of rows, stored
+ * from the beginning of files. Solve reads and writes bands of
+ * rows in two passes, each grid once per pass: transforms by X
+ * with forward shutter sweeps from the bottom, and backward sweeps
+ * with inverse transforms from the top. Bands are read ahead and
+ * written behind by the I/O thread, while the previous band is
+ * computed.
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param hx - The X grid step
+ * @param hy - The Y grid step
+ * @param by - The bottom boundary condition, m values
+ * @param ey - The top boundary condition, m values
+ * @param rhs - The file descriptor of the right hand side,
+ * opened for reading
+ * @param solution - The file descriptor of the solution, opened
+ * for reading and writing, or rhs for in-place solve
+ * @param memory - The memory for bands in bytes, or 0 for
+ * the default (256 MB)
+ * @return The solver configuration, or NULL, if initialization failed.
+ *
+ * Note the right hand side is not changed by solve, unless
+ * the solve is in-place.
+ */
+breeze2d_poisson_ooc_solver breeze2d_poisson_ooc_solver_init(
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* by, real* ey, int rhs, int solution, size_t memory);
+
+/**
+ * Solve 2D Poisson equation with the right hand side in file.
+ * @param desc - The solver configuration
+ */
+void breeze2d_poisson_ooc_solve(breeze2d_poisson_ooc_solver desc);
+
+/**
+ * Get statistics of the last solve.
+ * @param desc - The solver configuration
+ * @param stats - The statistics (filled on exit)
+ */
+void breeze2d_poisson_ooc_get_stats(breeze2d_poisson_ooc_solver desc,
+	breeze2d_poisson_ooc_stats* stats);
+
+/**
+ * Release resources used by the specified solver.
+ * @param desc - The solver configuration
+ */
+void breeze2d_poisson_ooc_solver_dispose(breeze2d_poisson_ooc_solver desc);
+
+#endif // BREEZE2D_OOC_H
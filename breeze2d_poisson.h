@@ -25,6 +25,8 @@
 #error Please always include <breeze2d.h>, and never include other BREEZE2D headers
 #endif
 
+#include <stddef.h>
+
 /**
  * Defines identifier for Poisson solver
  * based on FFT.
@@ -37,6 +39,142 @@
  */
 #define BREEZE2D_POISSON_SOLVER_FDIFFS	1
 
+/**
+ * Defines identifier for Poisson solver in domain
+ * with obstacles, based on capacitance matrix method
+ * over FFT solver (see breeze2d_poisson_solver_set_mask).
+ */
+#define BREEZE2D_POISSON_SOLVER_CAPACITANCE	2
+
+/**
+ * Defines the bits of mode holding the solver identifier,
+ * the remaining bits hold BREEZE2D_POISSON_* option flags.
+ */
+#define BREEZE2D_POISSON_SOLVER_MASK	0xff
+
+/**
+ * Defines option flag to keep the transformed right hand
+ * side between solves, allowing to re-solve with updated
+ * boundary conditions only (breeze2d_poisson_solve_bc).
+ * Costs an extra m x n array.
+ */
+#define BREEZE2D_POISSON_CACHE_RHS	0x100
+
+/**
+ * Defines option flag to reserve space for the solution
+ * gradient outputs (breeze2d_poisson_solver_set_gradient).
+ * Costs an extra (m + 2) x n array.
+ */
+#define BREEZE2D_POISSON_GRADIENT	0x200
+
+/**
+ * Defines option flag to factorize 3-diagonal systems of all
+ * modes at init, speeding up point source solves
+ * (breeze2d_poisson_solve_sparse). Costs an extra
+ * m x (n + 1) array.
+ */
+#define BREEZE2D_POISSON_SPARSE		0x400
+
+/**
+ * Defines option flag to reserve space for the Y grid
+ * with variable steps (breeze2d_poisson_solver_set_grid_y).
+ * Costs an extra m x (n + 1) array.
+ */
+#define BREEZE2D_POISSON_STRETCHED_Y	0x800
+
+/**
+ * Defines option flag to use the fourth order compact
+ * (Mehrstellen) discretization instead of the 5-point
+ * stencil. Requires hy / hx below sqrt(2). Not compatible
+ * with gradient outputs, variable Y grid steps and projection.
+ */
+#define BREEZE2D_POISSON_COMPACT4	0x1000
+
+/**
+ * Defines option flag to return from init with estimated
+ * transform plans, and create measured plans in background
+ * thread (on private arrays, saving planner wisdom), swapping
+ * them in at the start of the first solve after they are ready.
+ * No-op with backends having no planner flags (builtin, MKL
+ * and DFTI), which create the same plans at once.
+ */
+#define BREEZE2D_POISSON_PROGRESSIVE	0x2000
+
+/**
+ * Defines option flag to select the number of threads and
+ * the transform planner effort by timing candidate
+ * configurations at init (on private arrays), or by looking
+ * up the tuning database, where the selected configuration
+ * is saved for this problem size, precision and number
+ * of cores, separately for BREEZE2D_POISSON_SERIAL solvers.
+ * The database is .tuning in the current directory, or the
+ * file named by BREEZE2D_TUNING_FILE environment variable.
+ */
+#define BREEZE2D_POISSON_AUTOTUNE	0x4000
+
+/**
+ * Defines option flag to run solves as a graph of tasks:
+ * transforms of row batches and shutter sweeps of mode
+ * blocks, each starting as soon as its inputs are ready,
+ * instead of stages separated by barriers. Costs an extra
+ * m x n array. Not compatible with cached right hand side,
+ * gradient outputs, variable Y grid steps and the fourth
+ * order compact scheme.
+ */
+#define BREEZE2D_POISSON_PIPELINE	0x8000
+
+/**
+ * Defines option flag to solve in the calling thread only,
+ * for callers solving many independent problems concurrently
+ * from their own threads: transforms are planned single-threaded,
+ * and solver parallel loops are not split.
+ */
+#define BREEZE2D_POISSON_SERIAL		0x10000
+
+/**
+ * Defines option flag to count hardware events of solve stages
+ * (cycles, instructions and last level cache misses, with Linux
+ * perf_event_open), reported by breeze2d_poisson_solver_get_stats.
+ * Where counters are not supported or not permitted, stages
+ * are timed only.
+ */
+#define BREEZE2D_POISSON_COUNTERS	0x20000
+
+/**
+ * Defines stages of FFT solves in statistics: forward transforms
+ * of the right hand side and boundary conditions, shutter sweeps,
+ * inverse transforms, and the whole solve (the only stage counted
+ * in pipelined solves, where stages overlap).
+ */
+#define BREEZE2D_POISSON_STAGE_FORWARD	0
+#define BREEZE2D_POISSON_STAGE_SHUTTER	1
+#define BREEZE2D_POISSON_STAGE_INVERSE	2
+#define BREEZE2D_POISSON_STAGE_SOLVE	3
+#define BREEZE2D_POISSON_NSTAGES	4
+
+/**
+ * Defines statistics of solve stages, accumulated over solves.
+ */
+typedef struct
+{
+	/**
+	 * The number of runs of each stage.
+	 */
+	unsigned int ncalls[BREEZE2D_POISSON_NSTAGES];
+
+	/**
+	 * The time and hardware event counts of each stage.
+	 */
+	breeze2d_counters counters[BREEZE2D_POISSON_NSTAGES];
+
+	/**
+	 * The metrics derived from counters of each stage,
+	 * per grid point of one run.
+	 */
+	breeze2d_counter_metrics metrics[BREEZE2D_POISSON_NSTAGES];
+}
+breeze2d_poisson_stats;
+
 /**
  * The 2D Poisson euqation solver descriptor.
  */
@@ -47,7 +185,8 @@ typedef void* breeze2d_poisson_solver;
  * specified problem size and data arrays.
  * Note m and n are the numbers of INNER grid points,
  * i.e. including boundaries the total number is + 2.
- * @param mode - The Poisson equation solver to use
+ * @param mode - The Poisson equation solver to use,
+ * optionally combined with BREEZE2D_POISSON_* flags
  * @param m - The problem X grid dimension, excluding boundaries
  * @param n - The problem Y grid dimension, excluding boundaries
  * @param hx - The problem X grid step
@@ -58,26 +197,352 @@ typedef void* breeze2d_poisson_solver;
  * @param ey - The Y upper side boundary n x 1 array
  * @param rhs - The right hand side m x n array
  * @param solution - The problem solution m x n array
+ *
+ * Note the right hand side array is used by solver as scratch
+ * space, and its contents are destroyed by each solve. The rhs
+ * and solution may be the same array: then solver works in place
+ * (single buffer mode), and each solve consumes the right hand
+ * side and replaces it with the solution. Both arrays are also
+ * overwritten during init, while FFT plans are benchmarked.
  */
 breeze2d_poisson_solver breeze2d_poisson_solver_init(int mode,
 	unsigned int m, unsigned int n, real hx, real hy,
 	real* bx, real* ex, real* by, real* ey,
 	real* rhs, real* solution);
 
+/**
+ * Get the size of workspace memory used by 2D Poisson
+ * equation solver of the specified problem size.
+ * @param mode - The Poisson equation solver to use,
+ * optionally combined with BREEZE2D_POISSON_* flags
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @return The workspace size in bytes.
+ */
+size_t breeze2d_poisson_solver_workspace_size(int mode,
+	unsigned int m, unsigned int n);
+
+/**
+ * Initialize 2D Poisson equation solver for the
+ * specified problem size and data arrays, placing all
+ * solver data into the caller-provided workspace.
+ * No heap memory is allocated by the solver after init,
+ * except the internal data of FFT library plans.
+ * The workspace must stay valid until the solver is disposed.
+ * @param mode - The Poisson equation solver to use,
+ * optionally combined with BREEZE2D_POISSON_* flags
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param hx - The problem X grid step
+ * @param hy - The problem Y grid step
+ * @param bx - The X left side boundary m x 1 array
+ * @param ex - The X right side boundary m x 1 array
+ * @param by - The Y lower side boundary n x 1 array
+ * @param ey - The Y upper side boundary n x 1 array
+ * @param rhs - The right hand side m x n array
+ * @param solution - The problem solution m x n array
+ * @param workspace - The workspace memory, aligned to 64 bytes
+ * @param size - The workspace size, at least
+ * breeze2d_poisson_solver_workspace_size(mode, m, n) bytes
+ *
+ * Note the rhs and solution arrays follow the same contract
+ * as in breeze2d_poisson_solver_init, including single buffer mode.
+ */
+breeze2d_poisson_solver breeze2d_poisson_solver_init_workspace(int mode,
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* bx, real* ex, real* by, real* ey,
+	real* rhs, real* solution, void* workspace, size_t size);
+
+/**
+ * Initialize 2D Poisson equation solver for the specified
+ * problem size and data arrays with padded rows, e.g. model
+ * fields with halo: the solver reads the right hand side and
+ * writes the solution in place, with no copies. The m x n inner
+ * points start at the offset element, and rows are ld elements
+ * apart. Only BREEZE2D_POISSON_SOLVER_FFT supports padded arrays.
+ * Spectral space fields have the same layout as rhs and solution,
+ * while gradient outputs and projected velocities stay dense.
+ * @param mode - The Poisson equation solver to use,
+ * optionally combined with BREEZE2D_POISSON_* flags
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param hx - The problem X grid step
+ * @param hy - The problem Y grid step
+ * @param bx - The X left side boundary m x 1 array
+ * @param ex - The X right side boundary m x 1 array
+ * @param by - The Y lower side boundary n x 1 array
+ * @param ey - The Y upper side boundary n x 1 array
+ * @param rhs - The right hand side array
+ * @param solution - The problem solution array
+ * @param ld - The distance between rows, at least m
+ * @param offset - The index of the first inner point
+ * in rhs and solution arrays
+ *
+ * Note the rhs and solution arrays follow the same contract
+ * as in breeze2d_poisson_solver_init, including single buffer mode,
+ * except the elements outside of inner points are left intact.
+ */
+breeze2d_poisson_solver breeze2d_poisson_solver_init_padded(int mode,
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* bx, real* ex, real* by, real* ey,
+	real* rhs, real* solution, unsigned int ld, unsigned int offset);
+
 /**
  * Release resources used by the specified solver instance.
  * @param desc - The solver configuration
  */
 void breeze2d_poisson_solver_dispose(breeze2d_poisson_solver desc);
 
+/**
+ * Set the variable steps of Y grid (e.g. stretched in boundary
+ * layers), replacing the uniform step hy. Mode-dependent factors
+ * of 3-diagonal systems are computed here, so that solves cost
+ * the same as with uniform grid. Requires solver initialized
+ * with BREEZE2D_POISSON_STRETCHED_Y. Not compatible with gradient
+ * outputs and breeze2d_project.
+ * @param desc - The solver configuration
+ * @param hy - The Y grid steps (n + 1) x 1 array, hy[k] is
+ * the distance between rows k - 1 and k, where rows -1 and n
+ * are the boundaries
+ */
+void breeze2d_poisson_solver_set_grid_y(breeze2d_poisson_solver desc,
+	const real* hy);
+
+/**
+ * Set arrays to output the solution gradient from each
+ * subsequent breeze2d_poisson_solve or breeze2d_poisson_solve_bc,
+ * computed in the same pass as solution: the derivatives are
+ * central differences, taking boundary conditions as the values
+ * beyond the outermost inner points (zero by X). Requires solver
+ * initialized with BREEZE2D_POISSON_GRADIENT. The arrays are
+ * overwritten, while FFT plans are benchmarked.
+ * @param desc - The solver configuration
+ * @param dphidx - The X-derivative m x n array, or NULL
+ * @param dphidy - The Y-derivative m x n array, or NULL
+ */
+void breeze2d_poisson_solver_set_gradient(breeze2d_poisson_solver desc,
+	real* dphidx, real* dphidy);
+
+/**
+ * Get the right hand side and solution arrays
+ * specified in solver configuration.
+ * @param desc - The solver configuration
+ * @param rhs - The right hand side m x n array (filled on exit)
+ * @param solution - The problem solution m x n array (filled on exit)
+ */
+void breeze2d_poisson_solver_get_arrays(breeze2d_poisson_solver desc,
+	real** rhs, real** solution);
+
+/**
+ * Replace the right hand side and solution arrays specified
+ * in solver configuration with other arrays of the same layout,
+ * alignment (modulo 64 bytes, e.g. all allocated with
+ * breeze2d_poisson_malloc) and in-place property. Supported
+ * by BREEZE2D_POISSON_SOLVER_FFT only.
+ * @param desc - The solver configuration
+ * @param rhs - The right hand side m x n array
+ * @param solution - The problem solution m x n array,
+ * or rhs for in-place solve
+ */
+void breeze2d_poisson_solver_set_arrays(breeze2d_poisson_solver desc,
+	real* rhs, real* solution);
+
+/**
+ * Get the problem size of the specified solver.
+ * @param desc - The solver configuration
+ * @param m - The problem X grid dimension, excluding boundaries (filled on exit)
+ * @param n - The problem Y grid dimension, excluding boundaries (filled on exit)
+ */
+void breeze2d_poisson_solver_get_size(breeze2d_poisson_solver desc,
+	unsigned int* m, unsigned int* n);
+
+/**
+ * Get the solver method and option flags the specified solver
+ * was initialized with.
+ * @param desc - The solver configuration
+ * @return The solver mode
+ */
+int breeze2d_poisson_solver_get_mode(breeze2d_poisson_solver desc);
+
+/**
+ * Get statistics of solve stages, accumulated since init or the
+ * last reset, of FFT solver initialized with BREEZE2D_POISSON_COUNTERS
+ * option flag.
+ * @param desc - The solver configuration
+ * @param stats - The statistics (filled on exit)
+ */
+void breeze2d_poisson_solver_get_stats(breeze2d_poisson_solver desc,
+	breeze2d_poisson_stats* stats);
+
+/**
+ * Reset statistics of solve stages.
+ * @param desc - The solver configuration
+ */
+void breeze2d_poisson_solver_reset_stats(breeze2d_poisson_solver desc);
+
+/**
+ * Set the obstacles mask of solver initialized with
+ * BREEZE2D_POISSON_SOLVER_CAPACITANCE mode. The solution is
+ * zero in obstacles, and the right hand side there is ignored.
+ * The capacitance matrix of obstacle points adjacent to the
+ * rest of domain is computed and LU-factorized here (one fast
+ * solve per such point), so that each subsequent solve costs two
+ * FFT solves and a small dense solve. The solution array is
+ * overwritten, and so is the rhs array, used as scratch by
+ * these solves (on the dense path, with many such points, it
+ * holds the unit sources): set the right hand side after the mask.
+ * If the matrix cannot be allocated or is singular, the error
+ * is reported and solves are refused until the mask is set again.
+ * @param desc - The solver configuration
+ * @param mask - The m x n array, nonzero in obstacle points
+ */
+void breeze2d_poisson_solver_set_mask(breeze2d_poisson_solver desc,
+	const int* mask);
+
 /**
  * Solve 2D Poisson equation with the given right hand side.
  * Place result to the output array specified in solver
- * configuration.
+ * configuration. The right hand side array is destroyed,
+ * or replaced by the solution in single buffer mode.
  * @param desc - The solver configuration
  */
 void breeze2d_poisson_solve(breeze2d_poisson_solver desc);
 
+/**
+ * Solve 2D Poisson equation with the same right hand side
+ * as in the previous solve, and updated boundary conditions
+ * (by and ey). Only boundary conditions are transformed,
+ * followed by shutter and inverse transform. Requires solver
+ * initialized with BREEZE2D_POISSON_CACHE_RHS, and at least
+ * one preceding breeze2d_poisson_solve.
+ * @param desc - The solver configuration
+ */
+void breeze2d_poisson_solve_bc(breeze2d_poisson_solver desc);
+
+/**
+ * Solve 2D Poisson equation with the right hand side being zero
+ * except the specified point sources (e.g. emitters), and the
+ * boundary conditions specified in solver configuration. Place
+ * result to the output array specified in solver configuration.
+ * Sine transforms of point sources are evaluated directly,
+ * skipping the forward transform of right hand side, and using
+ * the factorization made at init, if solver is initialized with
+ * BREEZE2D_POISSON_SPARSE. For a large number of sources, or with
+ * gradient outputs set, the right hand side array is filled, and
+ * solved as in breeze2d_poisson_solve. Sources at the same
+ * point are summed up.
+ * @param desc - The solver configuration
+ * @param nsources - The number of point sources
+ * @param is - The X indexes of point sources, 0 .. m - 1
+ * @param js - The Y indexes of point sources, 0 .. n - 1
+ * @param q - The right hand side values in point sources
+ */
+void breeze2d_poisson_solve_sparse(breeze2d_poisson_solver desc,
+	int nsources, const int* is, const int* js, const real* q);
+
+/**
+ * Transform the specified m x n field into the solver spectral
+ * space: unnormalized sine transform by X of each row (FFTW
+ * RODFT00 convention). Fields kept in spectral space between
+ * operations avoid redundant transforms.
+ * Arrays must have the same alignment as the solver rhs and
+ * solution (e.g. all allocated with breeze2d_poisson_malloc), and
+ * be the same array, if and only if the solver works in single
+ * buffer mode.
+ * @param desc - The solver configuration
+ * @param field - The physical space field (destroyed)
+ * @param spectral - The spectral space field (filled on exit)
+ */
+void breeze2d_poisson_forward(breeze2d_poisson_solver desc,
+	real* field, real* spectral);
+
+/**
+ * Solve 2D Poisson equation with the given right hand side
+ * in spectral space: no transforms of m x n arrays are performed.
+ * Boundary conditions are taken from the arrays specified
+ * in solver configuration. With BREEZE2D_POISSON_COMPACT4, the
+ * right hand side is assumed to vanish beyond X boundaries.
+ * @param desc - The solver configuration
+ * @param spectral_rhs - The spectral space right hand side (destroyed)
+ * @param spectral_solution - The spectral space solution
+ * (filled on exit), may be the same array as spectral_rhs
+ */
+void breeze2d_poisson_solve_spectral(breeze2d_poisson_solver desc,
+	real* spectral_rhs, real* spectral_solution);
+
+/**
+ * Transform the specified m x n spectral space field back into
+ * physical space, including normalization of inverse transform.
+ * Arrays follow the same rules as in breeze2d_poisson_forward.
+ * @param desc - The solver configuration
+ * @param spectral - The spectral space field (destroyed)
+ * @param field - The physical space field (filled on exit)
+ */
+void breeze2d_poisson_inverse(breeze2d_poisson_solver desc,
+	real* spectral, real* field);
+
+/**
+ * Defines placement flag for data arrays: touch pages first
+ * in parallel, by the same threads (and thus on the same NUMA
+ * nodes) as will process the corresponding grid rows
+ * in the solver fft passes. The shutter splits modes (columns)
+ * between threads instead, so placement only helps the fft passes.
+ */
+#define BREEZE2D_MALLOC_FIRST_TOUCH		1
+
+/**
+ * Defines placement flag for data arrays: back pages
+ * with transparent huge pages.
+ */
+#define BREEZE2D_MALLOC_HUGE_TRANSPARENT	2
+
+/**
+ * Defines placement flag for data arrays: back pages with
+ * explicit 2 MB huge pages (from vm.nr_hugepages pool),
+ * falling back to transparent huge pages, if unavailable.
+ */
+#define BREEZE2D_MALLOC_HUGE_EXPLICIT		4
+
+/**
+ * Allocate m x n data array (right hand side or solution)
+ * aligned and placed for the solver according to the
+ * specified BREEZE2D_MALLOC_* flags.
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param flags - The placement flags
+ * @return The data array.
+ */
+real* breeze2d_poisson_malloc(unsigned int m, unsigned int n, int flags);
+
+/**
+ * Get the placement flags in effect for the data array,
+ * e.g. without BREEZE2D_MALLOC_HUGE_EXPLICIT, if system
+ * has no huge pages available.
+ * @param array - The data array allocated with breeze2d_poisson_malloc
+ * @return The placement flags.
+ */
+int breeze2d_poisson_malloc_flags(real* array);
+
+/**
+ * Report the placement of m x n data array memory pages
+ * on NUMA nodes.
+ * @param array - The data array
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param npages - The numbers of pages on each node (filled on exit)
+ * @param maxnodes - The maximum number of nodes to report
+ * @return The number of nodes holding array pages, or -1,
+ * if system does not support placement query.
+ */
+int breeze2d_poisson_placement(real* array,
+	unsigned int m, unsigned int n, long* npages, int maxnodes);
+
+/**
+ * Release data array allocated with breeze2d_poisson_malloc.
+ * @param array - The data array
+ */
+void breeze2d_poisson_free(real* array);
+
 /**
  * Count the number of floating-point operations
  * used by the specified solver configuration.
@@ -0,0 +1,53 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BREEZE2D_PROJECT_H
+#define BREEZE2D_PROJECT_H
+
+#ifndef BREEZE2D_H
+#error Please always include <breeze2d.h>, and never include other BREEZE2D headers
+#endif
+
+/**
+ * Project the velocity field onto divergence-free fields
+ * (pressure projection), using the specified Poisson solver.
+ * Velocities are staggered (C-grid): the solver m x n grid
+ * points are cell centers, u is given on cell X faces, v is
+ * given on cell Y faces. The divergence is written directly into
+ * the solver right hand side, and the potential gradient is
+ * subtracted from velocities in a single pass over solution.
+ * The potential beyond the domain is zero by X, and given
+ * by the solver boundary conditions by and ey by Y (normally
+ * zero as well). The discrete divergence of the result is zero
+ * to the solver precision.
+ * Note this is an open boundary projection: with Dirichlet
+ * potential, the boundary faces u[j * (m + 1)], u[j * (m + 1) + m],
+ * v[i] and v[n * m + i] are corrected as well, so the flux through
+ * the domain boundary is not kept. Solid walls need Neumann
+ * potential, which the FFT solver does not support.
+ * @param desc - The solver configuration
+ * @param u - The X velocity (m + 1) x n array, u[j * (m + 1) + i]
+ * is the face between cells i - 1 and i of row j (updated on exit)
+ * @param v - The Y velocity m x (n + 1) array, v[j * m + i]
+ * is the face between cells i of rows j - 1 and j (updated on exit)
+ */
+void breeze2d_project(breeze2d_poisson_solver desc, real* u, real* v);
+
+#endif // BREEZE2D_PROJECT_H
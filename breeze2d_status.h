@@ -28,6 +28,18 @@
 
 #define BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD	10
 #define BREEZE2D_FFT_PLAN_CREATION_FAILED		11
+#define BREEZE2D_INSUFFICIENT_WORKSPACE			12
+#define BREEZE2D_INCOMPATIBLE_ARRAYS			13
+#define BREEZE2D_RHS_NOT_CACHED				14
+#define BREEZE2D_GRADIENT_NOT_ENABLED			15
+#define BREEZE2D_CAPACITANCE_SINGULAR			16
+#define BREEZE2D_UNDEFINED_ELLIPTIC_SOLVER_METHOD	17
+#define BREEZE2D_STRETCHED_Y_NOT_ENABLED		18
+#define BREEZE2D_INCOMPATIBLE_OPTIONS			19
+#define BREEZE2D_UNSUPPORTED_ASPECT_RATIO		20
+#define BREEZE2D_THREAD_CREATION_FAILED			21
+#define BREEZE2D_IO_FAILED				22
+#define BREEZE2D_OUT_OF_MEMORY				23
 
 #endif // BREEZE2D_STATUS_H
 
@@ -53,5 +53,63 @@ double breeze2d_get_time_diff(
 void breeze2d_print_time_diff(
 	struct timespec t1, struct timespec t2);
 
+// Hardware events counted by breeze2d_counters_open.
+#define BREEZE2D_COUNTER_CYCLES			1
+#define BREEZE2D_COUNTER_INSTRUCTIONS		2
+#define BREEZE2D_COUNTER_LLC_LOAD_MISSES	4
+#define BREEZE2D_COUNTER_LLC_STORE_MISSES	8
+
+// Defines the built-in timer value and hardware event counts,
+// summed over all threads of the process. Events not flagged
+// in available are not counted (zero).
+typedef struct
+{
+	double time;
+	long long cycles, instructions;
+	long long llc_load_misses, llc_store_misses;
+	unsigned int available;
+}
+breeze2d_counters;
+
+// Defines metrics derived from counters of a code region:
+// instructions per cycle, and memory traffic estimated from
+// last level cache misses (a cache line each), in bytes per
+// grid point, in bytes per second, and as a fraction of STREAM
+// bandwidth. Metrics of events not counted are zero.
+typedef struct
+{
+	double ipc, bytes_per_point, bandwidth, stream_fraction;
+}
+breeze2d_counter_metrics;
+
+// Open hardware counters of all threads of the process, and of
+// threads created afterwards, from the next read on (threads of
+// the caller OpenMP team are started first). Calls are reference
+// counted.
+// Return the counted events, zero if counters are not supported
+// or not permitted, so that only time is measured.
+unsigned int breeze2d_counters_open();
+
+// Close hardware counters, once closed by all openers.
+void breeze2d_counters_close();
+
+// Read the built-in timer and hardware counters,
+// opening counters of threads created since the previous read.
+void breeze2d_counters_read(breeze2d_counters* counters);
+
+// Add counts between start and finish to sum.
+void breeze2d_counters_accumulate(breeze2d_counters* sum,
+	const breeze2d_counters* start, const breeze2d_counters* finish);
+
+// Derive metrics from counters of a code region,
+// which processed npoints grid points.
+void breeze2d_counters_get_metrics(const breeze2d_counters* counters,
+	double npoints, breeze2d_counter_metrics* metrics);
+
+// Get memory bandwidth in bytes per second, measured once with
+// STREAM triad, or set in BREEZE2D_STREAM_BANDWIDTH environment
+// variable (GB/s).
+double breeze2d_stream_bandwidth();
+
 #endif // BREEZE2D_TIMING_H
 
@@ -0,0 +1,222 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <breeze2d.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+
+// Defines asynchronous solve request.
+struct breeze2d_poisson_request_t
+{
+	breeze2d_poisson_solver solver;
+	int done;
+
+	// The next request in the pool queue.
+	struct breeze2d_poisson_request_t* next;
+};
+
+// Defines the internal solver thread pool: queue of submitted
+// requests, and solvers being solved by each thread, so that
+// requests of the same solver are never run concurrently.
+// All fields are guarded by mutex, changed is signaled on
+// submission, completion and finalization.
+static struct
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t changed;
+	struct breeze2d_poisson_request_t *head, *tail;
+	int nthreads, nstarted, stopping;
+	pthread_t* threads;
+	breeze2d_poisson_solver* busy;
+}
+pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+	NULL, NULL, 2, 0, 0, NULL, NULL };
+
+// Check if the specified solver is being solved by pool thread.
+static int is_busy(breeze2d_poisson_solver solver)
+{
+	for (int i = 0; i < pool.nstarted; i++)
+		if (pool.busy[i] == solver) return 1;
+	return 0;
+}
+
+// Take the first queued request of a solver not being solved,
+// or return NULL.
+static struct breeze2d_poisson_request_t* take_request()
+{
+	struct breeze2d_poisson_request_t *request = pool.head, *prev = NULL;
+	for ( ; request; prev = request, request = request->next)
+	{
+		if (is_busy(request->solver)) continue;
+
+		if (prev) prev->next = request->next;
+		else pool.head = request->next;
+		if (pool.tail == request) pool.tail = prev;
+		return request;
+	}
+	return NULL;
+}
+
+// Perform queued solves, until the pool is finalized
+// and the queue is empty.
+static void* worker(void* arg)
+{
+	int index = (int)(size_t)arg;
+
+	pthread_mutex_lock(&pool.mutex);
+	for ( ; ; )
+	{
+		struct breeze2d_poisson_request_t* request = take_request();
+		if (!request)
+		{
+			if (pool.stopping && !pool.head) break;
+			pthread_cond_wait(&pool.changed, &pool.mutex);
+			continue;
+		}
+
+		pool.busy[index] = request->solver;
+		pthread_mutex_unlock(&pool.mutex);
+
+		breeze2d_poisson_solve(request->solver);
+
+		pthread_mutex_lock(&pool.mutex);
+		pool.busy[index] = NULL;
+		request->done = 1;
+
+		// Wake up waiters, and workers skipping the
+		// next requests of this solver.
+		pthread_cond_broadcast(&pool.changed);
+	}
+	pthread_mutex_unlock(&pool.mutex);
+
+	return NULL;
+}
+
+// Start pool threads up to the requested number.
+// Called with mutex locked.
+static void start_threads()
+{
+	if (pool.nstarted >= pool.nthreads) return;
+
+	breeze2d_poisson_solver* busy = (breeze2d_poisson_solver*)realloc(
+		pool.busy, sizeof(breeze2d_poisson_solver) * pool.nthreads);
+	if (!busy) return;
+	pool.busy = busy;
+	pthread_t* threads = (pthread_t*)realloc(
+		pool.threads, sizeof(pthread_t) * pool.nthreads);
+	if (!threads) return;
+	pool.threads = threads;
+
+	while (pool.nstarted < pool.nthreads)
+	{
+		pool.busy[pool.nstarted] = NULL;
+		if (pthread_create(&pool.threads[pool.nstarted], NULL,
+			worker, (void*)(size_t)pool.nstarted))
+			break;
+		pool.nstarted++;
+	}
+}
+
+// Start solving 2D Poisson equation with the given right hand
+// side on the internal solver thread pool.
+breeze2d_poisson_request breeze2d_poisson_solve_async(
+	breeze2d_poisson_solver desc)
+{
+	struct breeze2d_poisson_request_t* request =
+		(struct breeze2d_poisson_request_t*)malloc(
+			sizeof(struct breeze2d_poisson_request_t));
+	request->solver = desc;
+	request->done = 0;
+	request->next = NULL;
+
+	pthread_mutex_lock(&pool.mutex);
+	start_threads();
+	if (pool.tail) pool.tail->next = request;
+	else pool.head = request;
+	pool.tail = request;
+	pthread_cond_broadcast(&pool.changed);
+	pthread_mutex_unlock(&pool.mutex);
+
+	return (breeze2d_poisson_request)request;
+}
+
+// Wait for the asynchronous solve to complete, and
+// release the request handle.
+void breeze2d_poisson_wait(breeze2d_poisson_request handle)
+{
+	struct breeze2d_poisson_request_t* request =
+		(struct breeze2d_poisson_request_t*)handle;
+
+	pthread_mutex_lock(&pool.mutex);
+	while (!request->done)
+		pthread_cond_wait(&pool.changed, &pool.mutex);
+	pthread_mutex_unlock(&pool.mutex);
+
+	free(request);
+}
+
+// Check if the asynchronous solve is completed, without
+// waiting. The request handle is released by wait only.
+int breeze2d_poisson_test(breeze2d_poisson_request handle)
+{
+	struct breeze2d_poisson_request_t* request =
+		(struct breeze2d_poisson_request_t*)handle;
+
+	pthread_mutex_lock(&pool.mutex);
+	int done = request->done;
+	pthread_mutex_unlock(&pool.mutex);
+
+	return done;
+}
+
+// Set the number of threads of the internal solver
+// thread pool.
+void breeze2d_poisson_async_set_nthreads(int nthreads)
+{
+	pthread_mutex_lock(&pool.mutex);
+	if (nthreads > pool.nthreads)
+		pool.nthreads = nthreads;
+	if (pool.nstarted)
+		start_threads();
+	pthread_mutex_unlock(&pool.mutex);
+}
+
+// Complete the submitted solves, and stop the internal
+// solver thread pool threads.
+void breeze2d_poisson_async_finalize()
+{
+	pthread_mutex_lock(&pool.mutex);
+	pool.stopping = 1;
+	pthread_cond_broadcast(&pool.changed);
+	int nstarted = pool.nstarted;
+	pthread_mutex_unlock(&pool.mutex);
+
+	for (int i = 0; i < nstarted; i++)
+		pthread_join(pool.threads[i], NULL);
+
+	pthread_mutex_lock(&pool.mutex);
+	free(pool.threads);
+	free(pool.busy);
+	pool.threads = NULL;
+	pool.busy = NULL;
+	pool.nstarted = 0;
+	pool.stopping = 0;
+	pthread_mutex_unlock(&pool.mutex);
+}
@@ -0,0 +1,326 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "capacitance.h"
+#include "../fft/fft.h"
+#include "../parallel.h"
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+// LAPACK LU factorization and solve.
+#ifdef HAVE_SINGLE
+#define getrf_ sgetrf_
+#define getrs_ sgetrs_
+#endif
+#ifdef HAVE_DOUBLE
+#define getrf_ dgetrf_
+#define getrs_ dgetrs_
+#endif
+
+void getrf_(int* m, int* n, real* a, int* lda, int* ipiv, int* info);
+void getrs_(char* trans, int* n, int* nrhs, real* a, int* lda,
+	int* ipiv, real* b, int* ldb, int* info);
+
+// Defines internal structure for capacitance matrix solver.
+struct poisson2d_capacitance_solver_t
+{
+	unsigned int m, n;
+	
+	// Arrays for problem right hand side, solution
+	// and boundary conditions by Y.
+	real *rhs, *solution;
+	real *by, *ey;
+
+	// FFT solver on the entire rectangle,
+	// and its boundary conditions.
+	poisson2d_fft_solver fft;
+	real *fby, *fey;
+
+	// Indexes of obstacle points.
+	int nobstacles;
+	int* obstacles;
+
+	// Obstacle points having neighbours outside of obstacles,
+	// their LU-factorized capacitance matrix, sources
+	// and the first solve result.
+	int nk;
+	int *ki, *kj;
+	real* capacitance;
+	int* ipiv;
+	real *w, *u0;
+
+	// Status of the last mask setting: solves are refused,
+	// if the mask data could not be allocated or factorized.
+	int status;
+};
+
+// Initialize 2D Poisson equation capacitance matrix solver
+// for the specified problem size and data arrays.
+poisson2d_capacitance_solver poisson2d_capacitance_solver_init(
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* bx, real* ex, real* by, real* ey,
+	real* rhs, real* solution)
+{
+	struct poisson2d_capacitance_solver_t* solver =
+		(struct poisson2d_capacitance_solver_t*)malloc(
+			sizeof(struct poisson2d_capacitance_solver_t));
+	if (!solver)
+	{
+		breeze2d_set_error(BREEZE2D_OUT_OF_MEMORY);
+		return NULL;
+	}
+	memset(solver, 0, sizeof(struct poisson2d_capacitance_solver_t));
+	solver->m = m; solver->n = n;
+	solver->rhs = rhs; solver->solution = solution;
+	solver->by = by; solver->ey = ey;
+
+	// The FFT solver boundary conditions are switched between
+	// the given ones and zero ones, so they are kept separately.
+	solver->fby = (real*)malloc(sizeof(real) * m);
+	solver->fey = (real*)malloc(sizeof(real) * m);
+	if (!solver->fby || !solver->fey)
+	{
+		free(solver->fby); free(solver->fey);
+		free(solver);
+		breeze2d_set_error(BREEZE2D_OUT_OF_MEMORY);
+		return NULL;
+	}
+
+	// Capacitance matrix columns are computed with sparse solves.
+	solver->fft = poisson2d_fft_solver_init(
+		m, n, hx, hy, bx, ex, solver->fby, solver->fey,
+		rhs, solution, m, BREEZE2D_POISSON_SPARSE);
+	if (!solver->fft)
+	{
+		free(solver->fby); free(solver->fey);
+		free(solver);
+		return NULL;
+	}
+	
+	return (poisson2d_capacitance_solver)solver;
+}
+
+// Release capacitance matrix data.
+static void release_mask(struct poisson2d_capacitance_solver_t* solver)
+{
+	free(solver->obstacles);
+	free(solver->ki); free(solver->kj);
+	free(solver->capacitance);
+	free(solver->ipiv);
+	free(solver->w);
+	free(solver->u0);
+	solver->nobstacles = 0; solver->obstacles = NULL;
+	solver->nk = 0; solver->ki = NULL; solver->kj = NULL;
+	solver->capacitance = NULL; solver->ipiv = NULL;
+	solver->w = NULL; solver->u0 = NULL;
+	solver->status = 0;
+}
+
+// Release the partially allocated capacitance matrix data,
+// and refuse solves until the mask is set again.
+static void mask_alloc_failed(struct poisson2d_capacitance_solver_t* solver)
+{
+	release_mask(solver);
+	solver->status = BREEZE2D_OUT_OF_MEMORY;
+	breeze2d_set_error(BREEZE2D_OUT_OF_MEMORY);
+}
+
+// Check the obstacle point has neighbours outside of obstacles.
+static int is_boundary(const int* mask, int m, int n, int i, int j)
+{
+	return ((i > 0) && !mask[i - 1 + j * m]) ||
+		((i < m - 1) && !mask[i + 1 + j * m]) ||
+		((j > 0) && !mask[i + (j - 1) * m]) ||
+		((j < n - 1) && !mask[i + (j + 1) * m]);
+}
+
+// Set the obstacles mask and factorize the capacitance
+// matrix of obstacles boundary points.
+void poisson2d_capacitance_solver_set_mask(
+	poisson2d_capacitance_solver desc, const int* mask)
+{
+	struct poisson2d_capacitance_solver_t* solver =
+		(struct poisson2d_capacitance_solver_t*)desc;
+
+	release_mask(solver);
+
+	int m = solver->m, n = solver->n;
+
+	// Collect obstacle points, and those of them, which
+	// have neighbours outside of obstacles: only they
+	// are present in equations outside of obstacles.
+	int nobstacles = 0, nk = 0;
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			if (!mask[i + j * m]) continue;
+			nobstacles++;
+			if (is_boundary(mask, m, n, i, j)) nk++;
+		}
+	if (!nobstacles) return;
+
+	solver->nobstacles = nobstacles;
+	solver->obstacles = (int*)malloc(sizeof(int) * nobstacles);
+	solver->nk = nk;
+	solver->ki = (int*)malloc(sizeof(int) * nk);
+	solver->kj = (int*)malloc(sizeof(int) * nk);
+	if (!solver->obstacles || (nk && (!solver->ki || !solver->kj)))
+	{
+		mask_alloc_failed(solver);
+		return;
+	}
+	for (int j = 0, iobstacle = 0, k = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			if (!mask[i + j * m]) continue;
+			solver->obstacles[iobstacle++] = i + j * m;
+			if (is_boundary(mask, m, n, i, j))
+			{
+				solver->ki[k] = i; solver->kj[k] = j;
+				k++;
+			}
+		}
+	if (!nk) return;
+
+	solver->capacitance = (real*)malloc(sizeof(real) * nk * nk);
+	solver->ipiv = (int*)malloc(sizeof(int) * nk);
+	solver->w = (real*)malloc(sizeof(real) * nk);
+	solver->u0 = (real*)malloc(sizeof(real) * m * n);
+	if (!solver->capacitance || !solver->ipiv || !solver->w || !solver->u0)
+	{
+		mask_alloc_failed(solver);
+		return;
+	}
+
+	// Column k of capacitance matrix is the response in
+	// obstacle boundary points to the unit source in point k,
+	// with zero boundary conditions.
+	memset(solver->fby, 0, sizeof(real) * m);
+	memset(solver->fey, 0, sizeof(real) * m);
+	real unit = 1.0;
+	for (int k = 0; k < nk; k++)
+	{
+		poisson2d_fft_solve_sparse(solver->fft, 1,
+			solver->ki + k, solver->kj + k, &unit);
+		real* column = solver->capacitance + k * nk;
+		for (int l = 0; l < nk; l++)
+			column[l] = solver->solution[solver->ki[l] + solver->kj[l] * m];
+	}
+
+	int info;
+	getrf_(&nk, &nk, solver->capacitance, &nk, solver->ipiv, &info);
+	if (info)
+	{
+		solver->status = BREEZE2D_CAPACITANCE_SINGULAR;
+		breeze2d_set_error(BREEZE2D_CAPACITANCE_SINGULAR);
+	}
+}
+
+// Release resources used by the specified
+// capacitance matrix solver instance.
+void poisson2d_capacitance_solver_dispose(
+	poisson2d_capacitance_solver desc)
+{
+	struct poisson2d_capacitance_solver_t* solver =
+		(struct poisson2d_capacitance_solver_t*)desc;
+
+	poisson2d_fft_solver_dispose(solver->fft);
+	release_mask(solver);
+	free(solver->fby); free(solver->fey);
+	free(solver);
+}
+
+// Arguments of the first solve result addition.
+struct add_args_t
+{
+	real* solution;
+	const real* u0;
+};
+
+// Add the first solve result in the specified range of points.
+static void add_part(void* arg, int part, long begin, long end)
+{
+	struct add_args_t* args = (struct add_args_t*)arg;
+	for (long i = begin; i < end; i++)
+		args->solution[i] += args->u0[i];
+}
+
+// Solve 2D Poisson equation with the given right hand side
+// outside of obstacles, and zero solution in obstacles.
+// The rectangle solution u0 for the right hand side zeroed
+// in obstacles is corrected by sources w in obstacle
+// boundary points, such that solution is zero there:
+// C w = -u0, where C is the capacitance matrix.
+void poisson2d_capacitance_solve(poisson2d_capacitance_solver desc)
+{
+	struct poisson2d_capacitance_solver_t* solver =
+		(struct poisson2d_capacitance_solver_t*)desc;
+
+	if (solver->status)
+	{
+		breeze2d_set_error(solver->status);
+		return;
+	}
+
+	int m = solver->m, n = solver->n, nk = solver->nk;
+	real *rhs = solver->rhs, *solution = solver->solution;
+
+	memcpy(solver->fby, solver->by, sizeof(real) * m);
+	memcpy(solver->fey, solver->ey, sizeof(real) * m);
+
+	int* obstacles = solver->obstacles;
+	for (int i = 0; i < solver->nobstacles; i++)
+		rhs[obstacles[i]] = 0.0;
+
+	poisson2d_fft_solve(solver->fft);
+
+	if (!nk)
+	{
+		for (int i = 0; i < solver->nobstacles; i++)
+			solution[obstacles[i]] = 0.0;
+		return;
+	}
+
+	real* w = solver->w;
+	for (int k = 0; k < nk; k++)
+		w[k] = -solution[solver->ki[k] + solver->kj[k] * m];
+
+	char trans = 'N';
+	int nrhs = 1, info;
+	getrs_(&trans, &nk, &nrhs, solver->capacitance, &nk,
+		solver->ipiv, w, &nk, &info);
+
+	// The correction has zero boundary conditions.
+	real* u0 = solver->u0;
+	memcpy(u0, solution, sizeof(real) * m * n);
+	memset(solver->fby, 0, sizeof(real) * m);
+	memset(solver->fey, 0, sizeof(real) * m);
+
+	poisson2d_fft_solve_sparse(solver->fft, nk,
+		solver->ki, solver->kj, w);
+
+	struct add_args_t args = { solution, u0 };
+	poisson2d_parallel_for(poisson2d_parallel_nthreads(),
+		(long)m * n, add_part, &args);
+	for (int i = 0; i < solver->nobstacles; i++)
+		solution[obstacles[i]] = 0.0;
+}
@@ -0,0 +1,81 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CAPACITANCE_H
+#define CAPACITANCE_H
+
+#include <breeze2d.h>
+
+/**
+ * The 2D Poisson euqation capacitance matrix solver descriptor.
+ */
+typedef void* poisson2d_capacitance_solver;
+
+/**
+ * Initialize 2D Poisson equation capacitance matrix solver for
+ * the specified problem size and data arrays. Until obstacles
+ * mask is set, the solver domain is the entire rectangle.
+ * Note m and n are the numbers of INNER grid points,
+ * i.e. including boundaries the total number is + 2.
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param hx - The problem X grid step
+ * @param hy - The problem Y grid step
+ * @param bx - The X left side boundary m x 1 array
+ * @param ex - The X right side boundary m x 1 array
+ * @param by - The Y lower side boundary n x 1 array
+ * @param ey - The Y upper side boundary n x 1 array
+ * @param rhs - The right hand side m x n array
+ * @param solution - The problem solution m x n array,
+ * or rhs for in-place solve
+ * @return The solver configuration.
+ */
+poisson2d_capacitance_solver poisson2d_capacitance_solver_init(
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* bx, real* ex, real* by, real* ey,
+	real* rhs, real* solution);
+
+/**
+ * Set the obstacles mask and factorize the capacitance matrix
+ * of obstacles boundary points. Solution is zero in obstacles.
+ * The rhs and solution arrays are overwritten.
+ * @param desc - The solver configuration
+ * @param mask - The m x n array, nonzero in obstacle points
+ */
+void poisson2d_capacitance_solver_set_mask(
+	poisson2d_capacitance_solver desc, const int* mask);
+
+/**
+ * Release resources used by the specified capacitance
+ * matrix solver instance.
+ * @param desc - The solver configuration
+ */
+void poisson2d_capacitance_solver_dispose(
+	poisson2d_capacitance_solver desc);
+
+/**
+ * Solve 2D Poisson equation with the given right hand side
+ * outside of obstacles, using two FFT solves on the entire
+ * rectangle and the capacitance matrix solve.
+ * @param desc - The solver configuration
+ */
+void poisson2d_capacitance_solve(poisson2d_capacitance_solver desc);
+
+#endif // CAPACITANCE_H
@@ -0,0 +1,138 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.h>
+#include <malloc.h>
+#include <string.h>
+
+#include "fft/wrapper.h"
+#include "parallel.h"
+#include "pcg/pcg.h"
+
+// Initialize iterative solver of 2D elliptic equation
+// div(k grad phi) = f, preconditioned by 2D Poisson
+// equation solver.
+breeze2d_elliptic_solver breeze2d_elliptic_solver_init(int method,
+	unsigned int m, unsigned int n, real hx, real hy,
+	const real* kx, const real* ky, breeze2d_poisson_solver precond)
+{
+	int nvectors;
+	switch (method)
+	{
+	case BREEZE2D_ELLIPTIC_PCG :
+		nvectors = 3;
+		break;
+	case BREEZE2D_ELLIPTIC_BICGSTAB :
+		nvectors = 5;
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_ELLIPTIC_SOLVER_METHOD);
+		return NULL;
+	}
+
+	struct poisson2d_elliptic_t* solver =
+		(struct poisson2d_elliptic_t*)malloc(
+			sizeof(struct poisson2d_elliptic_t));
+	solver->method = method;
+	solver->m = m; solver->n = n; solver->hx = hx; solver->hy = hy;
+	solver->kx = kx; solver->ky = ky;
+	solver->precond = precond;
+	breeze2d_poisson_solver_get_arrays(precond,
+		&solver->prhs, &solver->psolution);
+	solver->tolerance = (sizeof(real) == sizeof(float)) ? 1e-5 : 1e-10;
+	solver->maxiters = 100;
+	solver->residual = 0.0;
+	solver->nthreads = 1;
+
+	// All iteration vectors in one block: vectors are placed
+	// for the threads of the same rows, as grid arrays.
+	size_t vsize = FFT_ALIGN(sizeof(real) * m * n);
+	char* vectors = (char*)fft_malloc_placed(
+		vsize * nvectors + FFT_ALIGN(sizeof(real) * m),
+		sizeof(real) * m, FFT_MALLOC_FIRST_TOUCH);
+	solver->r = (real*)vectors;
+	solver->p = (real*)(vectors + vsize);
+	solver->v = (real*)(vectors + 2 * vsize);
+	solver->rhat = NULL; solver->t = NULL;
+	if (method == BREEZE2D_ELLIPTIC_BICGSTAB)
+	{
+		solver->rhat = (real*)(vectors + 3 * vsize);
+		solver->t = (real*)(vectors + 4 * vsize);
+	}
+	solver->zero = (real*)(vectors + nvectors * vsize);
+	memset(solver->zero, 0, sizeof(real) * m);
+
+	return (breeze2d_elliptic_solver)solver;
+}
+
+// Set the convergence criteria.
+void breeze2d_elliptic_solver_set_tolerance(breeze2d_elliptic_solver desc,
+	real tolerance, int maxiters)
+{
+	struct poisson2d_elliptic_t* solver =
+		(struct poisson2d_elliptic_t*)desc;
+
+	solver->tolerance = tolerance;
+	solver->maxiters = maxiters;
+}
+
+// Release resources used by the specified solver instance.
+void breeze2d_elliptic_solver_dispose(breeze2d_elliptic_solver desc)
+{
+	struct poisson2d_elliptic_t* solver =
+		(struct poisson2d_elliptic_t*)desc;
+
+	fft_free_placed(solver->r);
+	free(solver);
+}
+
+// Solve 2D elliptic equation with the given right hand side.
+int breeze2d_elliptic_solve(breeze2d_elliptic_solver desc,
+	const real* f, real* phi)
+{
+	struct poisson2d_elliptic_t* solver =
+		(struct poisson2d_elliptic_t*)desc;
+
+	// Iterate in the calling thread only, if the preconditioner
+	// is serial.
+	solver->nthreads = (breeze2d_poisson_solver_get_mode(solver->precond) &
+		BREEZE2D_POISSON_SERIAL) ? 1 : poisson2d_parallel_nthreads();
+
+	switch (solver->method)
+	{
+	case BREEZE2D_ELLIPTIC_PCG :
+		return poisson2d_pcg(solver, f, phi);
+	case BREEZE2D_ELLIPTIC_BICGSTAB :
+		return poisson2d_bicgstab(solver, f, phi);
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_ELLIPTIC_SOLVER_METHOD);
+	}
+
+	return 0;
+}
+
+// Get the relative residual norm reached by the last solve.
+real breeze2d_elliptic_residual(breeze2d_elliptic_solver desc)
+{
+	struct poisson2d_elliptic_t* solver =
+		(struct poisson2d_elliptic_t*)desc;
+
+	return solver->residual;
+}
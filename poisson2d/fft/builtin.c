@@ -0,0 +1,552 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include "builtin.h"
+#include "../parallel.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Defines the number of rows transformed together, one row
+// per lane of 64-byte vector register.
+#define LANES ((int)(64 / sizeof(real)))
+
+struct fft_builtin_t
+{
+	int n, howmany, nthreads;
+	fft_kind kind;
+
+	// Real FFT length (n + 1 for sine, n - 1 for cosine
+	// transform), complex FFT length (half of real one,
+	// if even), and power of 2 FFT length (the same, or
+	// Bluestein convolution length).
+	int nr, nc, np;
+
+	// Weights of the real sequence: sin(pi j / nr),
+	// and cos(pi j / nr) for cosine transform, j < nr.
+	real *sn, *cs;
+
+	// Twiddles splitting complex FFT into real FFT:
+	// exp(-2 pi i k / nr), k <= nc.
+	real *sre, *sim;
+
+	// Twiddles of power of 2 FFT: exp(-2 pi i k / np),
+	// k < np / 2, and bit-reversal permutation.
+	real *tre, *tim;
+	int* bitrev;
+
+	// Bluestein chirp exp(-pi i j^2 / nc), j < nc, and
+	// transformed convolution kernel of np elements,
+	// or NULL, if nc is power of 2.
+	real *cre, *cim, *kre, *kim;
+
+	// Scratch space of each thread, and its size in reals.
+	real* work;
+	size_t nwork;
+};
+
+static real* alloc_real(size_t count)
+{
+	void* ptr = NULL;
+	if (posix_memalign(&ptr, 64, sizeof(real) * (count ? count : 1)))
+		return NULL;
+	return (real*)ptr;
+}
+
+// Forward power of 2 FFT of np vectors, in place:
+// bit-reversal permutation and radix-2 butterflies,
+// each applied to all lanes.
+static void fft_pow2(const struct fft_builtin_t* f, real* re, real* im)
+{
+	int np = f->np;
+
+	for (int i = 0; i < np; i++)
+	{
+		int j = f->bitrev[i];
+		if (i >= j) continue;
+		real *ri = re + i * LANES, *rj = re + j * LANES;
+		real *ii = im + i * LANES, *ij = im + j * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+		{
+			real t = ri[l]; ri[l] = rj[l]; rj[l] = t;
+			t = ii[l]; ii[l] = ij[l]; ij[l] = t;
+		}
+	}
+
+	for (int s = 2; s <= np; s *= 2)
+	{
+		int half = s / 2, step = np / s;
+		for (int start = 0; start < np; start += s)
+			for (int k = 0; k < half; k++)
+			{
+				real wr = f->tre[k * step], wi = f->tim[k * step];
+				real *ar = re + (start + k) * LANES, *ai = im + (start + k) * LANES;
+				real *br = ar + half * LANES, *bi = ai + half * LANES;
+				#pragma omp simd
+				for (int l = 0; l < LANES; l++)
+				{
+					real tr = br[l] * wr - bi[l] * wi;
+					real ti = br[l] * wi + bi[l] * wr;
+					br[l] = ar[l] - tr; bi[l] = ai[l] - ti;
+					ar[l] += tr; ai[l] += ti;
+				}
+			}
+	}
+}
+
+// Forward complex FFT of nc vectors, in place (buffers
+// must hold np vectors). Lengths other than power of 2 are
+// transformed as convolution with chirp (Bluestein).
+static void fft_complex(const struct fft_builtin_t* f, real* re, real* im)
+{
+	if (!f->cre)
+	{
+		fft_pow2(f, re, im);
+		return;
+	}
+
+	int nc = f->nc, np = f->np;
+
+	for (int j = 0; j < nc; j++)
+	{
+		real cr = f->cre[j], ci = f->cim[j];
+		real *r = re + j * LANES, *i = im + j * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+		{
+			real t = r[l] * cr - i[l] * ci;
+			i[l] = r[l] * ci + i[l] * cr;
+			r[l] = t;
+		}
+	}
+	memset(re + nc * LANES, 0, sizeof(real) * (np - nc) * LANES);
+	memset(im + nc * LANES, 0, sizeof(real) * (np - nc) * LANES);
+
+	fft_pow2(f, re, im);
+
+	// Multiply by transformed kernel, and conjugate
+	// to get inverse transform with forward one.
+	for (int j = 0; j < np; j++)
+	{
+		real kr = f->kre[j], ki = f->kim[j];
+		real *r = re + j * LANES, *i = im + j * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+		{
+			real t = r[l] * kr - i[l] * ki;
+			i[l] = -(r[l] * ki + i[l] * kr);
+			r[l] = t;
+		}
+	}
+
+	fft_pow2(f, re, im);
+
+	real scale = 1.0 / np;
+	for (int j = 0; j < nc; j++)
+	{
+		real cr = f->cre[j] * scale, ci = f->cim[j] * scale;
+		real *r = re + j * LANES, *i = im + j * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+		{
+			real t = r[l] * cr + i[l] * ci;
+			i[l] = r[l] * ci - i[l] * cr;
+			r[l] = t;
+		}
+	}
+}
+
+// Forward real FFT of nr vectors w: spectrum coefficients
+// k <= nr / 2 are stored into (wr, wi). Even length is
+// transformed by complex FFT of half length.
+static void fft_real(const struct fft_builtin_t* f, const real* w,
+	real* zr, real* zi, real* wr, real* wi)
+{
+	int nr = f->nr, nc = f->nc;
+
+	if (nr % 2)
+	{
+		memcpy(zr, w, sizeof(real) * nr * LANES);
+		memset(zi, 0, sizeof(real) * nr * LANES);
+		fft_complex(f, zr, zi);
+		memcpy(wr, zr, sizeof(real) * (nr / 2 + 1) * LANES);
+		memcpy(wi, zi, sizeof(real) * (nr / 2 + 1) * LANES);
+		return;
+	}
+
+	// Even and odd elements as real and imaginary parts.
+	for (int j = 0; j < nc; j++)
+	{
+		const real *we = w + 2 * j * LANES, *wo = we + LANES;
+		real *r = zr + j * LANES, *i = zi + j * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+		{
+			r[l] = we[l];
+			i[l] = wo[l];
+		}
+	}
+
+	fft_complex(f, zr, zi);
+
+	// W(k) = E(k) - i exp(-2 pi i k / nr) O(k), where
+	// E, O = (Z(k) +- conj Z(nc - k)) / 2, Z(nc) = Z(0).
+	for (int k = 0; k <= nc; k++)
+	{
+		int k1 = (k == nc) ? 0 : k, k2 = (k == 0) ? 0 : nc - k;
+		real sr = f->sre[k], si = f->sim[k];
+		const real *ar = zr + k1 * LANES, *ai = zi + k1 * LANES;
+		const real *br = zr + k2 * LANES, *bi = zi + k2 * LANES;
+		real *r = wr + k * LANES, *i = wi + k * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+		{
+			real er = 0.5 * (ar[l] + br[l]), ei = 0.5 * (ai[l] - bi[l]);
+			real odr = 0.5 * (ar[l] - br[l]), odi = 0.5 * (ai[l] + bi[l]);
+			r[l] = er + sr * odi + si * odr;
+			i[l] = ei - sr * odr + si * odi;
+		}
+	}
+}
+
+// Sine transform (FFTW RODFT00) of the block of rows in
+// w, lanes interleaved, y = x(j - 1), j = 1 .. nr - 1:
+// real FFT of w(j) = sin(pi j / nr) (y(j) + y(nr - j)) +
+// (y(j) - y(nr - j)) / 2 gives even coefficients as -Im W(k),
+// and odd ones as recurrence on Re W(k).
+static void sine_block(const struct fft_builtin_t* f, real* w,
+	real* zr, real* zi, real* wr, real* wi)
+{
+	int nr = f->nr;
+
+	memset(w, 0, sizeof(real) * LANES);
+	for (int j = 1; j <= nr / 2; j++)
+	{
+		real s = f->sn[j];
+		real *a = w + j * LANES, *b = w + (nr - j) * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+		{
+			real sum = s * (a[l] + b[l]), diff = 0.5 * (a[l] - b[l]);
+			a[l] = sum + diff;
+			b[l] = sum - diff;
+		}
+	}
+
+	fft_real(f, w, zr, zi, wr, wi);
+
+	// Coefficient m is stored to w(m - 1), and doubled,
+	// as in FFTW.
+	real* odd = zr;
+	#pragma omp simd
+	for (int l = 0; l < LANES; l++)
+	{
+		odd[l] = 0.5 * wr[l];
+		w[l] = 2.0 * odd[l];
+	}
+	for (int k = 1; 2 * k <= nr - 1; k++)
+	{
+		real *even = w + (2 * k - 1) * LANES, *i = wi + k * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+			even[l] = -2.0 * i[l];
+		if (2 * k + 1 > nr - 1) break;
+		real *next = w + 2 * k * LANES, *r = wr + k * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+		{
+			odd[l] += r[l];
+			next[l] = 2.0 * odd[l];
+		}
+	}
+}
+
+// Cosine transform (FFTW REDFT00) of the block of rows in
+// w, lanes interleaved, x(j), j = 0 .. nr: real FFT of
+// w(j) = (x(j) + x(nr - j)) / 2 - sin(pi j / nr) (x(j) - x(nr - j))
+// gives even coefficients as 2 Re W(k), and odd ones as
+// recurrence on Im W(k), starting from the directly
+// evaluated first one.
+static void cosine_block(const struct fft_builtin_t* f, real* w,
+	real* zr, real* zi, real* wr, real* wi)
+{
+	int nr = f->nr;
+
+	// First coefficient.
+	real* first = zi;
+	{
+		real *x0 = w, *xn = w + nr * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+			first[l] = x0[l] - xn[l];
+	}
+	for (int j = 1; j < nr; j++)
+	{
+		real c = 2.0 * f->cs[j], *x = w + j * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+			first[l] += c * x[l];
+	}
+	real* odd = wr + (nr / 2 + 1) * LANES;
+	memcpy(odd, first, sizeof(real) * LANES);
+
+	{
+		real *x0 = w, *xn = w + nr * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+			x0[l] = 0.5 * (x0[l] + xn[l]);
+	}
+	for (int j = 1; j <= nr / 2; j++)
+	{
+		real s = f->sn[j];
+		real *a = w + j * LANES, *b = w + (nr - j) * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+		{
+			real sum = 0.5 * (a[l] + b[l]), diff = s * (a[l] - b[l]);
+			a[l] = sum - diff;
+			b[l] = sum + diff;
+		}
+	}
+
+	fft_real(f, w, zr, zi, wr, wi);
+
+	for (int k = 0; 2 * k <= nr; k++)
+	{
+		real *even = w + 2 * k * LANES, *r = wr + k * LANES;
+		#pragma omp simd
+		for (int l = 0; l < LANES; l++)
+			even[l] = 2.0 * r[l];
+		if (2 * k + 1 > nr) break;
+		real *next = w + (2 * k + 1) * LANES, *i = wi + k * LANES;
+		if (k)
+		{
+			#pragma omp simd
+			for (int l = 0; l < LANES; l++)
+				odd[l] -= 2.0 * i[l];
+		}
+		memcpy(next, odd, sizeof(real) * LANES);
+	}
+}
+
+// Create batched transform of howmany rows of n elements,
+// using at most nthreads threads.
+struct fft_builtin_t* fft_builtin_create(int n, int howmany,
+	fft_kind kind, int nthreads)
+{
+	// Cosine transform needs both end points.
+	if ((n < 1) || ((kind == FFT_REDFT00) && (n < 2))) return NULL;
+
+	struct fft_builtin_t* f = (struct fft_builtin_t*)calloc(1,
+		sizeof(struct fft_builtin_t));
+	if (!f) return NULL;
+	f->n = n; f->howmany = howmany; f->kind = kind;
+	f->nthreads = (nthreads > 0) ? nthreads : 1;
+	f->nr = (kind == FFT_RODFT00) ? n + 1 : n - 1;
+	f->nc = (f->nr % 2) ? f->nr : f->nr / 2;
+	int nc = f->nc, nr = f->nr;
+	int pow2 = !(nc & (nc - 1));
+	for (f->np = 1; f->np < (pow2 ? nc : 2 * nc - 1); f->np *= 2)
+		continue;
+	int np = f->np;
+
+	f->sn = alloc_real(nr);
+	f->cs = alloc_real(nr);
+	f->sre = alloc_real(nc + 1);
+	f->sim = alloc_real(nc + 1);
+	f->tre = alloc_real(np / 2 + 1);
+	f->tim = alloc_real(np / 2 + 1);
+	f->bitrev = (int*)malloc(sizeof(int) * np);
+	if (!f->sn || !f->cs || !f->sre || !f->sim ||
+		!f->tre || !f->tim || !f->bitrev)
+	{
+		fft_builtin_dispose(f);
+		return NULL;
+	}
+
+	for (int j = 0; j < nr; j++)
+	{
+		f->sn[j] = sin(M_PI * j / nr);
+		f->cs[j] = cos(M_PI * j / nr);
+	}
+	for (int k = 0; k <= nc; k++)
+	{
+		f->sre[k] = cos(2.0 * M_PI * k / nr);
+		f->sim[k] = -sin(2.0 * M_PI * k / nr);
+	}
+	for (int k = 0; k <= np / 2; k++)
+	{
+		f->tre[k] = cos(2.0 * M_PI * k / np);
+		f->tim[k] = -sin(2.0 * M_PI * k / np);
+	}
+	int nbits = 0;
+	while ((1 << nbits) < np) nbits++;
+	for (int i = 0; i < np; i++)
+	{
+		int r = 0;
+		for (int b = 0; b < nbits; b++)
+			if (i & (1 << b)) r |= 1 << (nbits - 1 - b);
+		f->bitrev[i] = r;
+	}
+
+	// Bluestein chirp, and its conjugate wrapped around
+	// as convolution kernel, transformed in all lanes.
+	if (!pow2)
+	{
+		f->cre = alloc_real(nc);
+		f->cim = alloc_real(nc);
+		f->kre = alloc_real(np);
+		f->kim = alloc_real(np);
+		real* kr = alloc_real((size_t)np * LANES);
+		real* ki = alloc_real((size_t)np * LANES);
+		if (!f->cre || !f->cim || !f->kre || !f->kim || !kr || !ki)
+		{
+			free(kr); free(ki);
+			fft_builtin_dispose(f);
+			return NULL;
+		}
+		memset(kr, 0, sizeof(real) * np * LANES);
+		memset(ki, 0, sizeof(real) * np * LANES);
+		for (int j = 0; j < nc; j++)
+		{
+			double phi = M_PI * (double)(((long long)j * j) % (2 * nc)) / nc;
+			f->cre[j] = cos(phi);
+			f->cim[j] = -sin(phi);
+			for (int l = 0; l < LANES; l++)
+			{
+				kr[j * LANES + l] = cos(phi);
+				ki[j * LANES + l] = sin(phi);
+				if (j)
+				{
+					kr[(np - j) * LANES + l] = cos(phi);
+					ki[(np - j) * LANES + l] = sin(phi);
+				}
+			}
+		}
+		fft_pow2(f, kr, ki);
+		for (int j = 0; j < np; j++)
+		{
+			f->kre[j] = kr[j * LANES];
+			f->kim[j] = ki[j * LANES];
+		}
+		free(kr);
+		free(ki);
+	}
+
+	// Rows block, complex FFT buffers, and half spectrum
+	// with one extra vector for recurrence.
+	f->nwork = (size_t)LANES * ((n + 1) + 2 * np + 2 * (nr / 2 + 2));
+	f->work = alloc_real(f->nwork * f->nthreads);
+	if (!f->work)
+	{
+		fft_builtin_dispose(f);
+		return NULL;
+	}
+
+	return f;
+}
+
+// Defines arguments of batched transform, passed to the
+// parts of parallel loop over row blocks.
+struct execute_args_t
+{
+	struct fft_builtin_t* f;
+	real *in, *out;
+	int idist, odist;
+};
+
+// Transform row blocks begin .. end - 1.
+static void execute_part(void* arg, int part, long begin, long end)
+{
+	const struct execute_args_t* args = (const struct execute_args_t*)arg;
+	struct fft_builtin_t* f = args->f;
+	const real* in = args->in;
+	real* out = args->out;
+	int idist = args->idist, odist = args->odist;
+	int n = f->n, howmany = f->howmany;
+
+	for (int block = begin; block < end; block++)
+	{
+		real* w = f->work + f->nwork * part;
+		real* zr = w + (size_t)(n + 1) * LANES;
+		real* zi = zr + (size_t)f->np * LANES;
+		real* wr = zi + (size_t)f->np * LANES;
+		real* wi = wr + (size_t)(f->nr / 2 + 2) * LANES;
+
+		int first = block * LANES;
+		int count = (howmany - first < LANES) ? howmany - first : LANES;
+		if (count < LANES)
+			memset(w, 0, sizeof(real) * (n + 1) * LANES);
+
+		// Interleave rows, sine transform input
+		// starts from the second element.
+		int offset = (f->kind == FFT_RODFT00) ? 1 : 0;
+		for (int l = 0; l < count; l++)
+		{
+			const real* x = in + (size_t)(first + l) * idist;
+			for (int j = 0; j < n; j++)
+				w[(j + offset) * LANES + l] = x[j];
+		}
+
+		if (f->kind == FFT_RODFT00)
+			sine_block(f, w, zr, zi, wr, wi);
+		else
+			cosine_block(f, w, zr, zi, wr, wi);
+
+		for (int l = 0; l < count; l++)
+		{
+			real* y = out + (size_t)(first + l) * odist;
+			for (int j = 0; j < n; j++)
+				y[j] = w[j * LANES + l];
+		}
+	}
+}
+
+// Execute batched transform: rows are idist elements apart
+// in input and odist elements apart in output, in may be out.
+// The number of threads is limited by the caller threads.
+void fft_builtin_execute(struct fft_builtin_t* f,
+	real* in, int idist, real* out, int odist)
+{
+	int nblocks = (f->howmany + LANES - 1) / LANES;
+
+	// Do not exceed the threads of the caller.
+	int nthreads = poisson2d_parallel_nthreads();
+	if (nthreads > f->nthreads) nthreads = f->nthreads;
+
+	struct execute_args_t args = { f, in, out, idist, odist };
+	poisson2d_parallel_for(nthreads, nblocks, execute_part, &args);
+}
+
+// Destroy the batched transform.
+void fft_builtin_dispose(struct fft_builtin_t* f)
+{
+	free(f->sn); free(f->cs);
+	free(f->sre); free(f->sim);
+	free(f->tre); free(f->tim);
+	free(f->bitrev);
+	free(f->cre); free(f->cim);
+	free(f->kre); free(f->kim);
+	free(f->work);
+	free(f);
+}
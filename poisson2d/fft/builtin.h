@@ -0,0 +1,49 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FFT_BUILTIN_H
+#define FFT_BUILTIN_H
+
+#include "wrapper.h"
+
+// Defines batched sine or cosine transform implemented
+// in-tree, with no external FFT library: each transform is
+// reduced to real FFT of about the same length, computed by
+// complex FFT of half length (radix-2, or Bluestein algorithm
+// for other lengths). Blocks of rows are interleaved, so that
+// all arithmetic is vectorized across rows, and blocks are
+// shared between threads.
+struct fft_builtin_t;
+
+// Create batched transform of howmany rows of n elements,
+// using at most nthreads threads. Returns NULL, if the size
+// is not supported or memory cannot be allocated.
+struct fft_builtin_t* fft_builtin_create(int n, int howmany,
+	fft_kind kind, int nthreads);
+
+// Execute batched transform: rows are idist elements apart
+// in input and odist elements apart in output, in may be out.
+// The number of threads is limited by the caller threads.
+void fft_builtin_execute(struct fft_builtin_t* fft,
+	real* in, int idist, real* out, int odist);
+
+// Destroy the batched transform.
+void fft_builtin_dispose(struct fft_builtin_t* fft);
+
+#endif // FFT_BUILTIN_H
@@ -0,0 +1,213 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "dfti.h"
+#include "../parallel.h"
+
+#include <mkl_dfti.h>
+#include <mkl_service.h>
+#include <stdlib.h>
+
+#ifdef HAVE_SINGLE
+#define DFTI_REAL_PRECISION DFTI_SINGLE
+#else
+#define DFTI_REAL_PRECISION DFTI_DOUBLE
+#endif
+
+// Defines the number of rows extended and transformed
+// at once, bounding the scratch memory.
+#define FFT_DFTI_CHUNK 256
+
+struct fft_dfti_t
+{
+	// Transform length and kind, and extended
+	// sequence length.
+	int n, next;
+	fft_kind kind;
+
+	// Descriptors of full chunks of rows, and of the
+	// remaining rows, or NULL.
+	DFTI_DESCRIPTOR_HANDLE batch, tail;
+	int howmany, chunk, ntail;
+
+	// The number of threads extending rows
+	// and extracting transforms.
+	int nthreads;
+
+	// Extended rows, chunk x next elements, and their
+	// spectra, chunk x (next / 2 + 1) complex elements.
+	real *ext, *spec;
+};
+
+// Create real FFT descriptor of count transforms
+// of length next.
+static DFTI_DESCRIPTOR_HANDLE create_descriptor(
+	int next, int count, int nthreads)
+{
+	DFTI_DESCRIPTOR_HANDLE desc = NULL;
+	MKL_LONG status = DftiCreateDescriptor(&desc,
+		DFTI_REAL_PRECISION, DFTI_REAL, 1, (MKL_LONG)next);
+	if (status != DFTI_NO_ERROR) return NULL;
+
+	DftiSetValue(desc, DFTI_PLACEMENT, DFTI_NOT_INPLACE);
+	DftiSetValue(desc, DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX);
+	DftiSetValue(desc, DFTI_NUMBER_OF_TRANSFORMS, (MKL_LONG)count);
+	DftiSetValue(desc, DFTI_INPUT_DISTANCE, (MKL_LONG)next);
+	DftiSetValue(desc, DFTI_OUTPUT_DISTANCE, (MKL_LONG)(next / 2 + 1));
+	DftiSetValue(desc, DFTI_THREAD_LIMIT, (MKL_LONG)nthreads);
+
+	status = DftiCommitDescriptor(desc);
+	if (status != DFTI_NO_ERROR)
+	{
+		DftiFreeDescriptor(&desc);
+		return NULL;
+	}
+	return desc;
+}
+
+// Create batched transform of howmany rows of n elements,
+// using at most nthreads MKL threads.
+struct fft_dfti_t* fft_dfti_create(int n, int howmany,
+	fft_kind kind, int nthreads)
+{
+	// Cosine transform extension needs both end points.
+	if ((kind == FFT_REDFT00) && (n < 2)) return NULL;
+
+	struct fft_dfti_t* dfti = (struct fft_dfti_t*)malloc(
+		sizeof(struct fft_dfti_t));
+	dfti->n = n;
+	dfti->next = (kind == FFT_RODFT00) ? 2 * (n + 1) : 2 * (n - 1);
+	dfti->kind = kind;
+	dfti->howmany = howmany;
+	dfti->chunk = (howmany < FFT_DFTI_CHUNK) ? howmany : FFT_DFTI_CHUNK;
+	dfti->ntail = howmany % dfti->chunk;
+	dfti->nthreads = nthreads;
+
+	dfti->batch = create_descriptor(dfti->next, dfti->chunk, nthreads);
+	dfti->tail = dfti->ntail ?
+		create_descriptor(dfti->next, dfti->ntail, nthreads) : NULL;
+	dfti->ext = (real*)mkl_malloc(sizeof(real) *
+		dfti->chunk * dfti->next, 64);
+	dfti->spec = (real*)mkl_malloc(sizeof(real) *
+		dfti->chunk * (dfti->next / 2 + 1) * 2, 64);
+	if (!dfti->batch || (dfti->ntail && !dfti->tail) ||
+		!dfti->ext || !dfti->spec)
+	{
+		fft_dfti_dispose(dfti);
+		return NULL;
+	}
+
+	return dfti;
+}
+
+// Defines arguments of batched transform, passed to the
+// parts of parallel loops over rows of a chunk.
+struct execute_args_t
+{
+	struct fft_dfti_t* dfti;
+	real *in, *out;
+	int idist, odist, first;
+};
+
+// Extend rows begin .. end - 1 of the chunk: x(-1) = x(n) = 0,
+// odd about them for sine transform; even about x(0) and
+// x(n - 1) for cosine transform.
+static void extend_part(void* arg, int part, long begin, long end)
+{
+	const struct execute_args_t* args = (const struct execute_args_t*)arg;
+	struct fft_dfti_t* dfti = args->dfti;
+	int n = dfti->n, next = dfti->next;
+
+	for (int r = begin; r < end; r++)
+	{
+		const real* x = args->in + (size_t)(args->first + r) * args->idist;
+		real* e = dfti->ext + (size_t)r * next;
+		if (dfti->kind == FFT_RODFT00)
+		{
+			e[0] = 0.0; e[n + 1] = 0.0;
+			for (int j = 0; j < n; j++)
+			{
+				e[j + 1] = x[j];
+				e[next - 1 - j] = -x[j];
+			}
+		}
+		else
+		{
+			for (int j = 0; j < n; j++)
+				e[j] = x[j];
+			for (int j = 1; j < n - 1; j++)
+				e[next - j] = x[j];
+		}
+	}
+}
+
+// Extract transforms of rows begin .. end - 1 of the chunk:
+// sine transform is -Im X(k + 1), cosine transform is Re X(k),
+// in FFTW r2r scaling.
+static void extract_part(void* arg, int part, long begin, long end)
+{
+	const struct execute_args_t* args = (const struct execute_args_t*)arg;
+	struct fft_dfti_t* dfti = args->dfti;
+	int n = dfti->n, nspec = dfti->next / 2 + 1;
+
+	for (int r = begin; r < end; r++)
+	{
+		real* y = args->out + (size_t)(args->first + r) * args->odist;
+		const real* s = dfti->spec + (size_t)r * nspec * 2;
+		if (dfti->kind == FFT_RODFT00)
+			for (int k = 0; k < n; k++)
+				y[k] = -s[2 * (k + 1) + 1];
+		else
+			for (int k = 0; k < n; k++)
+				y[k] = s[2 * k];
+	}
+}
+
+// Execute batched transform: rows are idist elements apart
+// in input and odist elements apart in output, in may be out.
+void fft_dfti_execute(struct fft_dfti_t* dfti,
+	real* in, int idist, real* out, int odist)
+{
+	int nthreads = poisson2d_parallel_nthreads();
+	if (nthreads > dfti->nthreads) nthreads = dfti->nthreads;
+
+	struct execute_args_t args = { dfti, in, out, idist, odist, 0 };
+	for ( ; args.first < dfti->howmany; args.first += dfti->chunk)
+	{
+		int count = dfti->howmany - args.first;
+		if (count > dfti->chunk) count = dfti->chunk;
+
+		poisson2d_parallel_for(nthreads, count, extend_part, &args);
+
+		DftiComputeForward((count == dfti->chunk) ? dfti->batch : dfti->tail,
+			dfti->ext, dfti->spec);
+
+		poisson2d_parallel_for(nthreads, count, extract_part, &args);
+	}
+}
+
+// Destroy the batched transform.
+void fft_dfti_dispose(struct fft_dfti_t* dfti)
+{
+	if (dfti->batch) DftiFreeDescriptor(&dfti->batch);
+	if (dfti->tail) DftiFreeDescriptor(&dfti->tail);
+	if (dfti->ext) mkl_free(dfti->ext);
+	if (dfti->spec) mkl_free(dfti->spec);
+	free(dfti);
+}
@@ -0,0 +1,43 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FFT_DFTI_H
+#define FFT_DFTI_H
+
+#include "wrapper.h"
+
+// Defines batched sine or cosine transform over MKL DFTI:
+// rows are extended to odd (sine) or even (cosine) sequences,
+// and transformed by real FFT descriptor of many transforms.
+struct fft_dfti_t;
+
+// Create batched transform of howmany rows of n elements,
+// using at most nthreads MKL threads.
+struct fft_dfti_t* fft_dfti_create(int n, int howmany,
+	fft_kind kind, int nthreads);
+
+// Execute batched transform: rows are idist elements apart
+// in input and odist elements apart in output, in may be out.
+void fft_dfti_execute(struct fft_dfti_t* dfti,
+	real* in, int idist, real* out, int odist);
+
+// Destroy the batched transform.
+void fft_dfti_dispose(struct fft_dfti_t* dfti);
+
+#endif // FFT_DFTI_H
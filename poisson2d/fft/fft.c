@@ -21,12 +21,16 @@
 #include "wrapper.h"
 #include "fft.h"
 #include "shutter.h"
+#include "tuning.h"
+#include "../parallel.h"
 
 #include <assert.h>
 #include <malloc.h>
 #include <math.h>
 #include <omp.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 
 // Defines internal structure for fft solver.
 struct poisson2d_fft_solver_t
@@ -36,70 +40,624 @@ struct poisson2d_fft_solver_t
 	
 	// Arrays for problem right hand side and solution.
 	// Internally also used to keep transformed data and
-	// shutter result.
+	// shutter result. Rows are ld elements apart.
 	real *rhs, *solution;
+	unsigned int ld;
 	
 	// Arrays for transformed boundary conditions.
 	real *cby, *cey;
 
-	// Shutter coefficients.
+	// Shutter coefficients, n + 1 elements per thread.
 	real *alpha, *beta;
+	int nthreads;
+
+	// Shutter alpha coefficients of all modes, precomputed
+	// for sparse solves (BREEZE2D_POISSON_SPARSE), or NULL.
+	real* factor;
+
+	// Coefficients of 3-diagonal systems and their factorization
+	// for Y grid with variable steps (BREEZE2D_POISSON_STRETCHED_Y),
+	// and whether the steps are set.
+	real *ya, *yc, *yfactor;
+	int stretched;
+
+	// Right hand side values beyond X boundaries, extrapolated
+	// for each row, for the fourth order compact scheme
+	// (BREEZE2D_POISSON_COMPACT4), or NULL.
+	real *xc0, *xc1;
+
+	// Boundary conditions by Y.
+	real *by, *ey;
 	
 	fft_plan *plan_main, *plan_bc, *plan_ec;
+
+	// BREEZE2D_POISSON_* option flags.
+	unsigned int flags;
+
+	// Transformed right hand side kept between solves
+	// (BREEZE2D_POISSON_CACHE_RHS), the plan to fill it,
+	// and whether it holds the last solved right hand side.
+	real* frhs;
+	fft_plan* plan_cache;
+	int cached;
+
+	// Gradient outputs (BREEZE2D_POISSON_GRADIENT), or NULL,
+	// cosine coefficients of X-derivative in rows of m + 2
+	// elements, and inverse plans for both derivatives.
+	real *dphidx, *dphidy, *gx;
+	fft_plan *plan_dx, *plan_dy;
+	void *plan_dx_desc, *plan_dy_desc;
+
+	// Background planning (BREEZE2D_POISSON_PROGRESSIVE): the thread
+	// creating measured plans, whether it is running, and whether
+	// it has finished, the measured plans and their descriptors.
+	pthread_t planner;
+	int planning, planned;
+	fft_plan *plan_main_next, *plan_cache_next;
+	void *plan_main_next_desc, *plan_cache_next_desc;
+
+	// Pipelined solve (BREEZE2D_POISSON_PIPELINE): plans of nbatches
+	// row batches of nrows rows, shutter alpha coefficients row
+	// after row, the number of mode blocks of mwidth modes, the
+	// backward sweep solution carried between row batches, the
+	// number of mode blocks yet to finish each row batch, and
+	// task dependency objects.
+	fft_plan** plan_rows;
+	int nbatches, nrows, nblocks, mwidth;
+	real *pfactor, *carry;
+	int* remaining;
+	char* deps;
+
+	// Time and hardware counters of solve stages
+	// (BREEZE2D_POISSON_COUNTERS), and the number of runs.
+	breeze2d_counters stages[BREEZE2D_POISSON_NSTAGES];
+	unsigned int ncalls[BREEZE2D_POISSON_NSTAGES];
+
+	// Workspace memory allocated by solver, or NULL,
+	// if workspace is provided by the caller.
+	void* workspace;
 };
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// Defines bump allocator over the solver workspace.
+struct workspace_t
+{
+	char* ptr;
+	size_t size;
+};
+
+// Take the next aligned block of the specified size from workspace.
+static void* workspace_alloc(struct workspace_t* ws, size_t size)
+{
+	size = FFT_ALIGN(size);
+	assert(size <= ws->size);
+	void* ptr = ws->ptr;
+	ws->ptr += size;
+	ws->size -= size;
+	return ptr;
+}
+
+// Get the maximum number of threads of the solver with the
+// specified option flags: one for the serial solver, or the
+// threads of parallel loops (see poisson2d_parallel_nthreads).
+static int init_nthreads(unsigned int flags)
+{
+	if (flags & BREEZE2D_POISSON_SERIAL) return 1;
+	return poisson2d_parallel_nthreads();
+}
+
+// Get the number of threads of the solve: the solver threads,
+// limited by the caller threads, so that solves called
+// from parallel code (e.g. solve queue workers) do not
+// oversubscribe cores.
+static int solve_nthreads(const struct poisson2d_fft_solver_t* solver)
+{
+	return MIN(solver->nthreads, poisson2d_parallel_nthreads());
+}
+
+// Check whether to plan progressively: only if requested, and
+// the backend plans differ with estimated and measured planner
+// (builtin, MKL and DFTI backends have no planner flags).
+static int progressive(unsigned int flags)
+{
+	return (flags & BREEZE2D_POISSON_PROGRESSIVE) &&
+		(FFT_ESTIMATE != FFT_MEASURE);
+}
+
+// Get the number of rows in batches of the pipelined solve:
+// about 4 batches per thread, of at least 16 rows.
+static int pipeline_rows(unsigned int n)
+{
+	int nbatches = 4 * omp_get_max_threads();
+	return MAX((int)(n + nbatches - 1) / nbatches, 16);
+}
+
+// Get the number of modes in blocks of the pipelined solve:
+// about 2 blocks per thread, of whole cache lines.
+static int pipeline_width(unsigned int m)
+{
+	int line = FFT_ALIGNMENT / sizeof(real);
+	int nblocks = 2 * omp_get_max_threads();
+	int width = (m + nblocks - 1) / nblocks;
+	return (width + line - 1) / line * line;
+}
+
+// Allocate scratch array of the specified size with the same
+// alignment as the given array, to plan transforms on it.
+static real* scratch_alloc(size_t size, real* like, void** block)
+{
+	*block = malloc(size + 2 * FFT_ALIGNMENT);
+	if (!*block) return NULL;
+	return (real*)(FFT_ALIGN((size_t)*block) +
+		(size_t)like % FFT_ALIGNMENT);
+}
+
+// Create measured plans of the m x n transforms for the solver
+// arrays, planning on private scratch arrays, and save the
+// planner wisdom, so that next runs start with measured plans.
+static void* plan_measured(void* arg)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)arg;
+
+	int n = solver->n, m = solver->m, ld = solver->ld;
+	size_t size = sizeof(real) * ld * n;
+	real *rhs = solver->rhs, *solution = solver->solution;
+
+	void *block_in, *block_out = NULL;
+	real* in = scratch_alloc(size, rhs, &block_in);
+	real* out = (rhs == solution) ? in :
+		scratch_alloc(size, solution, &block_out);
+	if (in && out)
+		solver->plan_main_next = fft_create_multi_scratch_at(
+			solver->plan_main_next_desc, m, n, rhs, solution, ld, ld,
+			FFT_RODFT00, FFT_MEASURE, in, out);
+	free(block_out);
+	block_out = NULL;
+
+	if (in && solver->frhs)
+	{
+		out = scratch_alloc(sizeof(real) * m * n, solver->frhs, &block_out);
+		if (out)
+			solver->plan_cache_next = fft_create_multi_scratch_at(
+				solver->plan_cache_next_desc, m, n, rhs, solver->frhs,
+				ld, m, FFT_RODFT00, FFT_MEASURE, in, out);
+		free(block_out);
+	}
+	free(block_in);
+
+	fft_export_wisdom();
+
+	__atomic_store_n(&solver->planned, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+// Time solves of m x n problem (forward transform, shutter and
+// inverse transform) in candidate configurations: the numbers
+// of threads from 1 to maxthreads by powers of 2, with estimated
+// or measured plans. Solves are performed on scratch arrays of
+// the same alignment and in-place property as the solver arrays,
+// keeping their contents. Returns the fastest configuration.
+static struct fft_tuning_t autotune(unsigned int m, unsigned int n,
+	real hx, real hy, real* rhs, real* solution, unsigned int ld,
+	int maxthreads)
+{
+	struct fft_tuning_t best;
+	best.nthreads = maxthreads;
+	best.planner = FFT_MEASURE;
+
+	size_t size = sizeof(real) * ld * n;
+	void *block_in, *block_out = NULL;
+	real* in = scratch_alloc(size, rhs, &block_in);
+	real* out = (rhs == solution) ? in :
+		scratch_alloc(size, solution, &block_out);
+	real* alpha = (real*)malloc(sizeof(real) * (n + 1) * maxthreads);
+	real* beta = (real*)malloc(sizeof(real) * (n + 1) * maxthreads);
+	real* bc = (real*)calloc(m, sizeof(real));
+	real* ec = (real*)calloc(m, sizeof(real));
+
+	const unsigned planners[] = { FFT_ESTIMATE, FFT_MEASURE };
+	int nplanners = (FFT_ESTIMATE == FFT_MEASURE) ? 1 : 2;
+	double tbest = 0.0;
+	for (int t = 1; in && out && alpha && beta && bc && ec; t *= 2)
+	{
+		int nthreads = MIN(t, maxthreads);
+		fft_plan_with_nthreads(nthreads);
+		for (int i = 0; i < nplanners; i++)
+		{
+			fft_plan* plan = fft_create_multi(m, n, in, out, ld, ld,
+				FFT_RODFT00, planners[i]);
+			if (!plan) continue;
+
+			for (int j = 0; j < n; j++)
+				for (int k = 0; k < m; k++)
+					in[j * ld + k] = sin(M_PI * (k + 1) / (m + 1)) * (j + 1);
+
+			// Take the best of a few solves, after warm up one.
+			double time = 0.0;
+			for (int it = 0; it < 4; it++)
+			{
+				double start = omp_get_wtime();
+				fft_forward(plan);
+				poisson2d_shutter_r(m, n, hx, hy, out, ld, in, ld,
+					alpha, beta, bc, ec, 0.5 / (m + 1), nthreads);
+				fft_inverse(plan);
+				double finish = omp_get_wtime() - start;
+				if ((it == 1) || ((it > 1) && (finish < time)))
+					time = finish;
+			}
+			fft_dispose(plan);
+
+			if ((tbest == 0.0) || (time < tbest))
+			{
+				tbest = time;
+				best.nthreads = nthreads;
+				best.planner = planners[i];
+			}
+		}
+		if (nthreads == maxthreads) break;
+	}
+
+	free(alpha); free(beta);
+	free(bc); free(ec);
+	free(block_out);
+	free(block_in);
+
+	return best;
+}
+
+// Replace the estimated plans with the measured ones,
+// if background planning has finished. Called between
+// solves, so that no transform is in flight.
+static void upgrade_plans(struct poisson2d_fft_solver_t* solver)
+{
+	if (!solver->planning ||
+		!__atomic_load_n(&solver->planned, __ATOMIC_ACQUIRE))
+		return;
+
+	pthread_join(solver->planner, NULL);
+	solver->planning = 0;
+
+	// Keep estimated plan, if measured one failed. Measured
+	// plans are bound to the arrays in use at init, which
+	// may be replaced since.
+	if (solver->plan_main_next)
+	{
+		fft_dispose(solver->plan_main);
+		solver->plan_main = solver->plan_main_next;
+		solver->plan_main_next = NULL;
+		fft_set_arrays(solver->plan_main, solver->rhs, solver->solution);
+	}
+	if (solver->plan_cache_next)
+	{
+		fft_dispose(solver->plan_cache);
+		solver->plan_cache = solver->plan_cache_next;
+		solver->plan_cache_next = NULL;
+		fft_set_arrays(solver->plan_cache, solver->rhs, solver->frhs);
+	}
+}
+
+// Get the size of workspace memory used by 2D Poisson
+// equation FFT solver of the specified problem size.
+size_t poisson2d_fft_solver_workspace_size(
+	unsigned int m, unsigned int n, unsigned int flags)
+{
+	size_t size = FFT_ALIGN(sizeof(struct poisson2d_fft_solver_t)) +
+		2 * FFT_ALIGN(sizeof(real) * (n + 1) * init_nthreads(flags)) +
+		2 * FFT_ALIGN(sizeof(real) * m) +
+		FFT_ALIGN(fft_plan_size(n)) +
+		2 * FFT_ALIGN(fft_plan_size(1));
+	if (flags & BREEZE2D_POISSON_CACHE_RHS)
+		size += FFT_ALIGN(sizeof(real) * m * n) +
+			FFT_ALIGN(fft_plan_size(n));
+	if (flags & BREEZE2D_POISSON_GRADIENT)
+		size += FFT_ALIGN(sizeof(real) * (m + 2) * n) +
+			2 * FFT_ALIGN(fft_plan_size(n));
+	if (flags & BREEZE2D_POISSON_SPARSE)
+		size += FFT_ALIGN(sizeof(real) * m * (n + 1));
+	if (flags & BREEZE2D_POISSON_STRETCHED_Y)
+		size += 2 * FFT_ALIGN(sizeof(real) * (n + 1)) +
+			FFT_ALIGN(sizeof(real) * m * (n + 1));
+	if (flags & BREEZE2D_POISSON_COMPACT4)
+		size += 2 * FFT_ALIGN(sizeof(real) * n);
+	if (progressive(flags))
+	{
+		size += FFT_ALIGN(fft_plan_size(n));
+		if (flags & BREEZE2D_POISSON_CACHE_RHS)
+			size += FFT_ALIGN(fft_plan_size(n));
+	}
+	if (flags & BREEZE2D_POISSON_PIPELINE)
+	{
+		int nrows = pipeline_rows(n), nbatches = (n + nrows - 1) / nrows;
+		int width = pipeline_width(m), nblocks = (m + width - 1) / width;
+		size += FFT_ALIGN(sizeof(real) * m * n) + FFT_ALIGN(sizeof(real) * m) +
+			FFT_ALIGN(sizeof(int) * nbatches) + FFT_ALIGN(nbatches + nblocks + 1) +
+			FFT_ALIGN(sizeof(fft_plan*) * nbatches) +
+			nbatches * FFT_ALIGN(fft_plan_size(nrows));
+	}
+	return size;
+}
+
+// Release the created plans of solver.
+static void release_plans(struct poisson2d_fft_solver_t* solver)
+{
+	if (solver->plan_main)
+		fft_dispose(solver->plan_main);
+	if (solver->plan_bc)
+		fft_dispose(solver->plan_bc);
+	if (solver->plan_ec)
+		fft_dispose(solver->plan_ec);
+	if (solver->plan_cache)
+		fft_dispose(solver->plan_cache);
+	if (solver->plan_dx)
+		fft_dispose(solver->plan_dx);
+	if (solver->plan_dy)
+		fft_dispose(solver->plan_dy);
+	if (solver->plan_rows)
+		for (int r = 0; r < solver->nbatches; r++)
+			if (solver->plan_rows[r])
+				fft_dispose(solver->plan_rows[r]);
+}
+
+// Release the plans and counters opened by the failed solver
+// initialization and report the plan creation failure.
+static poisson2d_fft_solver plan_creation_failed(
+	struct poisson2d_fft_solver_t* solver)
+{
+	release_plans(solver);
+	if (solver->flags & BREEZE2D_POISSON_COUNTERS)
+		breeze2d_counters_close();
+	breeze2d_set_error(BREEZE2D_FFT_PLAN_CREATION_FAILED);
+	return NULL;
+}
 
 // Initialize 2D Poisson equation FFT solver for the
 // specified problem size and data arrays.
 poisson2d_fft_solver poisson2d_fft_solver_init(
 	unsigned int m, unsigned int n, real hx, real hy,
 	real* bx, real* ex, real* by, real* ey,
-	real* rhs, real* solution)
+	real* rhs, real* solution, unsigned int ld, unsigned int flags)
 {
+	size_t size = poisson2d_fft_solver_workspace_size(m, n, flags);
+	void* workspace = malloc(size + FFT_ALIGNMENT);
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)poisson2d_fft_solver_init_workspace(
+			m, n, hx, hy, bx, ex, by, ey, rhs, solution, ld, flags,
+			(char*)workspace + FFT_ALIGN((size_t)workspace) - (size_t)workspace,
+			size);
+	if (!solver)
+	{
+		free(workspace);
+		return NULL;
+	}
+	solver->workspace = workspace;
+
+	return (poisson2d_fft_solver)solver;
+}
+
+// Initialize 2D Poisson equation FFT solver for the
+// specified problem size and data arrays, placing all
+// solver data into the caller-provided workspace.
+poisson2d_fft_solver poisson2d_fft_solver_init_workspace(
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* bx, real* ex, real* by, real* ey,
+	real* rhs, real* solution, unsigned int ld, unsigned int flags,
+	void* workspace, size_t size)
+{
+	if (((size_t)workspace % FFT_ALIGNMENT) ||
+		(size < poisson2d_fft_solver_workspace_size(m, n, flags)))
+	{
+		breeze2d_set_error(BREEZE2D_INSUFFICIENT_WORKSPACE);
+		return NULL;
+	}
+	if (flags & BREEZE2D_POISSON_COMPACT4)
+	{
+		if (flags & (BREEZE2D_POISSON_GRADIENT | BREEZE2D_POISSON_STRETCHED_Y))
+		{
+			breeze2d_set_error(BREEZE2D_INCOMPATIBLE_OPTIONS);
+			return NULL;
+		}
+
+		// Compact scheme 3-diagonal systems are only
+		// diagonally dominant for hy^2 < 2 hx^2.
+		if (hy * hy >= 2.0 * hx * hx)
+		{
+			breeze2d_set_error(BREEZE2D_UNSUPPORTED_ASPECT_RATIO);
+			return NULL;
+		}
+	}
+	if ((flags & BREEZE2D_POISSON_PIPELINE) &&
+		(flags & (BREEZE2D_POISSON_CACHE_RHS | BREEZE2D_POISSON_GRADIENT |
+			BREEZE2D_POISSON_STRETCHED_Y | BREEZE2D_POISSON_COMPACT4)))
+	{
+		breeze2d_set_error(BREEZE2D_INCOMPATIBLE_OPTIONS);
+		return NULL;
+	}
+
+	struct workspace_t ws;
+	ws.ptr = (char*)workspace;
+	ws.size = size;
+
 	fft_init_threads();
-	fft_plan_with_nthreads(omp_get_num_threads());
+
+	// Use all threads and measured plans, or the configuration
+	// tuned for this problem size, found in the tuning database
+	// or timed now. Serial solver only tunes the planner, and
+	// keeps it under its own key.
+	int maxthreads = init_nthreads(flags);
+	int serial = (flags & BREEZE2D_POISSON_SERIAL) != 0;
+	struct fft_tuning_t tuning;
+	tuning.nthreads = maxthreads;
+	tuning.planner = FFT_MEASURE;
+	if ((flags & BREEZE2D_POISSON_AUTOTUNE) &&
+		!fft_tuning_load(m, n, serial, &tuning))
+	{
+		tuning = autotune(m, n, hx, hy, rhs, solution, ld, maxthreads);
+		fft_tuning_save(m, n, serial, &tuning);
+	}
+	tuning.nthreads = MIN(tuning.nthreads, maxthreads);
+	fft_plan_with_nthreads(tuning.nthreads);
 
 	// Create and populate solver configuration structure.
 	struct poisson2d_fft_solver_t* solver =
-		(struct poisson2d_fft_solver_t*)malloc(
+		(struct poisson2d_fft_solver_t*)workspace_alloc(&ws,
 			sizeof(struct poisson2d_fft_solver_t));
 	solver->m = m; solver->n = n; solver->hx = hx; solver->hy = hy;
 	solver->rhs = rhs; solver->solution = solution;
+	solver->ld = ld;
+	solver->by = by; solver->ey = ey;
+	solver->nthreads = tuning.nthreads;
+	solver->factor = NULL;
+	solver->ya = NULL; solver->yc = NULL; solver->yfactor = NULL;
+	solver->stretched = 0;
+	solver->xc0 = NULL; solver->xc1 = NULL;
+	solver->flags = flags;
+	memset(solver->stages, 0, sizeof(solver->stages));
+	memset(solver->ncalls, 0, sizeof(solver->ncalls));
+	if (flags & BREEZE2D_POISSON_COUNTERS)
+		breeze2d_counters_open();
+	solver->plan_main = NULL;
+	solver->plan_bc = NULL; solver->plan_ec = NULL;
+	solver->frhs = NULL; solver->plan_cache = NULL;
+	solver->cached = 0;
+	solver->dphidx = NULL; solver->dphidy = NULL; solver->gx = NULL;
+	solver->plan_dx = NULL; solver->plan_dy = NULL;
+	solver->planning = 0; solver->planned = 0;
+	solver->plan_main_next = NULL; solver->plan_cache_next = NULL;
+	solver->plan_rows = NULL;
+	solver->workspace = NULL;
+
+	// With progressive planning, start with estimated plans,
+	// measured plans are created in background.
+	unsigned planner_flags = progressive(flags) ?
+		FFT_ESTIMATE : tuning.planner;
 
 	// Create main transform pass plan and optionally
 	// benchmark it to let FFT select algorithm with
-	// optimal performance.
-	solver->plan_main = fft_create_multi(m, n,
-		rhs, solution, m, m, FFTW_RODFT00, FFT_MEASURE);
+	// optimal performance. If rhs and solution are
+	// the same array, the plan is in-place.
+	solver->plan_main = fft_create_multi_at(
+		workspace_alloc(&ws, fft_plan_size(n)), m, n,
+		rhs, solution, ld, ld, FFT_RODFT00, planner_flags);
 	if (!solver->plan_main)
-	{
-		breeze2d_set_error(BREEZE2D_FFT_PLAN_CREATION_FAILED);
-		return NULL;
-	}
+		return plan_creation_failed(solver);
 
-	// Create arrays for shutter coefficients.
-	solver->alpha = (real*)fft_malloc(sizeof(real) * n);
-	solver->beta = (real*)fft_malloc(sizeof(complex) * n);
+	// Create arrays for shutter coefficients
+	// (n inner points plus the top boundary),
+	// for each thread.
+	size_t nab = sizeof(real) * (n + 1) * solver->nthreads;
+	solver->alpha = (real*)workspace_alloc(&ws, nab);
+	solver->beta = (real*)workspace_alloc(&ws, nab);
 	
 	// Allocate arrays to hold transformed boundary conditions.
-	solver->cby = (real*)fft_malloc(m * sizeof(real));
-	solver->cey = (real*)fft_malloc(m * sizeof(real));
+	solver->cby = (real*)workspace_alloc(&ws, m * sizeof(real));
+	solver->cey = (real*)workspace_alloc(&ws, m * sizeof(real));
 
 	// Create plans to transform boundary conditions.
-	solver->plan_bc = fft_create(m, by, solver->cby,
-		FFTW_RODFT00, FFT_MEASURE);
+	solver->plan_bc = fft_create_at(
+		workspace_alloc(&ws, fft_plan_size(1)), m, by, solver->cby,
+		FFT_RODFT00, planner_flags);
 	if (!solver->plan_bc)
+		return plan_creation_failed(solver);
+	solver->plan_ec = fft_create_at(
+		workspace_alloc(&ws, fft_plan_size(1)), m, ey, solver->cey,
+		FFT_RODFT00, (planner_flags == FFT_ESTIMATE) ?
+			FFT_ESTIMATE : FFT_WISDOM_ONLY | FFT_MEASURE);
+	if (!solver->plan_ec)
+		return plan_creation_failed(solver);
+
+	// Create array and plan to keep the transformed right
+	// hand side out of the scratch space. The plan is always
+	// out-of-place, so it also serves single buffer mode.
+	if (flags & BREEZE2D_POISSON_CACHE_RHS)
 	{
-		breeze2d_set_error(BREEZE2D_FFT_PLAN_CREATION_FAILED);
-		return NULL;
+		solver->frhs = (real*)workspace_alloc(&ws, sizeof(real) * m * n);
+		solver->plan_cache = fft_create_multi_at(
+			workspace_alloc(&ws, fft_plan_size(n)), m, n,
+			rhs, solver->frhs, ld, m, FFT_RODFT00, planner_flags);
+		if (!solver->plan_cache)
+			return plan_creation_failed(solver);
 	}
-	solver->plan_ec = fft_create(m, ey, solver->cey,
-		FFTW_RODFT00, FFT_WISDOM_ONLY | FFT_MEASURE);
-	if (!solver->plan_ec)
+
+	// Reserve space for gradient outputs, their plans
+	// are created when output arrays are set.
+	if (flags & BREEZE2D_POISSON_GRADIENT)
 	{
-		breeze2d_set_error(BREEZE2D_FFT_PLAN_CREATION_FAILED);
-		return NULL;
+		solver->gx = (real*)workspace_alloc(&ws, sizeof(real) * (m + 2) * n);
+		solver->plan_dx_desc = workspace_alloc(&ws, fft_plan_size(n));
+		solver->plan_dy_desc = workspace_alloc(&ws, fft_plan_size(n));
+	}
+
+	// Factorize 3-diagonal systems for sparse solves.
+	if (flags & BREEZE2D_POISSON_SPARSE)
+	{
+		solver->factor = (real*)workspace_alloc(&ws, sizeof(real) * m * (n + 1));
+		poisson2d_shutter_factor_r(m, n, hx, hy, solver->factor,
+			solver->nthreads);
+	}
+
+	// Reserve space for variable Y grid steps factorization,
+	// it is computed when the steps are set.
+	if (flags & BREEZE2D_POISSON_STRETCHED_Y)
+	{
+		solver->ya = (real*)workspace_alloc(&ws, sizeof(real) * (n + 1));
+		solver->yc = (real*)workspace_alloc(&ws, sizeof(real) * (n + 1));
+		solver->yfactor = (real*)workspace_alloc(&ws, sizeof(real) * m * (n + 1));
+	}
+
+	if (flags & BREEZE2D_POISSON_COMPACT4)
+	{
+		solver->xc0 = (real*)workspace_alloc(&ws, sizeof(real) * n);
+		solver->xc1 = (real*)workspace_alloc(&ws, sizeof(real) * n);
+	}
+
+	// Create single-threaded plans of row batches for the
+	// pipelined solve, threads are shared between tasks.
+	if (flags & BREEZE2D_POISSON_PIPELINE)
+	{
+		int nrows = pipeline_rows(n);
+		solver->nrows = nrows;
+		solver->nbatches = (n + nrows - 1) / nrows;
+		solver->mwidth = pipeline_width(m);
+		solver->nblocks = (m + solver->mwidth - 1) / solver->mwidth;
+		solver->pfactor = (real*)workspace_alloc(&ws, sizeof(real) * m * n);
+		poisson2d_shutter_factor_rows_r(m, n, hx, hy, solver->pfactor,
+			solver->nthreads);
+		solver->carry = (real*)workspace_alloc(&ws, sizeof(real) * m);
+		solver->remaining = (int*)workspace_alloc(&ws, sizeof(int) * solver->nbatches);
+		solver->deps = (char*)workspace_alloc(&ws,
+			solver->nbatches + solver->nblocks + 1);
+		fft_plan** plan_rows = (fft_plan**)workspace_alloc(&ws,
+			sizeof(fft_plan*) * solver->nbatches);
+		memset(plan_rows, 0, sizeof(fft_plan*) * solver->nbatches);
+		solver->plan_rows = plan_rows;
+		fft_plan_with_nthreads(1);
+		for (int r = 0; r < solver->nbatches; r++)
+		{
+			int first = r * nrows, count = MIN(nrows, (int)n - first);
+			plan_rows[r] = fft_create_multi_at(
+				workspace_alloc(&ws, fft_plan_size(nrows)), m, count,
+				rhs + first * ld, solution + first * ld, ld, ld,
+				FFT_RODFT00, planner_flags);
+			if (!plan_rows[r])
+				break;
+		}
+		fft_plan_with_nthreads(tuning.nthreads);
+		if (!plan_rows[solver->nbatches - 1])
+			return plan_creation_failed(solver);
+	}
+
+	// Start creating measured plans in background.
+	if (progressive(flags))
+	{
+		solver->plan_main_next_desc = workspace_alloc(&ws, fft_plan_size(n));
+		if (flags & BREEZE2D_POISSON_CACHE_RHS)
+			solver->plan_cache_next_desc = workspace_alloc(&ws, fft_plan_size(n));
+		solver->planning = !pthread_create(&solver->planner, NULL,
+			plan_measured, solver);
 	}
 	
 	return (poisson2d_fft_solver)solver;
@@ -110,15 +668,378 @@ void poisson2d_fft_solver_dispose(poisson2d_fft_solver desc)
 {
 	struct poisson2d_fft_solver_t* solver =
 		(struct poisson2d_fft_solver_t*)desc;
+
+	// Wait for background planning to finish.
+	if (solver->planning)
+	{
+		pthread_join(solver->planner, NULL);
+		if (solver->plan_main_next)
+			fft_dispose(solver->plan_main_next);
+		if (solver->plan_cache_next)
+			fft_dispose(solver->plan_cache_next);
+	}
 	
-	fft_free(solver->alpha); fft_free(solver->beta);
-	fft_free(solver->cby); fft_free(solver->cey);
-	
-	fft_dispose(solver->plan_main);
-	fft_dispose(solver->plan_bc);
-	fft_dispose(solver->plan_ec);
+	release_plans(solver);
+	if (solver->flags & BREEZE2D_POISSON_COUNTERS)
+		breeze2d_counters_close();
 	
-	free(solver);
+	// Note solver structure itself is placed in workspace.
+	free(solver->workspace);
+}
+
+// Replace the right hand side and solution arrays with
+// the specified ones, having the same alignment and in-place
+// property, as the arrays solver was created for.
+void poisson2d_fft_solver_set_arrays(poisson2d_fft_solver desc,
+	real* rhs, real* solution)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	if (((rhs == solution) != (solver->rhs == solver->solution)) ||
+		((size_t)rhs % FFT_ALIGNMENT != (size_t)solver->rhs % FFT_ALIGNMENT) ||
+		((size_t)solution % FFT_ALIGNMENT != (size_t)solver->solution % FFT_ALIGNMENT))
+	{
+		breeze2d_set_error(BREEZE2D_INCOMPATIBLE_ARRAYS);
+		return;
+	}
+
+	solver->rhs = rhs; solver->solution = solution;
+
+	fft_set_arrays(solver->plan_main, rhs, solution);
+	if (solver->plan_cache)
+		fft_set_arrays(solver->plan_cache, rhs, solver->frhs);
+	if (solver->plan_rows)
+		for (int r = 0; r < solver->nbatches; r++)
+		{
+			int first = r * solver->nrows * solver->ld;
+			fft_set_arrays(solver->plan_rows[r], rhs + first, solution + first);
+		}
+}
+
+// Set arrays to output the solution gradient
+// from each subsequent solve.
+void poisson2d_fft_solver_set_gradient(poisson2d_fft_solver desc,
+	real* dphidx, real* dphidy)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	if (!solver->gx)
+	{
+		breeze2d_set_error(BREEZE2D_GRADIENT_NOT_ENABLED);
+		return;
+	}
+	if (solver->stretched)
+	{
+		breeze2d_set_error(BREEZE2D_INCOMPATIBLE_OPTIONS);
+		return;
+	}
+
+	int n = solver->n, m = solver->m;
+
+	if (solver->plan_dx)
+		fft_dispose(solver->plan_dx);
+	if (solver->plan_dy)
+		fft_dispose(solver->plan_dy);
+	solver->plan_dx = NULL; solver->plan_dy = NULL;
+	solver->dphidx = dphidx; solver->dphidy = dphidy;
+
+	// X-derivative of sine series is cosine series over
+	// m + 2 points, including zero boundary columns.
+	if (dphidx)
+	{
+		solver->plan_dx = fft_create_multi_at(solver->plan_dx_desc,
+			m + 2, n, solver->gx, solver->gx, m + 2, m + 2,
+			FFT_REDFT00, FFT_MEASURE);
+		if (!solver->plan_dx)
+		{
+			breeze2d_set_error(BREEZE2D_FFT_PLAN_CREATION_FAILED);
+			return;
+		}
+	}
+
+	// Y-derivative is sine series, as the solution.
+	if (dphidy)
+	{
+		solver->plan_dy = fft_create_multi_at(solver->plan_dy_desc,
+			m, n, dphidy, dphidy, m, m, FFT_RODFT00, FFT_MEASURE);
+		if (!solver->plan_dy)
+		{
+			breeze2d_set_error(BREEZE2D_FFT_PLAN_CREATION_FAILED);
+			return;
+		}
+	}
+}
+
+// Set the variable steps of Y grid, and factorize
+// 3-diagonal systems for them.
+void poisson2d_fft_solver_set_grid_y(poisson2d_fft_solver desc,
+	const real* hy)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	if (!solver->yfactor)
+	{
+		breeze2d_set_error(BREEZE2D_STRETCHED_Y_NOT_ENABLED);
+		return;
+	}
+	if (solver->dphidx || solver->dphidy)
+	{
+		breeze2d_set_error(BREEZE2D_INCOMPATIBLE_OPTIONS);
+		return;
+	}
+
+	poisson2d_shutter_factor_stretched_r(solver->m, solver->n,
+		solver->hx, hy, solver->ya, solver->yc, solver->yfactor,
+		solver->nthreads);
+	solver->stretched = 1;
+}
+
+// Solve m 3-diagonal systems of n equations using shutter
+// method, for uniform or variable steps Y grid, or for
+// the fourth order compact scheme. The compact scheme
+// right hand side beyond X boundaries is only known
+// in solves with physical right hand side (xcorrect).
+static void shutter(struct poisson2d_fft_solver_t* solver,
+	real* rhs, int ldrhs, real* solution, int ldsolution,
+	real scale, int xcorrect)
+{
+	int n = solver->n, m = solver->m;
+
+	if (solver->flags & BREEZE2D_POISSON_COMPACT4)
+		poisson2d_shutter_compact_r(m, n, solver->hx, solver->hy,
+			rhs, ldrhs, solution, ldsolution, solver->alpha, solver->beta,
+			solver->cby, solver->cey,
+			xcorrect ? solver->xc0 : NULL,
+			xcorrect ? solver->xc1 : NULL,
+			scale, solve_nthreads(solver));
+	else if (solver->stretched)
+		poisson2d_shutter_stretched_r(m, n, rhs, ldrhs, solution, ldsolution,
+			solver->beta, solver->ya, solver->yc, solver->yfactor,
+			solver->cby, solver->cey, scale, solve_nthreads(solver));
+	else
+		poisson2d_shutter_r(m, n, solver->hx, solver->hy,
+			rhs, ldrhs, solution, ldsolution, solver->alpha, solver->beta,
+			solver->cby, solver->cey, scale, solve_nthreads(solver));
+}
+
+// Read counters at the start of solve stage,
+// with BREEZE2D_POISSON_COUNTERS.
+static void stage_start(const struct poisson2d_fft_solver_t* solver,
+	breeze2d_counters* start)
+{
+	if (solver->flags & BREEZE2D_POISSON_COUNTERS)
+		breeze2d_counters_read(start);
+}
+
+// Account counters of the solve stage since start,
+// and restart them for the next stage.
+static void stage_finish(struct poisson2d_fft_solver_t* solver,
+	int stage, breeze2d_counters* start)
+{
+	if (!(solver->flags & BREEZE2D_POISSON_COUNTERS)) return;
+
+	breeze2d_counters finish;
+	breeze2d_counters_read(&finish);
+	breeze2d_counters_accumulate(&solver->stages[stage], start, &finish);
+	solver->ncalls[stage]++;
+	*start = finish;
+}
+
+// Defines arguments of the parallel loops over rows.
+struct rows_args_t
+{
+	struct poisson2d_fft_solver_t* solver;
+	real *field, *u, *v;
+};
+
+// Extrapolate the right hand side of rows begin .. end - 1
+// beyond X boundaries (quadratically, keeping the compact scheme
+// truncation error of boundary columns at third order),
+// and keep it divided by 12, as weighted by the scheme.
+static void extrapolate_x(void* arg, int part, long begin, long end)
+{
+	struct poisson2d_fft_solver_t* solver =
+		((struct rows_args_t*)arg)->solver;
+	int m = solver->m;
+	real* rhs = solver->rhs;
+
+	for (int j = begin; j < end; j++)
+	{
+		const real* f = rhs + j * solver->ld;
+		if (m >= 3)
+		{
+			solver->xc0[j] = (3.0 * (f[0] - f[1]) + f[2]) / 12.0;
+			solver->xc1[j] = (3.0 * (f[m - 1] - f[m - 2]) + f[m - 3]) / 12.0;
+		}
+		else
+		{
+			solver->xc0[j] = f[0] / 12.0;
+			solver->xc1[j] = f[m - 1] / 12.0;
+		}
+	}
+}
+
+// Zero the X boundary columns of the cosine series of
+// rows begin .. end - 1.
+static void clear_gx(void* arg, int part, long begin, long end)
+{
+	struct poisson2d_fft_solver_t* solver =
+		((struct rows_args_t*)arg)->solver;
+	int m = solver->m;
+	real* gx = solver->gx;
+
+	for (int j = begin; j < end; j++)
+		gx[j * (m + 2)] = gx[j * (m + 2) + m + 1] = 0.0;
+}
+
+// Copy X-derivative of rows begin .. end - 1, dropping
+// the boundary columns.
+static void copy_dphidx(void* arg, int part, long begin, long end)
+{
+	struct poisson2d_fft_solver_t* solver =
+		((struct rows_args_t*)arg)->solver;
+	int m = solver->m;
+	real *gx = solver->gx, *dphidx = solver->dphidx;
+
+	for (int j = begin; j < end; j++)
+		for (int i = 0; i < m; i++)
+			dphidx[i + j * m] = gx[i + 1 + j * (m + 2)];
+}
+
+// Solve 3-diagonal systems for the transformed right hand
+// side frhs (rows ldfrhs elements apart) and boundary conditions,
+// and transform the solution (and its gradient, if requested)
+// back into physical space.
+static void solve_modes(struct poisson2d_fft_solver_t* solver,
+	real* frhs, int ldfrhs)
+{
+	int n = solver->n, m = solver->m;
+	real hx = solver->hx, hy = solver->hy;
+
+	breeze2d_counters start;
+	stage_start(solver, &start);
+
+	if (!solver->dphidx && !solver->dphidy)
+	{
+		// Solve m 3-diagonal systems of n equations
+		// using shutter method. In single buffer mode
+		// the shutter overwrites transformed data in place.
+		shutter(solver, frhs, ldfrhs, solver->rhs, solver->ld,
+			0.5 / (m + 1), 1);
+		stage_finish(solver, BREEZE2D_POISSON_STAGE_SHUTTER, &start);
+
+		// Compute result using inverse transform
+		// on 3-diagonal systems solutions.
+		fft_inverse(solver->plan_main);
+		stage_finish(solver, BREEZE2D_POISSON_STAGE_INVERSE, &start);
+		return;
+	}
+
+	// Same, with gradient coefficients emitted by the shutter
+	// (X boundary columns of the cosine series are zero).
+	struct rows_args_t args = { solver };
+	real* gx = solver->dphidx ? solver->gx : NULL;
+	if (gx)
+		poisson2d_parallel_for(solve_nthreads(solver), n, clear_gx, &args);
+	poisson2d_shutter_grad_r(m, n, hx, hy,
+		frhs, ldfrhs, solver->rhs, solver->ld,
+		solver->alpha, solver->beta,
+		solver->cby, solver->cey, 0.5 / (m + 1),
+		gx, m + 2, solver->dphidy, solve_nthreads(solver));
+	stage_finish(solver, BREEZE2D_POISSON_STAGE_SHUTTER, &start);
+
+	fft_inverse(solver->plan_main);
+
+	if (solver->dphidy)
+		fft_inverse(solver->plan_dy);
+	if (gx)
+	{
+		fft_inverse(solver->plan_dx);
+		poisson2d_parallel_for(solve_nthreads(solver), n, copy_dphidx, &args);
+	}
+	stage_finish(solver, BREEZE2D_POISSON_STAGE_INVERSE, &start);
+}
+
+// Solve with the stages split into tasks: forward transforms
+// of row batches, concurrent with boundary conditions transforms,
+// shutter sweeps of mode blocks over row batches, and inverse
+// transforms of row batches. Each task starts as soon as its
+// inputs are ready: forward sweeps follow forward transforms
+// batch after batch, and the inverse transform of a batch starts
+// once the backward sweeps of all mode blocks have passed it.
+static void solve_pipelined(struct poisson2d_fft_solver_t* solver)
+{
+	int m = solver->m, n = solver->n, ld = solver->ld;
+	int nrows = solver->nrows, nbatches = solver->nbatches;
+	int width = solver->mwidth, nblocks = solver->nblocks;
+	real *rhs = solver->rhs, *solution = solver->solution;
+	real scale = 0.5 / (m + 1);
+
+	for (int r = 0; r < nbatches; r++)
+		solver->remaining[r] = nblocks;
+
+	// Dependency objects are forward transforms of row batches,
+	// followed by sweeps of mode blocks and boundary conditions
+	// transforms.
+	#pragma omp parallel num_threads(solve_nthreads(solver))
+	#pragma omp single
+	{
+		#pragma omp task depend(out: solver->deps[nbatches + nblocks])
+		{
+			fft_forward(solver->plan_bc);
+			fft_forward(solver->plan_ec);
+		}
+
+		for (int r = 0; r < nbatches; r++)
+		{
+			#pragma omp task depend(out: solver->deps[r])
+			fft_forward(solver->plan_rows[r]);
+		}
+
+		// Sweeps of each mode block are chained; transformed
+		// data is swept from solution into rhs, as in the
+		// staged solve, so that inverse transforms of row
+		// batches are out of place as well.
+		for (int b = 0; b < nblocks; b++)
+		{
+			int p0 = b * width, p1 = MIN(p0 + width, m);
+
+			for (int r = 0; r < nbatches; r++)
+			{
+				int j0 = r * nrows, j1 = MIN(j0 + nrows, n);
+				#pragma omp task depend(in: solver->deps[nbatches + nblocks], solver->deps[r]) \
+					depend(inout: solver->deps[nbatches + b])
+				poisson2d_shutter_forward_r(m, solver->hy, solution, ld, rhs, ld,
+					solver->pfactor, solver->cby, p0, p1, j0, j1);
+			}
+
+			for (int r = nbatches - 1; r >= 0; r--)
+			{
+				int j0 = r * nrows, j1 = MIN(j0 + nrows, n);
+				#pragma omp task depend(inout: solver->deps[nbatches + b])
+				{
+					real* next = solver->carry;
+					if (r == nbatches - 1)
+						for (int p = p0; p < p1; p++)
+							next[p] = scale * solver->cey[p];
+
+					poisson2d_shutter_backward_r(m, rhs, ld, solver->pfactor,
+						next, scale, p0, p1, j0, j1);
+
+					// The last mode block passing the row batch
+					// starts its inverse transform.
+					if (!__atomic_sub_fetch(&solver->remaining[r], 1, __ATOMIC_ACQ_REL))
+					{
+						#pragma omp task
+						fft_inverse(solver->plan_rows[r]);
+					}
+				}
+			}
+		}
+	}
 }
 
 // Solve 2D Poisson equation with the given right hand
@@ -130,25 +1051,324 @@ void poisson2d_fft_solve(poisson2d_fft_solver desc)
 {
 	struct poisson2d_fft_solver_t* solver =
 		(struct poisson2d_fft_solver_t*)desc;
-	
+
+	// Swap in measured plans, once ready.
+	upgrade_plans(solver);
+
+	breeze2d_counters solve = { 0 }, start;
+	stage_start(solver, &solve);
+	start = solve;
+
+	// The task graph runs on OpenMP threads only.
+	if (solver->plan_rows && !poisson2d_parallel_external())
+	{
+		solve_pipelined(solver);
+		stage_finish(solver, BREEZE2D_POISSON_STAGE_SOLVE, &solve);
+		return;
+	}
+
+	// Extrapolate the right hand side beyond X boundaries
+	// for the compact scheme, before it is transformed.
+	if (solver->xc0)
+	{
+		struct rows_args_t args = { solver };
+		poisson2d_parallel_for(solve_nthreads(solver), solver->n,
+			extrapolate_x, &args);
+	}
+
+	// Compute coefficients for the right hand side,
+	// keeping them for re-solves, if requested.
+	real* frhs = solver->solution;
+	if (solver->frhs)
+	{
+		fft_forward(solver->plan_cache);
+		frhs = solver->frhs;
+		solver->cached = 1;
+	}
+	else
+		fft_forward(solver->plan_main);
+
+	// Compute coefficients for boundary conditions.
+	fft_forward(solver->plan_bc);
+	fft_forward(solver->plan_ec);
+	stage_finish(solver, BREEZE2D_POISSON_STAGE_FORWARD, &start);
+
+	solve_modes(solver, frhs,
+		(frhs == solver->frhs) ? solver->m : solver->ld);
+	stage_finish(solver, BREEZE2D_POISSON_STAGE_SOLVE, &solve);
+}
+
+// Solve 2D Poisson equation with the right hand side
+// of the previous solve, and updated boundary conditions.
+// The main forward transform is skipped: only boundary
+// conditions are transformed.
+void poisson2d_fft_solve_bc(poisson2d_fft_solver desc)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	upgrade_plans(solver);
+
+	if (!solver->cached)
+	{
+		breeze2d_set_error(BREEZE2D_RHS_NOT_CACHED);
+		return;
+	}
+
+	fft_forward(solver->plan_bc);
+	fft_forward(solver->plan_ec);
+
+	// Shutter only reads the cached coefficients,
+	// so they stay valid for the next re-solve.
+	solve_modes(solver, solver->frhs, solver->m);
+}
+
+// Get statistics of solve stages.
+void poisson2d_fft_solver_get_stats(poisson2d_fft_solver desc,
+	breeze2d_poisson_stats* stats)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	double npoints = (double)solver->m * solver->n;
+	for (int stage = 0; stage < BREEZE2D_POISSON_NSTAGES; stage++)
+	{
+		stats->ncalls[stage] = solver->ncalls[stage];
+		stats->counters[stage] = solver->stages[stage];
+		breeze2d_counters_get_metrics(&solver->stages[stage],
+			npoints * solver->ncalls[stage], &stats->metrics[stage]);
+	}
+}
+
+// Reset statistics of solve stages.
+void poisson2d_fft_solver_reset_stats(poisson2d_fft_solver desc)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	memset(solver->stages, 0, sizeof(solver->stages));
+	memset(solver->ncalls, 0, sizeof(solver->ncalls));
+}
+
+// Zero the right hand side rows begin .. end - 1.
+static void clear_rhs(void* arg, int part, long begin, long end)
+{
+	struct poisson2d_fft_solver_t* solver =
+		((struct rows_args_t*)arg)->solver;
+	int m = solver->m, ld = solver->ld;
+	real* rhs = solver->rhs;
+
+	for (int j = begin; j < end; j++)
+		for (int i = 0; i < m; i++)
+			rhs[i + j * ld] = 0.0;
+}
+
+// Defines the relative cost of point source transform (sine
+// evaluation) versus forward transform of a single element.
+// The sparse solve switches to the dense path, when point
+// sources transform costs more than forward transform.
+#define SPARSE_CROSSOVER 8
+
+// Solve 2D Poisson equation with the right hand side being
+// zero except the specified point sources. The forward transform
+// is replaced by the direct evaluation of point sources sine
+// transforms within the shutter.
+void poisson2d_fft_solve_sparse(poisson2d_fft_solver desc,
+	int nsources, const int* is, const int* js, const real* q)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	upgrade_plans(solver);
+
 	int n = solver->n, m = solver->m;
 	real hx = solver->hx, hy = solver->hy;
 
-	// Compute coefficients for the right hand side.
-	fft_forward(solver->plan_main);
+	// Too many sources, gradient requested, variable
+	// steps Y grid, or compact scheme: use the dense path.
+	if ((nsources * SPARSE_CROSSOVER > n * log2(m + 1)) ||
+		solver->dphidx || solver->dphidy || solver->stretched ||
+		(solver->flags & BREEZE2D_POISSON_COMPACT4))
+	{
+		real* rhs = solver->rhs;
+		int ld = solver->ld;
+		struct rows_args_t args = { solver };
+		poisson2d_parallel_for(solve_nthreads(solver), n, clear_rhs, &args);
+		for (int s = 0; s < nsources; s++)
+			rhs[is[s] + js[s] * ld] += q[s];
+		poisson2d_fft_solve(desc);
+		return;
+	}
+
+	// Cached transform is not the right hand side anymore.
+	solver->cached = 0;
 
-	// Compute coefficients for boundary conditions.
 	fft_forward(solver->plan_bc);
 	fft_forward(solver->plan_ec);
 
-	// Solve m/2 3-diagonal systems of n equations
-	// using shutter method.	
-	poisson2d_shutter_r(m, n, hx, hy,
-		solver->solution, solver->rhs,
-		solver->alpha, solver->beta,
-		solver->cby, solver->cey);
+	poisson2d_shutter_sparse_r(m, n, hx, hy,
+		nsources, is, js, q, solver->rhs, solver->ld,
+		solver->alpha, solver->beta, solver->factor,
+		solver->cby, solver->cey, 0.5 / (m + 1),
+		solve_nthreads(solver));
 
-	// Compute result using inverse transform
-	// on 3-diagonal systems solutions.
 	fft_inverse(solver->plan_main);
 }
+
+// Check the arrays given for spectral space operation
+// can be processed by the solver fft plan.
+static int check_arrays(struct poisson2d_fft_solver_t* solver,
+	real* in, real* out)
+{
+	if ((in == out) != (solver->rhs == solver->solution))
+	{
+		breeze2d_set_error(BREEZE2D_INCOMPATIBLE_ARRAYS);
+		return 0;
+	}
+	return 1;
+}
+
+// Transform the specified field into spectral space
+// (sine transform by X, unnormalized).
+void poisson2d_fft_forward(poisson2d_fft_solver desc,
+	real* field, real* spectral)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	upgrade_plans(solver);
+
+	if (!check_arrays(solver, field, spectral)) return;
+
+	fft_forward_at(solver->plan_main, field, spectral);
+}
+
+// Solve 2D Poisson equation with the given right hand
+// side in spectral space, using shutter by Y only.
+void poisson2d_fft_solve_spectral(poisson2d_fft_solver desc,
+	real* spectral_rhs, real* spectral_solution)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	// Compute coefficients for boundary conditions.
+	fft_forward(solver->plan_bc);
+	fft_forward(solver->plan_ec);
+
+	// Keep the solution unnormalized, as the right hand side.
+	shutter(solver, spectral_rhs, solver->ld,
+		spectral_solution, solver->ld, 1.0, 0);
+}
+
+// Normalize the inverse transform of field rows begin .. end - 1.
+static void normalize(void* arg, int part, long begin, long end)
+{
+	struct rows_args_t* args = (struct rows_args_t*)arg;
+	int m = args->solver->m, ld = args->solver->ld;
+	real* field = args->field;
+
+	real invm = 0.5 / (m + 1);
+	for (int j = begin; j < end; j++)
+		for (int i = 0; i < m; i++)
+			field[i + j * ld] *= invm;
+}
+
+// Transform the specified spectral space field back
+// into physical space.
+void poisson2d_fft_inverse(poisson2d_fft_solver desc,
+	real* spectral, real* field)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	upgrade_plans(solver);
+
+	if (!check_arrays(solver, spectral, field)) return;
+
+	fft_inverse_at(solver->plan_main, spectral, field);
+
+	struct rows_args_t args = { solver, field };
+	poisson2d_parallel_for(solve_nthreads(solver), solver->n, normalize, &args);
+}
+
+// Compute divergence of the staggered velocity field in cell
+// centers of rows begin .. end - 1, written straight into
+// the right hand side.
+static void divergence(void* arg, int part, long begin, long end)
+{
+	struct rows_args_t* args = (struct rows_args_t*)arg;
+	struct poisson2d_fft_solver_t* solver = args->solver;
+	int m = solver->m;
+	real invhx = 1.0 / solver->hx, invhy = 1.0 / solver->hy;
+	real *rhs = solver->rhs, *u = args->u, *v = args->v;
+
+	for (int j = begin; j < end; j++)
+	{
+		real* uj = u + j * (m + 1);
+		real* vj = v + j * m;
+		real* rhsj = rhs + j * solver->ld;
+		for (int i = 0; i < m; i++)
+			rhsj[i] = (uj[i + 1] - uj[i]) * invhx +
+				(vj[i + m] - vj[i]) * invhy;
+	}
+}
+
+// Subtract the potential gradient on cell faces of rows
+// begin .. end - 1 in a single pass over potential: by X
+// potential beyond the domain is zero, by Y it is given
+// by the boundary conditions.
+static void subtract_gradient(void* arg, int part, long begin, long end)
+{
+	struct rows_args_t* args = (struct rows_args_t*)arg;
+	struct poisson2d_fft_solver_t* solver = args->solver;
+	int n = solver->n, m = solver->m;
+	real invhx = 1.0 / solver->hx, invhy = 1.0 / solver->hy;
+	real *phi = solver->solution, *u = args->u, *v = args->v;
+	real *by = solver->by, *ey = solver->ey;
+
+	for (int j = begin; j < end; j++)
+	{
+		real* uj = u + j * (m + 1);
+		real* vj = v + j * m;
+		real* phij = phi + j * solver->ld;
+		real* below = j ? phij - solver->ld : by;
+
+		real left = 0.0;
+		for (int i = 0; i < m; i++)
+		{
+			uj[i] -= (phij[i] - left) * invhx;
+			vj[i] -= (phij[i] - below[i]) * invhy;
+			left = phij[i];
+		}
+		uj[m] += left * invhx;
+
+		// The top faces row.
+		if (j == n - 1)
+			for (int i = 0; i < m; i++)
+				vj[i + m] -= (ey[i] - phij[i]) * invhy;
+	}
+}
+
+// Project the staggered velocity field onto divergence-free
+// fields: solve for potential with divergence as the right hand
+// side, and subtract the potential gradient.
+void poisson2d_fft_project(poisson2d_fft_solver desc, real* u, real* v)
+{
+	struct poisson2d_fft_solver_t* solver =
+		(struct poisson2d_fft_solver_t*)desc;
+
+	if (solver->stretched || (solver->flags & BREEZE2D_POISSON_COMPACT4))
+	{
+		breeze2d_set_error(BREEZE2D_INCOMPATIBLE_OPTIONS);
+		return;
+	}
+
+	struct rows_args_t args = { solver, NULL, u, v };
+	poisson2d_parallel_for(solve_nthreads(solver), solver->n,
+		divergence, &args);
+
+	poisson2d_fft_solve(desc);
+
+	poisson2d_parallel_for(solve_nthreads(solver), solver->n,
+		subtract_gradient, &args);
+}
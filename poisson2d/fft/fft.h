@@ -42,13 +42,58 @@ typedef void* poisson2d_fft_solver;
  * @param by - The Y lower side boundary n x 1 array
  * @param ey - The Y upper side boundary n x 1 array
  * @param rhs - The right hand side m x n array
- * @param solution - The problem solution m x n array
+ * @param solution - The problem solution m x n array,
+ * or rhs for in-place solve
+ * @param ld - The distance between rhs and solution rows,
+ * at least m
+ * @param flags - The BREEZE2D_POISSON_* option flags
  * @return The solver configuration.
  */
 poisson2d_fft_solver poisson2d_fft_solver_init(
 	unsigned int m, unsigned int n, real hx, real hy,
 	real* bx, real* ex, real* by, real* ey,
-	real* rhs, real* solution);
+	real* rhs, real* solution, unsigned int ld, unsigned int flags);
+
+/**
+ * Get the size of workspace memory used by 2D Poisson
+ * equation FFT solver of the specified problem size.
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param flags - The BREEZE2D_POISSON_* option flags
+ * @return The workspace size in bytes.
+ */
+size_t poisson2d_fft_solver_workspace_size(
+	unsigned int m, unsigned int n, unsigned int flags);
+
+/**
+ * Initialize 2D Poisson equation FFT solver for the
+ * specified problem size and data arrays, placing all
+ * solver data into the caller-provided workspace.
+ * No heap memory is allocated by the solver after init,
+ * except the internal data of FFT library plans.
+ * @param m - The problem X grid dimension, excluding boundaries
+ * @param n - The problem Y grid dimension, excluding boundaries
+ * @param hx - The problem X grid step
+ * @param hy - The problem Y grid step
+ * @param bx - The X left side boundary m x 1 array
+ * @param ex - The X right side boundary m x 1 array
+ * @param by - The Y lower side boundary n x 1 array
+ * @param ey - The Y upper side boundary n x 1 array
+ * @param rhs - The right hand side m x n array
+ * @param solution - The problem solution m x n array
+ * @param ld - The distance between rhs and solution rows,
+ * at least m
+ * @param flags - The BREEZE2D_POISSON_* option flags
+ * @param workspace - The workspace memory, aligned to 64 bytes
+ * @param size - The workspace size, at least
+ * poisson2d_fft_solver_workspace_size(m, n, flags) bytes
+ * @return The solver configuration.
+ */
+poisson2d_fft_solver poisson2d_fft_solver_init_workspace(
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* bx, real* ex, real* by, real* ey,
+	real* rhs, real* solution, unsigned int ld, unsigned int flags,
+	void* workspace, size_t size);
 
 /**
  * Release resources used by the specified fft solver instance.
@@ -56,14 +101,143 @@ poisson2d_fft_solver poisson2d_fft_solver_init(
  */
 void poisson2d_fft_solver_dispose(poisson2d_fft_solver desc);
 
+/**
+ * Replace the right hand side and solution arrays with the
+ * specified ones, having the same alignment (modulo 64 bytes)
+ * and in-place property, as the arrays solver was created for.
+ * @param desc - The solver configuration
+ * @param rhs - The right hand side m x n array
+ * @param solution - The problem solution m x n array,
+ * or rhs for in-place solve
+ */
+void poisson2d_fft_solver_set_arrays(poisson2d_fft_solver desc,
+	real* rhs, real* solution);
+
+/**
+ * Get statistics of solve stages of solver initialized with
+ * BREEZE2D_POISSON_COUNTERS flag.
+ * @param desc - The solver configuration
+ * @param stats - The statistics (filled on exit)
+ */
+void poisson2d_fft_solver_get_stats(poisson2d_fft_solver desc,
+	breeze2d_poisson_stats* stats);
+
+/**
+ * Reset statistics of solve stages.
+ * @param desc - The solver configuration
+ */
+void poisson2d_fft_solver_reset_stats(poisson2d_fft_solver desc);
+
+/**
+ * Set arrays to output the solution gradient (central
+ * differences) from each subsequent solve. Requires solver
+ * initialized with BREEZE2D_POISSON_GRADIENT flag.
+ * @param desc - The solver configuration
+ * @param dphidx - The X-derivative m x n array, or NULL
+ * @param dphidy - The Y-derivative m x n array, or NULL
+ */
+void poisson2d_fft_solver_set_gradient(poisson2d_fft_solver desc,
+	real* dphidx, real* dphidy);
+
+/**
+ * Set the variable steps of Y grid, and factorize 3-diagonal
+ * systems for them. Requires solver initialized with
+ * BREEZE2D_POISSON_STRETCHED_Y flag.
+ * @param desc - The solver configuration
+ * @param hy - The Y grid steps (n + 1) x 1 array
+ */
+void poisson2d_fft_solver_set_grid_y(poisson2d_fft_solver desc,
+	const real* hy);
+
 /**
  * Solve 2D Poisson equation with the given right hand
  * side using 1D fast Fourier transform by X and shutter by Y.
  * Place result to the output array specified in solver
- * configuration.
+ * configuration. If rhs and solution are the same array,
+ * the solve is performed in place: transforms use in-place
+ * plans, and shutter overwrites its input.
  * @param desc - The solver configuration
  */
 void poisson2d_fft_solve(poisson2d_fft_solver desc);
 
+/**
+ * Solve 2D Poisson equation with the right hand side of
+ * the previous poisson2d_fft_solve, and the current boundary
+ * conditions: only boundary conditions are transformed, followed
+ * by shutter and inverse transform. Requires solver initialized
+ * with BREEZE2D_POISSON_CACHE_RHS flag.
+ * @param desc - The solver configuration
+ */
+void poisson2d_fft_solve_bc(poisson2d_fft_solver desc);
+
+/**
+ * Solve 2D Poisson equation with the right hand side being
+ * zero except the specified point sources. Unless the number
+ * of sources is large, the forward transform is replaced by
+ * direct evaluation of sources transforms. Shutter uses the
+ * precomputed factorization, if solver is initialized with
+ * BREEZE2D_POISSON_SPARSE flag.
+ * @param desc - The solver configuration
+ * @param nsources - The number of point sources
+ * @param is - The X indexes of point sources
+ * @param js - The Y indexes of point sources
+ * @param q - The right hand side values in point sources
+ */
+void poisson2d_fft_solve_sparse(poisson2d_fft_solver desc,
+	int nsources, const int* is, const int* js, const real* q);
+
+/**
+ * Transform the specified m x n field into spectral space:
+ * unnormalized sine transform by X of each row (FFTW RODFT00).
+ * Arrays must have the same alignment as the solver rhs
+ * and solution, and be the same array, if and only if
+ * rhs and solution are the same array.
+ * @param desc - The solver configuration
+ * @param field - The physical space field
+ * @param spectral - The spectral space field (filled on exit)
+ */
+void poisson2d_fft_forward(poisson2d_fft_solver desc,
+	real* field, real* spectral);
+
+/**
+ * Solve 2D Poisson equation with the given right hand
+ * side in spectral space, using shutter by Y only.
+ * Boundary conditions are taken from the arrays
+ * specified in solver configuration. The compact scheme
+ * right hand side is assumed to vanish beyond X boundaries.
+ * @param desc - The solver configuration
+ * @param spectral_rhs - The spectral space right hand side
+ * @param spectral_solution - The spectral space solution
+ * (filled on exit), may be the same array as spectral_rhs
+ */
+void poisson2d_fft_solve_spectral(poisson2d_fft_solver desc,
+	real* spectral_rhs, real* spectral_solution);
+
+/**
+ * Transform the specified m x n spectral space field
+ * back into physical space, with normalization.
+ * Arrays follow the same rules as in poisson2d_fft_forward.
+ * @param desc - The solver configuration
+ * @param spectral - The spectral space field (destroyed)
+ * @param field - The physical space field (filled on exit)
+ */
+void poisson2d_fft_inverse(poisson2d_fft_solver desc,
+	real* spectral, real* field);
+
+/**
+ * Project the staggered velocity field onto divergence-free
+ * fields: solve for potential with the field divergence as
+ * the right hand side, and subtract the potential gradient.
+ * The gradient is subtracted in a pass after the solve, not fused
+ * into the inverse transform: that is a single batched plan over
+ * all rows with no per-row hook, and the gradient of row j needs
+ * row j - 1 as well. Fusing would take row batch plans, as in the
+ * pipelined solve, for one read of the potential saved.
+ * @param desc - The solver configuration
+ * @param u - The X velocity (m + 1) x n array on cell X faces
+ * @param v - The Y velocity m x (n + 1) array on cell Y faces
+ */
+void poisson2d_fft_project(poisson2d_fft_solver desc, real* u, real* v);
+
 #endif // FFT_H
 
@@ -0,0 +1,490 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "wrapper.h"
+#include "shutter.h"
+#include "../parallel.h"
+
+#include <stdlib.h>
+
+#ifdef HAVE_SINGLE
+#define MPI_REAL_T MPI_FLOAT
+#endif
+#ifdef HAVE_DOUBLE
+#define MPI_REAL_T MPI_DOUBLE
+#endif
+
+// The maximum number of row batches of a slab: batches are
+// transformed one after another, each sent to other processes
+// while the next one is transformed.
+#define MAX_BATCHES 4
+
+// The tag of backward transpose messages, forward transpose
+// messages are tagged by the row batch index.
+#define TAG_BACKWARD MAX_BATCHES
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// Defines internal structure for distributed fft solver.
+struct poisson2d_mpi_solver_t
+{
+	MPI_Comm comm;
+	int rank, nranks;
+	unsigned int m, n;
+	real hx, hy;
+
+	// Slabs of the right hand side and solution of this process.
+	// The right hand side also receives the backward transpose.
+	real *rhs, *solution;
+
+	// The first row and first mode of each process (and the
+	// total number), and the number of modes of each process.
+	int *rows, *modes, *nmodes;
+
+	// Boundary conditions by Y of the first and last processes,
+	// their transforms there, and the transforms of modes of
+	// this process.
+	real *by, *ey, *cby, *cey;
+	real *lby, *ley;
+	fft_plan *plan_bc, *plan_ec;
+
+	// Transform plans of row batches of this slab.
+	int nbatches;
+	fft_plan** plan_rows;
+
+	// All rows of the modes of this process, after transpose,
+	// width modes per row, and their shutter factorization. The
+	// backward sweep carries the solution of the row above in next.
+	int width;
+	real *spectral, *factor, *next;
+
+	// Modes of each process in each row batch of this slab,
+	// and in all rows of this slab (nbatches x nranks and nranks
+	// strided datatypes).
+	MPI_Datatype *batch_types, *slab_types;
+
+	// Requests of transpose receives and sends, and of boundary
+	// conditions scatters.
+	MPI_Request *recvs, *sends, bcs[2];
+
+	int nthreads;
+
+	// Time spent in stages, accumulated over solves.
+	double transform, shutter, wait;
+};
+
+// Split count elements into nparts contiguous parts,
+// as poisson2d_parallel_for does.
+static void split(int count, int nparts, int part, int* first, int* size)
+{
+	int chunk = count / nparts, rest = count % nparts;
+	*first = part * chunk + MIN(part, rest);
+	*size = chunk + (part < rest ? 1 : 0);
+}
+
+// Get the number of row batches of a slab of count rows.
+static int batches(int count)
+{
+	return MIN(MAX_BATCHES, count);
+}
+
+// Get the rows of the grid owned by the calling process.
+void breeze2d_poisson_mpi_get_rows(MPI_Comm comm, unsigned int n,
+	unsigned int* first, unsigned int* count)
+{
+	int rank, nranks;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &nranks);
+
+	int f, c;
+	split(n, nranks, rank, &f, &c);
+	*first = f;
+	*count = c;
+}
+
+// Release the solver resources created so far, and the solver.
+static void release(struct poisson2d_mpi_solver_t* solver)
+{
+	if (solver->plan_rows)
+		for (int b = 0; b < solver->nbatches; b++)
+			if (solver->plan_rows[b])
+				fft_dispose(solver->plan_rows[b]);
+	free(solver->plan_rows);
+	if (solver->plan_bc)
+		fft_dispose(solver->plan_bc);
+	if (solver->plan_ec)
+		fft_dispose(solver->plan_ec);
+	fft_free(solver->cby);
+	fft_free(solver->cey);
+	fft_free(solver->spectral);
+	fft_free(solver->factor);
+	fft_free(solver->lby);
+
+	if (solver->batch_types && solver->slab_types)
+		for (int r = 0; r < solver->nranks; r++)
+		{
+			for (int b = 0; b < solver->nbatches; b++)
+				if (solver->batch_types[b * solver->nranks + r] != MPI_DATATYPE_NULL)
+					MPI_Type_free(&solver->batch_types[b * solver->nranks + r]);
+			if (solver->slab_types[r] != MPI_DATATYPE_NULL)
+				MPI_Type_free(&solver->slab_types[r]);
+		}
+	free(solver->batch_types);
+	free(solver->slab_types);
+	free(solver->recvs);
+	free(solver->sends);
+	free(solver->rows);
+	free(solver->modes);
+	free(solver->nmodes);
+	MPI_Comm_free(&solver->comm);
+	free(solver);
+}
+
+// Create plans, buffers and datatypes of this process.
+// Returns 0 on success, or the error status.
+static int setup(struct poisson2d_mpi_solver_t* solver)
+{
+	int rank = solver->rank, nranks = solver->nranks;
+	unsigned int m = solver->m, n = solver->n;
+	real *rhs = solver->rhs, *solution = solver->solution;
+
+	solver->rows = (int*)malloc(sizeof(int) * (nranks + 1));
+	solver->modes = (int*)malloc(sizeof(int) * (nranks + 1));
+	solver->nmodes = (int*)malloc(sizeof(int) * nranks);
+	if (!solver->rows || !solver->modes || !solver->nmodes)
+		return BREEZE2D_OUT_OF_MEMORY;
+	for (int r = 0; r < nranks; r++)
+	{
+		int size;
+		split(n, nranks, r, &solver->rows[r], &size);
+		split(m, nranks, r, &solver->modes[r], &solver->nmodes[r]);
+	}
+	solver->rows[nranks] = n;
+	solver->modes[nranks] = m;
+	int first = solver->rows[rank];
+	int count = solver->rows[rank + 1] - first;
+	int width = solver->nmodes[rank];
+	solver->width = width;
+
+	fft_init_threads();
+	solver->nthreads = poisson2d_parallel_nthreads();
+	fft_plan_with_nthreads(solver->nthreads);
+
+	// Plan transforms of row batches, and of boundary conditions
+	// on the processes they belong to.
+	solver->nbatches = batches(count);
+	solver->plan_rows = (fft_plan**)calloc(
+		solver->nbatches + 1, sizeof(fft_plan*));
+	if (!solver->plan_rows)
+		return BREEZE2D_OUT_OF_MEMORY;
+	for (int b = 0; b < solver->nbatches; b++)
+	{
+		int bfirst, bsize;
+		split(count, solver->nbatches, b, &bfirst, &bsize);
+		solver->plan_rows[b] = fft_create_multi(m, bsize,
+			rhs + bfirst * m, solution + bfirst * m, m, m,
+			FFT_RODFT00, FFT_MEASURE);
+		if (!solver->plan_rows[b])
+			return BREEZE2D_FFT_PLAN_CREATION_FAILED;
+	}
+	if (rank == 0)
+	{
+		solver->cby = (real*)fft_malloc(sizeof(real) * m);
+		if (!solver->cby)
+			return BREEZE2D_OUT_OF_MEMORY;
+		solver->plan_bc = fft_create(m, solver->by, solver->cby,
+			FFT_RODFT00, FFT_MEASURE);
+		if (!solver->plan_bc)
+			return BREEZE2D_FFT_PLAN_CREATION_FAILED;
+	}
+	if (rank == nranks - 1)
+	{
+		solver->cey = (real*)fft_malloc(sizeof(real) * m);
+		if (!solver->cey)
+			return BREEZE2D_OUT_OF_MEMORY;
+		solver->plan_ec = fft_create(m, solver->ey, solver->cey,
+			FFT_RODFT00, FFT_MEASURE);
+		if (!solver->plan_ec)
+			return BREEZE2D_FFT_PLAN_CREATION_FAILED;
+	}
+
+	// Allocate the transposed modes and their boundary conditions,
+	// and factorize their 3-diagonal systems.
+	solver->spectral = (real*)fft_malloc(sizeof(real) * n * width);
+	solver->factor = (real*)fft_malloc(sizeof(real) * n * width);
+	solver->lby = (real*)fft_malloc(sizeof(real) * 3 * width);
+	if (width && (!solver->spectral || !solver->factor || !solver->lby))
+		return BREEZE2D_OUT_OF_MEMORY;
+	solver->ley = solver->lby + width;
+	solver->next = solver->ley + width;
+	poisson2d_shutter_factor_modes_r(m, n, solver->hx, solver->hy,
+		solver->modes[rank], solver->modes[rank + 1],
+		solver->factor, solver->nthreads);
+
+	solver->recvs = (MPI_Request*)malloc(
+		sizeof(MPI_Request) * nranks * MAX_BATCHES);
+	solver->sends = (MPI_Request*)malloc(
+		sizeof(MPI_Request) * nranks * MAX_BATCHES);
+	if (!solver->recvs || !solver->sends)
+		return BREEZE2D_OUT_OF_MEMORY;
+
+	// Describe modes of other processes in this slab.
+	int ntypes = (solver->nbatches + 1) * nranks;
+	solver->batch_types = (MPI_Datatype*)malloc(
+		sizeof(MPI_Datatype) * ntypes);
+	solver->slab_types = (MPI_Datatype*)malloc(
+		sizeof(MPI_Datatype) * nranks);
+	if (!solver->batch_types || !solver->slab_types)
+		return BREEZE2D_OUT_OF_MEMORY;
+	for (int i = 0; i < ntypes; i++)
+		solver->batch_types[i] = MPI_DATATYPE_NULL;
+	for (int r = 0; r < nranks; r++)
+		solver->slab_types[r] = MPI_DATATYPE_NULL;
+	for (int r = 0; r < nranks; r++)
+	{
+		for (int b = 0; b < solver->nbatches; b++)
+		{
+			int bfirst, bsize;
+			split(count, solver->nbatches, b, &bfirst, &bsize);
+			MPI_Datatype* type = &solver->batch_types[b * nranks + r];
+			MPI_Type_vector(bsize, solver->nmodes[r], m, MPI_REAL_T, type);
+			MPI_Type_commit(type);
+		}
+		MPI_Type_vector(count, solver->nmodes[r], m, MPI_REAL_T,
+			&solver->slab_types[r]);
+		MPI_Type_commit(&solver->slab_types[r]);
+	}
+
+	return 0;
+}
+
+// Initialize distributed 2D Poisson equation solver.
+breeze2d_poisson_mpi_solver breeze2d_poisson_mpi_solver_init(MPI_Comm comm,
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* by, real* ey, real* rhs, real* solution)
+{
+	// Communicator is duplicated by all processes, even if
+	// allocation fails on some, as the duplication is collective.
+	MPI_Comm dup;
+	MPI_Comm_dup(comm, &dup);
+
+	int status = BREEZE2D_OUT_OF_MEMORY;
+	struct poisson2d_mpi_solver_t* solver =
+		(struct poisson2d_mpi_solver_t*)calloc(1,
+			sizeof(struct poisson2d_mpi_solver_t));
+	if (solver)
+	{
+		solver->comm = dup;
+		MPI_Comm_rank(dup, &solver->rank);
+		MPI_Comm_size(dup, &solver->nranks);
+		solver->m = m; solver->n = n; solver->hx = hx; solver->hy = hy;
+		solver->rhs = rhs; solver->solution = solution;
+		solver->by = by; solver->ey = ey;
+		status = setup(solver);
+	}
+
+	// Processes agree on success, so that either all of them
+	// return the solver, or none does.
+	int failed;
+	MPI_Allreduce(&status, &failed, 1, MPI_INT, MPI_MAX, dup);
+	if (failed)
+	{
+		if (solver)
+			release(solver);
+		else
+			MPI_Comm_free(&dup);
+		breeze2d_set_error(failed);
+		return NULL;
+	}
+
+	return (breeze2d_poisson_mpi_solver)solver;
+}
+
+// Defines arguments of the parallel loop over modes of sweeps.
+struct sweep_args_t
+{
+	struct poisson2d_mpi_solver_t* solver;
+	int j0, j1;
+	real scale;
+};
+
+// Sweep forward over rows j0 .. j1 - 1 for modes begin .. end - 1.
+static void forward_part(void* arg, int part, long begin, long end)
+{
+	struct sweep_args_t* args = (struct sweep_args_t*)arg;
+	struct poisson2d_mpi_solver_t* solver = args->solver;
+	poisson2d_shutter_forward_r(solver->width, solver->hy,
+		solver->spectral, solver->width, solver->spectral, solver->width,
+		solver->factor, solver->lby, begin, end, args->j0, args->j1);
+}
+
+// Sweep backward over rows j1 - 1 .. j0 for modes begin .. end - 1.
+static void backward_part(void* arg, int part, long begin, long end)
+{
+	struct sweep_args_t* args = (struct sweep_args_t*)arg;
+	struct poisson2d_mpi_solver_t* solver = args->solver;
+	poisson2d_shutter_backward_r(solver->width,
+		solver->spectral, solver->width, solver->factor,
+		solver->next, args->scale, begin, end, args->j0, args->j1);
+}
+
+// Wait for the requests, accounting the time.
+static void wait_all(struct poisson2d_mpi_solver_t* solver,
+	int count, MPI_Request* requests)
+{
+	double start = MPI_Wtime();
+	MPI_Waitall(count, requests, MPI_STATUSES_IGNORE);
+	solver->wait += MPI_Wtime() - start;
+}
+
+// Solve 2D Poisson equation with the given right hand side.
+// Row batches of the slab are transformed and sent to owners
+// of their modes one after another. Forward sweeps start with
+// the batches of lower slabs, as soon as they arrive, and
+// backward sweeps send the solution of each slab to its owner,
+// as soon as they pass it, starting from the top slab.
+void breeze2d_poisson_mpi_solve(breeze2d_poisson_mpi_solver desc)
+{
+	struct poisson2d_mpi_solver_t* solver =
+		(struct poisson2d_mpi_solver_t*)desc;
+
+	MPI_Comm comm = solver->comm;
+	int rank = solver->rank, nranks = solver->nranks;
+	int m = solver->m, width = solver->width;
+	int first = solver->rows[rank];
+	int count = solver->rows[rank + 1] - first;
+	int nthreads = MIN(solver->nthreads, poisson2d_parallel_nthreads());
+
+	// Receive modes of this process from batches of all slabs.
+	int nrecvs = 0;
+	for (int r = 0; r < nranks; r++)
+	{
+		int rcount = solver->rows[r + 1] - solver->rows[r];
+		int nbatches = batches(rcount);
+		for (int b = 0; b < nbatches; b++)
+		{
+			int bfirst, bsize;
+			split(rcount, nbatches, b, &bfirst, &bsize);
+			MPI_Irecv(solver->spectral + (solver->rows[r] + bfirst) * width,
+				bsize * width, MPI_REAL_T, r, b, comm, &solver->recvs[nrecvs++]);
+		}
+	}
+
+	// Transform and scatter boundary conditions.
+	double start = MPI_Wtime();
+	if (rank == 0)
+		fft_forward(solver->plan_bc);
+	if (rank == nranks - 1)
+		fft_forward(solver->plan_ec);
+	solver->transform += MPI_Wtime() - start;
+	MPI_Iscatterv(solver->cby, solver->nmodes, solver->modes, MPI_REAL_T,
+		solver->lby, width, MPI_REAL_T, 0, comm, &solver->bcs[0]);
+	MPI_Iscatterv(solver->cey, solver->nmodes, solver->modes, MPI_REAL_T,
+		solver->ley, width, MPI_REAL_T, nranks - 1, comm, &solver->bcs[1]);
+
+	// Transform row batches, sending each to all processes.
+	int nsends = 0;
+	for (int b = 0; b < solver->nbatches; b++)
+	{
+		int bfirst, bsize;
+		split(count, solver->nbatches, b, &bfirst, &bsize);
+		start = MPI_Wtime();
+		fft_forward(solver->plan_rows[b]);
+		solver->transform += MPI_Wtime() - start;
+		for (int r = 0; r < nranks; r++)
+			MPI_Isend(solver->solution + bfirst * m + solver->modes[r], 1,
+				solver->batch_types[b * nranks + r], r, b, comm,
+				&solver->sends[nsends++]);
+	}
+
+	// Sweep forward batch after batch, bottom to top.
+	wait_all(solver, 1, &solver->bcs[0]);
+	struct sweep_args_t args = { solver };
+	for (int r = 0, k = 0; r < nranks; r++)
+	{
+		int rcount = solver->rows[r + 1] - solver->rows[r];
+		int nbatches = batches(rcount);
+		for (int b = 0; b < nbatches; b++, k++)
+		{
+			int bfirst, bsize;
+			split(rcount, nbatches, b, &bfirst, &bsize);
+			wait_all(solver, 1, &solver->recvs[k]);
+			start = MPI_Wtime();
+			args.j0 = solver->rows[r] + bfirst;
+			args.j1 = args.j0 + bsize;
+			poisson2d_parallel_for(nthreads, width, forward_part, &args);
+			solver->shutter += MPI_Wtime() - start;
+		}
+	}
+
+	// The slab is received back into the right hand side, which
+	// may be the solution array being sent.
+	wait_all(solver, nsends, solver->sends);
+	for (int r = 0; r < nranks; r++)
+		MPI_Irecv(solver->rhs + solver->modes[r], 1, solver->slab_types[r],
+			r, TAG_BACKWARD, comm, &solver->recvs[r]);
+
+	// Sweep backward slab after slab, top to bottom, sending
+	// each slab back to its process.
+	wait_all(solver, 1, &solver->bcs[1]);
+	real scale = 0.5 / (m + 1);
+	start = MPI_Wtime();
+	for (int p = 0; p < width; p++)
+		solver->next[p] = scale * solver->ley[p];
+	args.scale = scale;
+	for (int r = nranks - 1; r >= 0; r--)
+	{
+		args.j0 = solver->rows[r];
+		args.j1 = solver->rows[r + 1];
+		poisson2d_parallel_for(nthreads, width, backward_part, &args);
+		MPI_Isend(solver->spectral + args.j0 * width,
+			(args.j1 - args.j0) * width, MPI_REAL_T, r, TAG_BACKWARD, comm,
+			&solver->sends[r]);
+	}
+	solver->shutter += MPI_Wtime() - start;
+
+	// Compute result using inverse transform.
+	wait_all(solver, nranks, solver->recvs);
+	start = MPI_Wtime();
+	for (int b = 0; b < solver->nbatches; b++)
+		fft_inverse(solver->plan_rows[b]);
+	solver->transform += MPI_Wtime() - start;
+
+	// The transposed modes are reused by the next solve.
+	wait_all(solver, nranks, solver->sends);
+}
+
+// Get the time spent in solves by stage.
+void breeze2d_poisson_mpi_get_times(breeze2d_poisson_mpi_solver desc,
+	double* transform, double* shutter, double* wait)
+{
+	struct poisson2d_mpi_solver_t* solver =
+		(struct poisson2d_mpi_solver_t*)desc;
+
+	*transform = solver->transform;
+	*shutter = solver->shutter;
+	*wait = solver->wait;
+}
+
+// Release resources used by the specified solver.
+void breeze2d_poisson_mpi_solver_dispose(breeze2d_poisson_mpi_solver desc)
+{
+	release((struct poisson2d_mpi_solver_t*)desc);
+}
@@ -0,0 +1,515 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include "wrapper.h"
+#include "shutter.h"
+#include "../parallel.h"
+
+#include <errno.h>
+#include <math.h>
+#include <omp.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// The number of band buffers: the band being computed, the next
+// band being read ahead, and the previous band being written behind.
+#define NBUFFERS 3
+
+// The maximum number of queued I/O requests.
+#define MAX_REQUESTS 8
+
+// The default memory for bands.
+#define DEFAULT_MEMORY ((size_t)256 << 20)
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// Defines read or write of a band of rows.
+struct io_request_t
+{
+	int write, fd;
+	real* data;
+	size_t size;
+	off_t offset;
+};
+
+// Defines internal structure for out-of-core fft solver.
+struct poisson2d_ooc_solver_t
+{
+	unsigned int m, n;
+	real hx, hy;
+
+	// File descriptors of the right hand side and solution.
+	int rhs, solution;
+
+	// Boundary conditions by Y and their transforms.
+	real *by, *ey, *cby, *cey;
+	fft_plan *plan_bc, *plan_ec;
+
+	// Band buffers of rows rows each, and transform plans of
+	// a full band and of the last band (nbands in total).
+	int rows, nbands;
+	real* buffers[NBUFFERS];
+	fft_plan *plan_band, *plan_last;
+
+	// Alpha coefficients of each mode, offsets[p] .. offsets[p + 1] - 1,
+	// up to the row they converge at (all modes converge at kmax).
+	// A band of them is expanded into factor, rows x m, for the row
+	// sweeps, filled for the rows filled .. filled + nfilled - 1.
+	size_t* offsets;
+	real *alphas, *factor;
+	int kmax, filled, nfilled;
+
+	// The beta coefficients of the last row of the previous band
+	// of the forward sweep, and the solution of the first row of
+	// the previous band of the backward sweep.
+	real *carry, *next;
+
+	// I/O thread and its queue of requests, completed in order
+	// of submission. All fields are guarded by mutex, changed is
+	// signaled on submission and completion.
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t changed;
+	struct io_request_t requests[MAX_REQUESTS];
+	long submitted, completed;
+	int failed, stop;
+
+	int nthreads;
+
+	breeze2d_poisson_ooc_stats stats;
+};
+
+// Read or write the whole request, return non-zero on failure.
+static int transfer(const struct io_request_t* request)
+{
+	char* data = (char*)request->data;
+	size_t size = request->size;
+	off_t offset = request->offset;
+	while (size)
+	{
+		ssize_t done = request->write ?
+			pwrite(request->fd, data, size, offset) :
+			pread(request->fd, data, size, offset);
+		if ((done < 0) && (errno == EINTR)) continue;
+		if (done <= 0) return 1;
+		data += done; size -= done; offset += done;
+	}
+	return 0;
+}
+
+// Perform queued I/O requests, until disposed.
+static void* io_thread(void* arg)
+{
+	struct poisson2d_ooc_solver_t* solver =
+		(struct poisson2d_ooc_solver_t*)arg;
+
+	pthread_mutex_lock(&solver->mutex);
+	for ( ; ; )
+	{
+		if (solver->completed == solver->submitted)
+		{
+			if (solver->stop) break;
+			pthread_cond_wait(&solver->changed, &solver->mutex);
+			continue;
+		}
+
+		// Requests after a failure are skipped.
+		struct io_request_t request =
+			solver->requests[solver->completed % MAX_REQUESTS];
+		int failed = solver->failed;
+		pthread_mutex_unlock(&solver->mutex);
+
+		double start = omp_get_wtime();
+		if (!failed) failed = transfer(&request);
+		double time = omp_get_wtime() - start;
+
+		pthread_mutex_lock(&solver->mutex);
+		solver->failed |= failed;
+		solver->stats.io_time += time;
+		solver->completed++;
+		pthread_cond_broadcast(&solver->changed);
+	}
+	pthread_mutex_unlock(&solver->mutex);
+
+	return NULL;
+}
+
+// Queue read or write of rows j0 .. j0 + count - 1 of the file,
+// return the request number to wait for.
+static long submit(struct poisson2d_ooc_solver_t* solver,
+	int write, int fd, real* data, int j0, int count)
+{
+	size_t rowsize = sizeof(real) * solver->m;
+	struct io_request_t request = { write, fd, data,
+		rowsize * count, (off_t)rowsize * j0 };
+
+	pthread_mutex_lock(&solver->mutex);
+	while (solver->submitted - solver->completed == MAX_REQUESTS)
+		pthread_cond_wait(&solver->changed, &solver->mutex);
+	solver->requests[solver->submitted % MAX_REQUESTS] = request;
+	long index = ++solver->submitted;
+	if (write) solver->stats.bytes_written += request.size;
+	else solver->stats.bytes_read += request.size;
+	pthread_cond_broadcast(&solver->changed);
+	pthread_mutex_unlock(&solver->mutex);
+
+	return index;
+}
+
+// Wait for completion of the specified request and all
+// requests before it, accounting the time.
+static void wait_request(struct poisson2d_ooc_solver_t* solver, long index)
+{
+	double start = omp_get_wtime();
+	pthread_mutex_lock(&solver->mutex);
+	while (solver->completed < index)
+		pthread_cond_wait(&solver->changed, &solver->mutex);
+	pthread_mutex_unlock(&solver->mutex);
+	solver->stats.io_wait += omp_get_wtime() - start;
+}
+
+// Tabulate alpha coefficients of the shutter method for each mode,
+// with the same recurrence as poisson2d_shutter_factor_rows_r, up
+// to the row they stop changing at. The low modes converge slower,
+// but the table is much smaller than the grid. Returns non-zero,
+// if the table could not be allocated.
+static int tabulate(struct poisson2d_ooc_solver_t* solver)
+{
+	int m = solver->m, n = solver->n;
+	real r = solver->hy / solver->hx;
+	real invm = 0.5 / (m + 1);
+
+	size_t size = 0, capacity = m;
+	solver->offsets = (size_t*)malloc(sizeof(size_t) * (m + 1));
+	solver->alphas = (real*)malloc(sizeof(real) * capacity);
+	if (!solver->offsets || !solver->alphas) return 1;
+	solver->kmax = 0;
+	for (int p = 0; p < m; p++)
+	{
+		real val = r * sin(M_PI * (p + 1) * invm);
+		real b = 2.0 + 4.0 * val * val;
+
+		solver->offsets[p] = size;
+		real alpha = 0.0;
+		for (int k = 0; k < n; k++)
+		{
+			real next = 1.0 / (b - alpha);
+			if (k && (next == alpha)) break;
+			alpha = next;
+			if (size == capacity)
+			{
+				capacity *= 2;
+				real* alphas = (real*)realloc(solver->alphas,
+					sizeof(real) * capacity);
+				if (!alphas) return 1;
+				solver->alphas = alphas;
+			}
+			solver->alphas[size++] = alpha;
+		}
+		if (size - solver->offsets[p] > solver->kmax)
+			solver->kmax = size - solver->offsets[p];
+	}
+	solver->offsets[m] = size;
+	return 0;
+}
+
+// Release the plans and buffers created so far, and the solver.
+static void release(struct poisson2d_ooc_solver_t* solver)
+{
+	if (solver->plan_last && (solver->plan_last != solver->plan_band))
+		fft_dispose(solver->plan_last);
+	if (solver->plan_band)
+		fft_dispose(solver->plan_band);
+	if (solver->plan_bc)
+		fft_dispose(solver->plan_bc);
+	if (solver->plan_ec)
+		fft_dispose(solver->plan_ec);
+	for (int i = 0; i < NBUFFERS; i++)
+		fft_free(solver->buffers[i]);
+	fft_free(solver->factor);
+	fft_free(solver->cby);
+	free(solver->offsets);
+	free(solver->alphas);
+	free(solver);
+}
+
+// Release the resources of the failed solver
+// initialization and report the error.
+static breeze2d_poisson_ooc_solver init_failed(
+	struct poisson2d_ooc_solver_t* solver, int status)
+{
+	release(solver);
+	breeze2d_set_error(status);
+	return NULL;
+}
+
+// Initialize 2D Poisson equation solver for grids kept in files.
+breeze2d_poisson_ooc_solver breeze2d_poisson_ooc_solver_init(
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* by, real* ey, int rhs, int solution, size_t memory)
+{
+	struct poisson2d_ooc_solver_t* solver =
+		(struct poisson2d_ooc_solver_t*)calloc(1,
+			sizeof(struct poisson2d_ooc_solver_t));
+	if (!solver)
+	{
+		breeze2d_set_error(BREEZE2D_OUT_OF_MEMORY);
+		return NULL;
+	}
+	solver->m = m; solver->n = n; solver->hx = hx; solver->hy = hy;
+	solver->rhs = rhs; solver->solution = solution;
+	solver->by = by; solver->ey = ey;
+
+	fft_init_threads();
+	solver->nthreads = poisson2d_parallel_nthreads();
+	fft_plan_with_nthreads(solver->nthreads);
+
+	// Band buffers and the factor band share the memory.
+	if (!memory) memory = DEFAULT_MEMORY;
+	size_t rows = memory / ((NBUFFERS + 1) * sizeof(real) * m);
+	if (rows < 1) rows = 1;
+	if (rows > n) rows = n;
+	solver->rows = rows;
+	solver->nbands = (n + rows - 1) / rows;
+	for (int i = 0; i < NBUFFERS; i++)
+		solver->buffers[i] = (real*)fft_malloc(sizeof(real) * rows * m);
+	solver->factor = (real*)fft_malloc(sizeof(real) * rows * m);
+	solver->cby = (real*)fft_malloc(sizeof(real) * 4 * m);
+	for (int i = 0; i < NBUFFERS; i++)
+		if (!solver->buffers[i])
+			return init_failed(solver, BREEZE2D_OUT_OF_MEMORY);
+	if (!solver->factor || !solver->cby)
+		return init_failed(solver, BREEZE2D_OUT_OF_MEMORY);
+	solver->filled = -1;
+
+	// Bands are transformed in place.
+	int last = n - (solver->nbands - 1) * rows;
+	solver->plan_band = fft_create_multi(m, rows,
+		solver->buffers[0], solver->buffers[0], m, m,
+		FFT_RODFT00, FFT_MEASURE);
+	solver->plan_last = (last == rows) ? solver->plan_band :
+		fft_create_multi(m, last,
+			solver->buffers[0], solver->buffers[0], m, m,
+			FFT_RODFT00, FFT_MEASURE);
+	solver->cey = solver->cby + m;
+	solver->carry = solver->cey + m;
+	solver->next = solver->carry + m;
+	solver->plan_bc = fft_create(m, by, solver->cby,
+		FFT_RODFT00, FFT_MEASURE);
+	solver->plan_ec = fft_create(m, ey, solver->cey,
+		FFT_RODFT00, FFT_MEASURE);
+	if (!solver->plan_band || !solver->plan_last ||
+		!solver->plan_bc || !solver->plan_ec)
+		return init_failed(solver, BREEZE2D_FFT_PLAN_CREATION_FAILED);
+
+	if (tabulate(solver))
+		return init_failed(solver, BREEZE2D_OUT_OF_MEMORY);
+
+	pthread_mutex_init(&solver->mutex, NULL);
+	pthread_cond_init(&solver->changed, NULL);
+	if (pthread_create(&solver->thread, NULL, io_thread, solver))
+	{
+		pthread_mutex_destroy(&solver->mutex);
+		pthread_cond_destroy(&solver->changed);
+		return init_failed(solver, BREEZE2D_THREAD_CREATION_FAILED);
+	}
+
+	return (breeze2d_poisson_ooc_solver)solver;
+}
+
+// Defines arguments of the parallel loops over modes of a band.
+struct band_args_t
+{
+	struct poisson2d_ooc_solver_t* solver;
+	real* band;
+	int j0, count;
+	real scale;
+};
+
+// Expand alpha coefficients of modes begin .. end - 1
+// for the rows of the band.
+static void factor_part(void* arg, int part, long begin, long end)
+{
+	struct band_args_t* args = (struct band_args_t*)arg;
+	struct poisson2d_ooc_solver_t* solver = args->solver;
+	int m = solver->m;
+
+	for (int j = 0; j < args->count; j++)
+	{
+		real* factor = solver->factor + j * m;
+		for (int p = begin; p < end; p++)
+		{
+			size_t last = solver->offsets[p + 1] - 1;
+			size_t k = solver->offsets[p] + args->j0 + j;
+			factor[p] = solver->alphas[MIN(k, last)];
+		}
+	}
+}
+
+// Check if factor holds alpha coefficients of rows j0 .. j0 + count - 1.
+// Rows past convergence of all modes are the same.
+static int is_filled(struct poisson2d_ooc_solver_t* solver, int j0, int count)
+{
+	if ((solver->filled < 0) || (count > solver->nfilled)) return 0;
+	return (j0 == solver->filled) ||
+		((j0 >= solver->kmax) && (solver->filled >= solver->kmax));
+}
+
+// Sweep forward over the rows of the band for modes begin .. end - 1.
+static void forward_part(void* arg, int part, long begin, long end)
+{
+	struct band_args_t* args = (struct band_args_t*)arg;
+	struct poisson2d_ooc_solver_t* solver = args->solver;
+	poisson2d_shutter_forward_r(solver->m, solver->hy,
+		args->band, solver->m, args->band, solver->m,
+		solver->factor, solver->carry, begin, end, 0, args->count);
+}
+
+// Sweep backward over the rows of the band for modes begin .. end - 1.
+static void backward_part(void* arg, int part, long begin, long end)
+{
+	struct band_args_t* args = (struct band_args_t*)arg;
+	struct poisson2d_ooc_solver_t* solver = args->solver;
+	poisson2d_shutter_backward_r(solver->m,
+		args->band, solver->m, solver->factor,
+		solver->next, args->scale, begin, end, 0, args->count);
+}
+
+// Solve 2D Poisson equation with the right hand side in file.
+// The forward pass reads bands of the right hand side bottom to
+// top, transforms them and sweeps forward, writing beta coefficients
+// into the solution file. The backward pass reads them back top to
+// bottom, sweeps backward and transforms inversely, writing the
+// solution. The top band is swept both ways at once, without being
+// written and read back. Steps of passes read the band of the next
+// step ahead, and write the band of this step behind.
+void breeze2d_poisson_ooc_solve(breeze2d_poisson_ooc_solver desc)
+{
+	struct poisson2d_ooc_solver_t* solver =
+		(struct poisson2d_ooc_solver_t*)desc;
+
+	double start = omp_get_wtime();
+	pthread_mutex_lock(&solver->mutex);
+	memset(&solver->stats, 0, sizeof(breeze2d_poisson_ooc_stats));
+	pthread_mutex_unlock(&solver->mutex);
+
+	int m = solver->m, n = solver->n, rows = solver->rows;
+	int nbands = solver->nbands, nsteps = 2 * nbands - 1;
+	int nthreads = MIN(solver->nthreads, poisson2d_parallel_nthreads());
+
+	// Transform boundary conditions.
+	fft_forward(solver->plan_bc);
+	fft_forward(solver->plan_ec);
+	real scale = 0.5 / (m + 1);
+	memcpy(solver->carry, solver->cby, sizeof(real) * m);
+	for (int p = 0; p < m; p++)
+		solver->next[p] = scale * solver->cey[p];
+
+	struct band_args_t args = { solver };
+	args.scale = scale;
+	long reads[NBUFFERS];
+	reads[0] = submit(solver, 0, solver->rhs, solver->buffers[0], 0,
+		MIN(rows, n));
+	for (int s = 0; s < nsteps; s++)
+	{
+		int band = (s < nbands) ? s : nsteps - 1 - s;
+		args.band = solver->buffers[s % NBUFFERS];
+		args.j0 = band * rows;
+		args.count = MIN(rows, n - args.j0);
+
+		// Read the next band ahead, into the buffer of the
+		// band written before the previous one.
+		if (s + 1 < nsteps)
+		{
+			int next = (s + 1 < nbands) ? s + 1 : nsteps - 2 - s;
+			reads[(s + 1) % NBUFFERS] = submit(solver, 0,
+				(s + 1 < nbands) ? solver->rhs : solver->solution,
+				solver->buffers[(s + 1) % NBUFFERS], next * rows,
+				MIN(rows, n - next * rows));
+		}
+		wait_request(solver, reads[s % NBUFFERS]);
+
+		if (!is_filled(solver, args.j0, args.count))
+		{
+			poisson2d_parallel_for(nthreads, m, factor_part, &args);
+			solver->filled = args.j0;
+			solver->nfilled = args.count;
+		}
+
+		fft_plan* plan = (args.count == rows) ?
+			solver->plan_band : solver->plan_last;
+		if (s < nbands)
+		{
+			fft_forward_at(plan, args.band, args.band);
+			poisson2d_parallel_for(nthreads, m, forward_part, &args);
+			memcpy(solver->carry, args.band + (args.count - 1) * m,
+				sizeof(real) * m);
+		}
+		if (s >= nbands - 1)
+		{
+			poisson2d_parallel_for(nthreads, m, backward_part, &args);
+			fft_inverse_at(plan, args.band, args.band);
+		}
+
+		submit(solver, 1, solver->solution, args.band, args.j0, args.count);
+	}
+	wait_request(solver, solver->submitted);
+
+	pthread_mutex_lock(&solver->mutex);
+	solver->stats.time = omp_get_wtime() - start;
+	int failed = solver->failed;
+	solver->failed = 0;
+	pthread_mutex_unlock(&solver->mutex);
+	if (failed)
+		breeze2d_set_error(BREEZE2D_IO_FAILED);
+}
+
+// Get statistics of the last solve.
+void breeze2d_poisson_ooc_get_stats(breeze2d_poisson_ooc_solver desc,
+	breeze2d_poisson_ooc_stats* stats)
+{
+	struct poisson2d_ooc_solver_t* solver =
+		(struct poisson2d_ooc_solver_t*)desc;
+
+	pthread_mutex_lock(&solver->mutex);
+	*stats = solver->stats;
+	pthread_mutex_unlock(&solver->mutex);
+}
+
+// Release resources used by the specified solver.
+void breeze2d_poisson_ooc_solver_dispose(breeze2d_poisson_ooc_solver desc)
+{
+	struct poisson2d_ooc_solver_t* solver =
+		(struct poisson2d_ooc_solver_t*)desc;
+
+	pthread_mutex_lock(&solver->mutex);
+	solver->stop = 1;
+	pthread_cond_broadcast(&solver->changed);
+	pthread_mutex_unlock(&solver->mutex);
+	pthread_join(solver->thread, NULL);
+	pthread_mutex_destroy(&solver->mutex);
+	pthread_cond_destroy(&solver->changed);
+
+	release(solver);
+}
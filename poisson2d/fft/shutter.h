@@ -43,8 +43,56 @@ typedef real complex[2];
 
 void poisson2d_shutter_r(
 	int m, int n, real hx, real hy,
-	real* rhs, real* solution,
-	real* alpha, real* beta, real* bc, real* ec);
+	real* rhs, int ldrhs, real* solution, int ldsolution,
+	real* alpha, real* beta, real* bc, real* ec, real scale,
+	int nthreads);
+
+void poisson2d_shutter_grad_r(
+	int m, int n, real hx, real hy,
+	real* rhs, int ldrhs, real* solution, int ldsolution,
+	real* alpha, real* beta, real* bc, real* ec, real scale,
+	real* dx, int ldx, real* dy, int nthreads);
+
+void poisson2d_shutter_factor_r(
+	int m, int n, real hx, real hy, real* factor, int nthreads);
+
+void poisson2d_shutter_sparse_r(
+	int m, int n, real hx, real hy,
+	int nsources, const int* is, const int* js, const real* q,
+	real* solution, int ldsolution,
+	real* alpha, real* beta, const real* factor,
+	real* bc, real* ec, real scale, int nthreads);
+
+void poisson2d_shutter_factor_rows_r(
+	int m, int n, real hx, real hy, real* factor, int nthreads);
+
+void poisson2d_shutter_factor_modes_r(
+	int m, int n, real hx, real hy, int p0, int p1,
+	real* factor, int nthreads);
+
+void poisson2d_shutter_forward_r(int m, real hy,
+	const real* rhs, int ldrhs, real* solution, int ldsolution,
+	const real* factor, const real* bc, int p0, int p1, int j0, int j1);
+
+void poisson2d_shutter_backward_r(int m,
+	real* solution, int ldsolution, const real* factor,
+	real* next, real scale, int p0, int p1, int j0, int j1);
+
+void poisson2d_shutter_compact_r(
+	int m, int n, real hx, real hy,
+	real* rhs, int ldrhs, real* solution, int ldsolution,
+	real* alpha, real* beta, real* bc, real* ec,
+	real* xc0, real* xc1, real scale, int nthreads);
+
+void poisson2d_shutter_factor_stretched_r(
+	int m, int n, real hx, const real* hy,
+	real* a, real* c, real* factor, int nthreads);
+
+void poisson2d_shutter_stretched_r(
+	int m, int n, real* rhs, int ldrhs,
+	real* solution, int ldsolution, real* beta,
+	const real* a, const real* c, const real* factor,
+	real* bc, real* ec, real scale, int nthreads);
 
 void poisson2d_shutter_c(
 	int m, int n, real hx, real hy,
@@ -19,57 +19,622 @@
  */
 
 #include "shutter.h"
+#include "../parallel.h"
 
 #include <math.h>
 
+// Defines arguments of the shutter kernels, passed
+// to the parts of parallel loop over modes.
+struct shutter_args_t
+{
+	int m, n;
+	real hx, hy;
+	const real* rhs;
+	int ldrhs;
+	real* solution;
+	int ldsolution;
+	real *alpha, *beta;
+	const real *bc, *ec;
+	real scale;
+
+	// Gradient outputs (poisson2d_shutter_grad_r).
+	real *dx, *dy;
+	int ldx;
+
+	// Point sources (poisson2d_shutter_sparse_r).
+	int nsources;
+	const int *is, *js;
+	const real* q;
+
+	// Factorization and coefficients of 3-diagonal systems
+	// (poisson2d_shutter_sparse_r, poisson2d_shutter_stretched_r),
+	// and X boundary values (poisson2d_shutter_compact_r).
+	const real *factor, *a, *c;
+	const real *xc0, *xc1;
+};
+
+// Defines arguments of the factorization kernels.
+struct factor_args_t
+{
+	int m, n;
+	real hx, hy;
+
+	// Range of modes (poisson2d_shutter_factor_modes_r).
+	int p0, p1;
+	const real *a, *c;
+	real* factor;
+};
+
+// Sweep modes begin .. end - 1 of poisson2d_shutter_r.
+static void shutter_part(void* arg, int part, long begin, long end)
+{
+	const struct shutter_args_t* args = (const struct shutter_args_t*)arg;
+	int m = args->m, n = args->n;
+	real hx = args->hx, hy = args->hy;
+	const real* rhs = args->rhs;
+	int ldrhs = args->ldrhs, ldsolution = args->ldsolution;
+	real* solution = args->solution;
+	const real *bc = args->bc, *ec = args->ec;
+	real scale = args->scale;
+	real r = hy / hx;
+	real a = 1.0, c = 1.0;
+	real invm = 0.5 / (m + 1);
+
+	real* talpha = args->alpha + (n + 1) * part;
+	real* tbeta = args->beta + (n + 1) * part;
+
+	for (int p = begin; p < end; p++)
+	{
+		real val = r * sin(M_PI * (p + 1) * invm);
+		real b = 2.0 + 4.0 * val * val;
+	
+		// ground b.c.
+		{
+			talpha[0] = 0.0;
+			tbeta[0] = bc[p];
+		}
+	
+		for (int k = 1; k <= n; k++)
+		{
+			real val = 1.0 / (b - c * talpha[k - 1]);
+
+			talpha[k] = a * val;
+			tbeta[k] = (c * tbeta[k - 1] - 
+				hy * hy * rhs[p + (k - 1) * ldrhs]) * val;
+		}
+
+		// top b.c.
+		real next = scale * ec[p];
+	
+		for (int k = n; k >= 1; k--)
+		{
+			next = talpha[k] * next + scale * tbeta[k];
+			solution[p + (k - 1) * ldsolution] = next;
+		}
+	}
+}
+
+// Solve m 3-diagonal systems of n equations
+// using shutter method in real space.
+// Modes are shared between nthreads threads, each using its
+// own n + 1 elements of alpha and beta (must hold nthreads
+// times n + 1 elements).
+// The solution is multiplied by scale, e.g. to normalize
+// the subsequent inverse transform.
+// Rows of rhs and solution are ldrhs and ldsolution
+// elements apart (m for dense arrays).
+// The rhs and solution may be the same array: each
+// column is entirely read by the forward sweep before
+// it is overwritten by the backward sweep.
 void poisson2d_shutter_r(
 	int m, int n, real hx, real hy,
-	real* rhs, real* solution,
-	real* alpha, real* beta, real* bc, real* ec)
+	real* rhs, int ldrhs, real* solution, int ldsolution,
+	real* alpha, real* beta, real* bc, real* ec, real scale,
+	int nthreads)
+{
+	struct shutter_args_t args = { .m = m, .n = n, .hx = hx, .hy = hy,
+		.rhs = rhs, .ldrhs = ldrhs, .solution = solution,
+		.ldsolution = ldsolution, .alpha = alpha, .beta = beta,
+		.bc = bc, .ec = ec, .scale = scale };
+	poisson2d_parallel_for(nthreads, m, shutter_part, &args);
+}
+
+// Sweep modes begin .. end - 1 of poisson2d_shutter_grad_r.
+static void shutter_grad_part(void* arg, int part, long begin, long end)
 {
+	const struct shutter_args_t* args = (const struct shutter_args_t*)arg;
+	int m = args->m, n = args->n;
+	real hx = args->hx, hy = args->hy;
+	const real* rhs = args->rhs;
+	int ldrhs = args->ldrhs, ldsolution = args->ldsolution;
+	real* solution = args->solution;
+	const real *bc = args->bc, *ec = args->ec;
+	real scale = args->scale;
+	real *dx = args->dx, *dy = args->dy;
+	int ldx = args->ldx;
 	real r = hy / hx;
 	real a = 1.0, c = 1.0;
 	real invm = 0.5 / (m + 1);
-	
-	// Set last column to 0 (effective in case of odd m).
-	for (int i = 0; i < n; i++)
-		solution[m - 1 + i * m] = 0;
+	real half = 0.5 / hy;
 
-	for (int p = 1; p < m; p += 2)
+	real* talpha = args->alpha + (n + 1) * part;
+	real* tbeta = args->beta + (n + 1) * part;
+
+	for (int p = begin; p < end; p++)
 	{
-		real val = r * sin(M_PI * (p + 1) * invm);
+		real s = sin(M_PI * (p + 1) * invm);
+		real val = r * s;
 		real b = 2.0 + 4.0 * val * val;
-		
+
+		// sin(theta) / hx, theta = 2 * pi * (p + 1) * invm.
+		real sx = 2.0 * s * cos(M_PI * (p + 1) * invm) / hx;
+	
 		// ground b.c.
 		{
-			alpha[0] = 0.0;
-			beta[0] = bc[p];
+			talpha[0] = 0.0;
+			tbeta[0] = bc[p];
 		}
+	
+		for (int k = 1; k <= n; k++)
+		{
+			real val = 1.0 / (b - c * talpha[k - 1]);
+
+			talpha[k] = a * val;
+			tbeta[k] = (c * tbeta[k - 1] - 
+				hy * hy * rhs[p + (k - 1) * ldrhs]) * val;
+		}
+
+		// top b.c.
+		real next = scale * ec[p], prev = 0.0;
+	
+		for (int k = n; k >= 1; k--)
+		{
+			real cur = talpha[k] * next + scale * tbeta[k];
+			solution[p + (k - 1) * ldsolution] = cur;
+			if (dx) dx[p + 1 + (k - 1) * ldx] = sx * cur;
 		
-		for (int k = 1; k < n; k++)
+			// Row k + 1 has both neighbours now.
+			if (dy && (k < n)) dy[p + k * m] = (prev - cur) * half;
+			prev = next;
+			next = cur;
+		}
+		if (dy) dy[p] = (prev - scale * bc[p]) * half;
+	}
+}
+
+// Solve m 3-diagonal systems of n equations using shutter
+// method in real space, as poisson2d_shutter_r, and also
+// emit X-spectral coefficients of the solution central
+// differences. Y-differences are taken in the backward sweep
+// (rows 0 and n + 1 are the boundary conditions) and stored
+// into dy of m x n. X-differences of sine series are cosine
+// series: their coefficients are stored into columns 1 .. m
+// of dx rows of ldx elements. Either dx or dy may be NULL.
+void poisson2d_shutter_grad_r(
+	int m, int n, real hx, real hy,
+	real* rhs, int ldrhs, real* solution, int ldsolution,
+	real* alpha, real* beta, real* bc, real* ec, real scale,
+	real* dx, int ldx, real* dy, int nthreads)
+{
+	struct shutter_args_t args = { .m = m, .n = n, .hx = hx, .hy = hy,
+		.rhs = rhs, .ldrhs = ldrhs, .solution = solution,
+		.ldsolution = ldsolution, .alpha = alpha, .beta = beta,
+		.bc = bc, .ec = ec, .scale = scale, .dx = dx, .ldx = ldx,
+		.dy = dy };
+	poisson2d_parallel_for(nthreads, m, shutter_grad_part, &args);
+}
+
+// Factorize modes begin .. end - 1 of poisson2d_shutter_factor_r.
+static void factor_part(void* arg, int part, long begin, long end)
+{
+	const struct factor_args_t* args = (const struct factor_args_t*)arg;
+	int m = args->m, n = args->n;
+	real* factor = args->factor;
+	real r = args->hy / args->hx;
+	real invm = 0.5 / (m + 1);
+
+	for (int p = begin; p < end; p++)
+	{
+		real val = r * sin(M_PI * (p + 1) * invm);
+		real b = 2.0 + 4.0 * val * val;
+
+		real* alpha = factor + p * (n + 1);
+		alpha[0] = 0.0;
+		for (int k = 1; k <= n; k++)
+			alpha[k] = 1.0 / (b - alpha[k - 1]);
+	}
+}
+
+// Fill the shutter alpha coefficients for all modes, m x (n + 1)
+// array, mode after mode. They do not depend on the right hand
+// side and boundary conditions, so they can be computed once.
+void poisson2d_shutter_factor_r(
+	int m, int n, real hx, real hy, real* factor, int nthreads)
+{
+	struct factor_args_t args = { .m = m, .n = n, .hx = hx, .hy = hy,
+		.factor = factor };
+	poisson2d_parallel_for(nthreads, m, factor_part, &args);
+}
+
+// Factorize modes p0 + begin .. p0 + end - 1 of
+// poisson2d_shutter_factor_modes_r.
+static void factor_rows_part(void* arg, int part, long begin, long end)
+{
+	const struct factor_args_t* args = (const struct factor_args_t*)arg;
+	int m = args->m, n = args->n, p0 = args->p0;
+	int width = args->p1 - p0;
+	real* factor = args->factor;
+	real r = args->hy / args->hx;
+	real invm = 0.5 / (m + 1);
+
+	for (int p = begin; p < end; p++)
+	{
+		real val = r * sin(M_PI * (p0 + p + 1) * invm);
+		real b = 2.0 + 4.0 * val * val;
+
+		real alpha = 0.0;
+		for (int k = 0; k < n; k++)
+		{
+			alpha = 1.0 / (b - alpha);
+			factor[p + k * width] = alpha;
+		}
+	}
+}
+
+// Fill the shutter alpha coefficients for all modes, n x m
+// array, row after row, for the row sweeps of
+// poisson2d_shutter_forward_r and poisson2d_shutter_backward_r.
+void poisson2d_shutter_factor_rows_r(
+	int m, int n, real hx, real hy, real* factor, int nthreads)
+{
+	poisson2d_shutter_factor_modes_r(m, n, hx, hy, 0, m, factor, nthreads);
+}
+
+// Fill the shutter alpha coefficients for modes p0 .. p1 - 1 out
+// of m, n x (p1 - p0) array, row after row, e.g. for the modes of
+// one process.
+void poisson2d_shutter_factor_modes_r(
+	int m, int n, real hx, real hy, int p0, int p1,
+	real* factor, int nthreads)
+{
+	struct factor_args_t args = { .m = m, .n = n, .hx = hx, .hy = hy,
+		.p0 = p0, .p1 = p1, .factor = factor };
+	poisson2d_parallel_for(nthreads, p1 - p0, factor_rows_part, &args);
+}
+
+// Forward sweep of the shutter method for modes p0 .. p1 - 1
+// over rows j0 .. j1 - 1, all modes of a row at once, with
+// alpha coefficients from factor (see
+// poisson2d_shutter_factor_rows_r). Beta coefficients are stored
+// into solution, which may be rhs. Rows before j0 must be swept
+// already, bc is the bottom boundary condition.
+void poisson2d_shutter_forward_r(int m, real hy,
+	const real* rhs, int ldrhs, real* solution, int ldsolution,
+	const real* factor, const real* bc, int p0, int p1, int j0, int j1)
+{
+	real hy2 = hy * hy;
+
+	for (int j = j0; j < j1; j++)
+	{
+		const real* f = rhs + j * ldrhs;
+		const real* prev = j ? solution + (j - 1) * ldsolution : bc;
+		const real* alpha = factor + j * m;
+		real* beta = solution + j * ldsolution;
+
+		#pragma omp simd
+		for (int p = p0; p < p1; p++)
+			beta[p] = (prev[p] - hy2 * f[p]) * alpha[p];
+	}
+}
+
+// Backward sweep of the shutter method for modes p0 .. p1 - 1
+// over rows j1 - 1 .. j0, in place of beta coefficients, with
+// the solution multiplied by scale. The solution of the row
+// above is taken from next (indexed by mode), which is replaced
+// with the solution of row j0, so that the rows below may be
+// swept next. For the top rows next must hold the top boundary
+// condition multiplied by scale.
+void poisson2d_shutter_backward_r(int m,
+	real* solution, int ldsolution, const real* factor,
+	real* next, real scale, int p0, int p1, int j0, int j1)
+{
+	for (int j = j1 - 1; j >= j0; j--)
+	{
+		const real* alpha = factor + j * m;
+		real* x = solution + j * ldsolution;
+
+		#pragma omp simd
+		for (int p = p0; p < p1; p++)
 		{
-			real val = 1.0 / (b - c * alpha[k - 1]);
+			x[p] = alpha[p] * next[p] + scale * x[p];
+			next[p] = x[p];
+		}
+	}
+}
 
-			alpha[k] = a * val;
-			beta[k] = (c * beta[k - 1] - 
-				hy * hy * rhs[p + (k - 1) * m]) * val;
+// Sweep modes begin .. end - 1 of poisson2d_shutter_sparse_r.
+static void shutter_sparse_part(void* arg, int part, long begin, long end)
+{
+	const struct shutter_args_t* args = (const struct shutter_args_t*)arg;
+	int m = args->m, n = args->n;
+	real hx = args->hx, hy = args->hy;
+	int nsources = args->nsources;
+	const int *is = args->is, *js = args->js;
+	const real* q = args->q;
+	real* solution = args->solution;
+	int ldsolution = args->ldsolution;
+	const real* factor = args->factor;
+	const real *bc = args->bc, *ec = args->ec;
+	real scale = args->scale;
+	real r = hy / hx;
+	real invm = 0.5 / (m + 1);
+
+	real* talpha = args->alpha + (n + 1) * part;
+	real* tbeta = args->beta + (n + 1) * part;
+
+	for (int p = begin; p < end; p++)
+	{
+		// The init-time factorization, or the same
+		// coefficients computed here.
+		const real* palpha = talpha;
+		if (factor)
+			palpha = factor + p * (n + 1);
+		else
+		{
+			real val = r * sin(M_PI * (p + 1) * invm);
+			real b = 2.0 + 4.0 * val * val;
+
+			talpha[0] = 0.0;
+			for (int k = 1; k <= n; k++)
+				talpha[k] = 1.0 / (b - talpha[k - 1]);
 		}
 
+		// ground b.c.
+		tbeta[0] = bc[p];
+		for (int k = 1; k <= n; k++)
+			tbeta[k] = 0.0;
+
+		// Sine transform of each point source
+		// contributes to a single row.
+		real theta = 2.0 * M_PI * (p + 1) * invm;
+		for (int s = 0; s < nsources; s++)
+			tbeta[js[s] + 1] -= hy * hy * 2.0 * q[s] *
+				sin(theta * (is[s] + 1));
+
+		for (int k = 1; k <= n; k++)
+			tbeta[k] = (tbeta[k - 1] + tbeta[k]) * palpha[k];
+
 		// top b.c.
+		real next = scale * ec[p];
+	
+		for (int k = n; k >= 1; k--)
+		{
+			next = palpha[k] * next + scale * tbeta[k];
+			solution[p + (k - 1) * ldsolution] = next;
+		}
+	}
+}
+
+// Solve m 3-diagonal systems of n equations using shutter
+// method in real space, as poisson2d_shutter_r, for the right
+// hand side, which is zero except nsources points (is, js)
+// of values q. The right hand side coefficients of each mode
+// are evaluated directly (sine transform of a point source),
+// and scattered into the beta sweep. The alpha coefficients
+// are taken from factor, if not NULL (see
+// poisson2d_shutter_factor_r).
+void poisson2d_shutter_sparse_r(
+	int m, int n, real hx, real hy,
+	int nsources, const int* is, const int* js, const real* q,
+	real* solution, int ldsolution,
+	real* alpha, real* beta, const real* factor,
+	real* bc, real* ec, real scale, int nthreads)
+{
+	struct shutter_args_t args = { .m = m, .n = n, .hx = hx, .hy = hy,
+		.solution = solution, .ldsolution = ldsolution,
+		.alpha = alpha, .beta = beta, .bc = bc, .ec = ec,
+		.scale = scale, .nsources = nsources, .is = is, .js = js,
+		.q = q, .factor = factor };
+	poisson2d_parallel_for(nthreads, m, shutter_sparse_part, &args);
+}
+
+// Factorize modes begin .. end - 1 of
+// poisson2d_shutter_factor_stretched_r.
+static void factor_stretched_part(void* arg, int part, long begin, long end)
+{
+	const struct factor_args_t* args = (const struct factor_args_t*)arg;
+	int m = args->m, n = args->n;
+	const real *a = args->a, *c = args->c;
+	real* factor = args->factor;
+	real hx = args->hx;
+	real invm = 0.5 / (m + 1);
+
+	for (int p = begin; p < end; p++)
+	{
+		real val = 2.0 * sin(M_PI * (p + 1) * invm) / hx;
+		real lambda = val * val;
+
+		real* g = factor + p * (n + 1);
+		real alpha = 0.0;
+		g[0] = 0.0;
+		for (int k = 1; k <= n; k++)
 		{
-			solution[p - 1 + (n - 1) * m] = 0;
-			solution[p + (n - 1) * m] = invm * ec[p];
+			g[k] = 1.0 / (a[k] + c[k] + lambda - a[k] * alpha);
+			alpha = c[k] * g[k];
 		}
+	}
+}
+
+// Fill the coefficients of 3-diagonal systems for Y grid
+// with variable steps hy (n + 1 elements, hy[k] is the step
+// between rows k - 1 and k, rows 0 and n + 1 being the
+// boundaries): a U(k - 1) - (a + c + lambda_p) U(k) + c U(k + 1)
+// for k = 1 .. n, and the inverse pivots g of forward sweep for
+// all modes, m x (n + 1) array, mode after mode.
+void poisson2d_shutter_factor_stretched_r(
+	int m, int n, real hx, const real* hy,
+	real* a, real* c, real* factor, int nthreads)
+{
+	a[0] = 0.0; c[0] = 0.0;
+	for (int k = 1; k <= n; k++)
+	{
+		real h = hy[k - 1] + hy[k];
+		a[k] = 2.0 / (hy[k - 1] * h);
+		c[k] = 2.0 / (hy[k] * h);
+	}
+
+	struct factor_args_t args = { .m = m, .n = n, .hx = hx,
+		.a = a, .c = c, .factor = factor };
+	poisson2d_parallel_for(nthreads, m, factor_stretched_part, &args);
+}
+
+// Sweep modes begin .. end - 1 of poisson2d_shutter_stretched_r.
+static void shutter_stretched_part(void* arg, int part, long begin, long end)
+{
+	const struct shutter_args_t* args = (const struct shutter_args_t*)arg;
+	int n = args->n;
+	const real* rhs = args->rhs;
+	int ldrhs = args->ldrhs, ldsolution = args->ldsolution;
+	real* solution = args->solution;
+	const real *a = args->a, *c = args->c, *factor = args->factor;
+	const real *bc = args->bc, *ec = args->ec;
+	real scale = args->scale;
+
+	real* tbeta = args->beta + (n + 1) * part;
+
+	for (int p = begin; p < end; p++)
+	{
+		const real* g = factor + p * (n + 1);
+
+		// ground b.c.
+		tbeta[0] = bc[p];
+
+		for (int k = 1; k <= n; k++)
+			tbeta[k] = (a[k] * tbeta[k - 1] -
+				rhs[p + (k - 1) * ldrhs]) * g[k];
+
+		// top b.c.
+		real next = scale * ec[p];
+	
+		for (int k = n; k >= 1; k--)
+		{
+			next = c[k] * g[k] * next + scale * tbeta[k];
+			solution[p + (k - 1) * ldsolution] = next;
+		}
+	}
+}
+
+// Solve m 3-diagonal systems of n equations using shutter method
+// in real space, as poisson2d_shutter_r, for the Y grid with
+// variable steps, factorized by poisson2d_shutter_factor_stretched_r.
+// Only beta is computed per solve: alpha(k) = c(k) g(k).
+void poisson2d_shutter_stretched_r(
+	int m, int n, real* rhs, int ldrhs,
+	real* solution, int ldsolution, real* beta,
+	const real* a, const real* c, const real* factor,
+	real* bc, real* ec, real scale, int nthreads)
+{
+	struct shutter_args_t args = { .m = m, .n = n, .rhs = rhs,
+		.ldrhs = ldrhs, .solution = solution,
+		.ldsolution = ldsolution, .beta = beta, .bc = bc, .ec = ec,
+		.scale = scale, .a = a, .c = c, .factor = factor };
+	poisson2d_parallel_for(nthreads, m, shutter_stretched_part, &args);
+}
+
+// Sweep modes begin .. end - 1 of poisson2d_shutter_compact_r.
+static void shutter_compact_part(void* arg, int part, long begin, long end)
+{
+	const struct shutter_args_t* args = (const struct shutter_args_t*)arg;
+	int m = args->m, n = args->n;
+	real hx = args->hx, hy = args->hy;
+	const real* rhs = args->rhs;
+	int ldrhs = args->ldrhs, ldsolution = args->ldsolution;
+	real* solution = args->solution;
+	const real *bc = args->bc, *ec = args->ec;
+	const real *xc0 = args->xc0, *xc1 = args->xc1;
+	real scale = args->scale;
+	real r2 = (hy / hx) * (hy / hx);
+	real invm = 0.5 / (m + 1);
+
+	real* talpha = args->alpha + (n + 1) * part;
+	real* tbeta = args->beta + (n + 1) * part;
+
+	for (int p = begin; p < end; p++)
+	{
+		real s = sin(M_PI * (p + 1) * invm);
+		real sigma = 4.0 * s * s;
+		real a = 1.0 - sigma * (1.0 + r2) / 12.0;
+		real b = 2.0 + sigma * r2 / a;
+
+		// Right hand side weights, including division by a.
+		real w0 = hy * hy * (5.0 / 6.0 - sigma / 12.0) / a;
+		real w1 = hy * hy / (12.0 * a);
 		
-		for (int k = n - 1; k >= 1; k--)
+		// Transforms of unit values in the first and the last
+		// points: 2 sin(theta_p) and 2 sin(theta_p m).
+		real x0 = 4.0 * s * cos(M_PI * (p + 1) * invm);
+		real x1 = (p % 2) ? -x0 : x0;
+		x0 *= hy * hy / a; x1 *= hy * hy / a;
+
+		const real* f = rhs + p;
+		real fprev, fcur = f[0], fnext, ftop;
+		if (n >= 3)
+		{
+			fprev = 3.0 * (f[0] - f[ldrhs]) + f[2 * ldrhs];
+			ftop = 3.0 * (f[(n - 1) * ldrhs] - f[(n - 2) * ldrhs]) + f[(n - 3) * ldrhs];
+		}
+		else
+		{
+			fprev = f[0];
+			ftop = f[(n - 1) * ldrhs];
+		}
+
+		// ground b.c.
+		talpha[0] = 0.0;
+		tbeta[0] = bc[p];
+	
+		for (int k = 1; k <= n; k++)
 		{
-			// Set to zero the empty imaginary part column
-			// (it is not used in case of real-to-real fft).
-			solution[p - 1 + (k - 1) * m] = 0;
+			fnext = (k < n) ? f[k * ldrhs] : ftop;
+			real g = w0 * fcur + w1 * (fprev + fnext);
+			if (xc0) g += x0 * xc0[k - 1] + x1 * xc1[k - 1];
+			fprev = fcur; fcur = fnext;
+
+			real val = 1.0 / (b - talpha[k - 1]);
 
-			solution[p + (k - 1) * m] =
-				alpha[k] * solution[p + k * m] + invm * beta[k];
+			talpha[k] = val;
+			tbeta[k] = (tbeta[k - 1] - g) * val;
+		}
+
+		// top b.c.
+		real next = scale * ec[p];
+	
+		for (int k = n; k >= 1; k--)
+		{
+			next = talpha[k] * next + scale * tbeta[k];
+			solution[p + (k - 1) * ldsolution] = next;
 		}
 	}
 }
 
+// Solve m 3-diagonal systems of n equations using shutter
+// method in real space, as poisson2d_shutter_r, for the fourth
+// order compact (Mehrstellen) scheme:
+// (dxx + dyy + (hx^2 + hy^2) / 12 dxx dyy) U = (1 + hx^2 / 12 dxx + hy^2 / 12 dyy) F.
+// By X, dxx is diagonal in sine transform space: -sigma_p / hx^2.
+// The right hand side operator by Y is applied in the forward
+// sweep, extrapolating F to the boundary rows. The right hand side
+// values beyond X boundaries, divided by 12, are given by xc0 and xc1
+// for each row (or NULL): their transforms are added here.
+void poisson2d_shutter_compact_r(
+	int m, int n, real hx, real hy,
+	real* rhs, int ldrhs, real* solution, int ldsolution,
+	real* alpha, real* beta, real* bc, real* ec,
+	real* xc0, real* xc1, real scale, int nthreads)
+{
+	struct shutter_args_t args = { .m = m, .n = n, .hx = hx, .hy = hy,
+		.rhs = rhs, .ldrhs = ldrhs, .solution = solution,
+		.ldsolution = ldsolution, .alpha = alpha, .beta = beta,
+		.bc = bc, .ec = ec, .scale = scale, .xc0 = xc0, .xc1 = xc1 };
+	poisson2d_parallel_for(nthreads, m, shutter_compact_part, &args);
+}
@@ -0,0 +1,115 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "tuning.h"
+
+#include <omp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Filename of tuning database: text lines of backend, precision,
+// threading (serial or parallel solver), cores, m, n, the number
+// of threads and planner. The environment variable overrides it.
+#define FFT_TUNING_FILENAME ".tuning"
+#define FFT_TUNING_ENV "BREEZE2D_TUNING_FILE"
+
+#if defined(HAVE_FFTW)
+#define FFT_BACKEND "fftw"
+#elif defined(HAVE_FFTW_MKL)
+#define FFT_BACKEND "fftw_mkl"
+#elif defined(HAVE_MKL_DFTI)
+#define FFT_BACKEND "mkl_dfti"
+#else
+#define FFT_BACKEND "builtin"
+#endif
+
+#ifdef HAVE_SINGLE
+#define FFT_PRECISION "single"
+#else
+#define FFT_PRECISION "double"
+#endif
+
+// Solvers may be created by different threads.
+static pthread_mutex_t tuning_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Get the tuning database filename.
+static const char* tuning_filename()
+{
+	const char* filename = getenv(FFT_TUNING_ENV);
+	return (filename && filename[0]) ? filename : FFT_TUNING_FILENAME;
+}
+
+// Look up the configuration tuned for m x n problem of serial
+// or parallel solver with the current FFT backend, precision
+// and number of cores in the tuning database. Returns 1, if found.
+int fft_tuning_load(int m, int n, int serial, struct fft_tuning_t* tuning)
+{
+	int cores = omp_get_num_procs(), found = 0;
+	const char* threading = serial ? "serial" : "parallel";
+
+	pthread_mutex_lock(&tuning_mutex);
+	FILE* file = fopen(tuning_filename(), "r");
+	if (file)
+	{
+		char line[256];
+		while (fgets(line, sizeof(line), file))
+		{
+			char backend[32], precision[32], lthreading[32], planner[32];
+			int lcores, lm, ln, nthreads;
+			if (sscanf(line, "%31s %31s %31s %d %d %d %d %31s", backend,
+				precision, lthreading, &lcores, &lm, &ln, &nthreads, planner) != 8)
+				continue;
+			if (strcmp(backend, FFT_BACKEND) || strcmp(precision, FFT_PRECISION) ||
+				strcmp(lthreading, threading) ||
+				(lcores != cores) || (lm != m) || (ln != n) ||
+				(nthreads < 1) || (nthreads > cores))
+				continue;
+
+			// The last record wins.
+			tuning->nthreads = nthreads;
+			tuning->planner = strcmp(planner, "measure") ?
+				FFT_ESTIMATE : FFT_MEASURE;
+			found = 1;
+		}
+		fclose(file);
+	}
+	pthread_mutex_unlock(&tuning_mutex);
+
+	return found;
+}
+
+// Record the configuration tuned for m x n problem of serial
+// or parallel solver into the tuning database.
+void fft_tuning_save(int m, int n, int serial,
+	const struct fft_tuning_t* tuning)
+{
+	pthread_mutex_lock(&tuning_mutex);
+	FILE* file = fopen(tuning_filename(), "a");
+	if (file)
+	{
+		fprintf(file, "%s %s %s %d %d %d %d %s\n", FFT_BACKEND, FFT_PRECISION,
+			serial ? "serial" : "parallel", omp_get_num_procs(),
+			m, n, tuning->nthreads,
+			(tuning->planner == FFT_ESTIMATE) ? "estimate" : "measure");
+		fclose(file);
+	}
+	pthread_mutex_unlock(&tuning_mutex);
+}
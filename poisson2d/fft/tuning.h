@@ -0,0 +1,48 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef FFT_TUNING_H
+#define FFT_TUNING_H
+
+#include "wrapper.h"
+
+// Defines solver configuration selected by autotuning
+// (BREEZE2D_POISSON_AUTOTUNE).
+struct fft_tuning_t
+{
+	// The number of threads of transforms and shutter.
+	int nthreads;
+
+	// The planner flags: FFT_ESTIMATE or FFT_MEASURE.
+	unsigned planner;
+};
+
+// Look up the configuration tuned for m x n problem of serial
+// or parallel solver with the current FFT backend, precision
+// and number of cores in the tuning database (.tuning, or the
+// file named by BREEZE2D_TUNING_FILE environment variable).
+// Returns 1, if found.
+int fft_tuning_load(int m, int n, int serial, struct fft_tuning_t* tuning);
+
+// Record the configuration tuned for m x n problem of serial
+// or parallel solver into the tuning database.
+void fft_tuning_save(int m, int n, int serial,
+	const struct fft_tuning_t* tuning);
+
+#endif // FFT_TUNING_H
@@ -18,12 +18,28 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+
 #include "wrapper.h"
+#include "../parallel.h"
+#ifdef HAVE_MKL_DFTI
+#include "dfti.h"
+#include <mkl_service.h>
+#endif
+#ifdef HAVE_BUILTIN_FFT
+#include "builtin.h"
+#include <stdlib.h>
+#endif
 
 #include <assert.h>
+#include <errno.h>
 #include <malloc.h>
 #include <math.h>
+#include <pthread.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #ifdef HAVE_FFTW
 // Filename to store FFTW wisdom.
@@ -31,27 +47,149 @@
 static FILE* wisdom_file = NULL;
 #endif
 
+#if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
+// FFTW planner is not thread-safe, while plans may be created
+// by the solvers background planning threads: serialize plans
+// creation and destruction.
+static pthread_mutex_t planner_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+// The number of threads for further plans, as set
+// by fft_plan_with_nthreads (1, as FFTW starts with).
+static int plan_nthreads = 1;
+
+#ifdef HAVE_MKL_DFTI
+// The number of threads for further plans.
+static int dfti_nthreads = 1;
+#endif
+
+#ifdef HAVE_BUILTIN_FFT
+// The number of threads for further plans.
+static int builtin_nthreads = 1;
+#endif
+
+#ifdef HAVE_FFTW_MKL
+// The number of threads sharing the plans of rows
+// of further plans.
+static int mkl_nthreads = 1;
+#endif
+
 #ifdef HAVE_SINGLE
 #define FFTW(call) fftwf_##call
 #else
 #define FFTW(call) fftw_##call
 #endif 
 
+#ifdef HAVE_FFTW_MKL
+// Defines arguments of the plans of rows execution, passed
+// to the parts of parallel loop over rows.
+struct execute_args_t
+{
+	fft_plan* plan;
+	FFTW(plan)* plans;
+	real *in, *out;
+};
+
+// Execute the plans of rows begin .. end - 1 on the specified
+// arrays, or on the arrays they were created for, if in is NULL.
+static void execute_part(void* arg, int part, long begin, long end)
+{
+	const struct execute_args_t* args = (const struct execute_args_t*)arg;
+	fft_plan* plan = args->plan;
+
+	for (int i = begin; i < end; i++)
+	{
+		if (args->in)
+			FFTW(execute_r2r(args->plans[i],
+				args->in + i * plan->idist, args->out + i * plan->odist));
+		else
+			FFTW(execute(args->plans[i]));
+	}
+}
+
+// Execute the plans of rows, shared between the plan threads.
+static void execute_plans(fft_plan* plan, FFTW(plan)* plans,
+	real* in, real* out)
+{
+	int nthreads = poisson2d_parallel_nthreads();
+	if (nthreads > plan->nthreads) nthreads = plan->nthreads;
+
+	struct execute_args_t args = { plan, plans, in, out };
+	poisson2d_parallel_for(nthreads, plan->nplans, execute_part, &args);
+}
+#endif
+
+#ifdef HAVE_FFTW_THREADS_CALLBACK
+// Defines FFTW parallel loop.
+struct fftw_loop_t
+{
+	void* (*work)(char*);
+	char* jobdata;
+	size_t elsize;
+};
+
+// Perform FFTW jobs begin .. end - 1.
+static void fftw_loop_part(void* arg, int part, long begin, long end)
+{
+	const struct fftw_loop_t* loop = (const struct fftw_loop_t*)arg;
+	for (long i = begin; i < end; i++)
+		loop->work(loop->jobdata + loop->elsize * i);
+}
+
+// Perform FFTW parallel loop on the external executor.
+static void fftw_loop(void* (*work)(char*), char* jobdata,
+	size_t elsize, int njobs, void* data)
+{
+	struct fftw_loop_t loop = { work, jobdata, elsize };
+	poisson2d_parallel_for(njobs, njobs, fftw_loop_part, &loop);
+}
+#endif
+
+// Get the size of memory block holding fft processing
+// plan descriptor for the specified number of transforms.
+size_t fft_plan_size(int howmany)
+{
+#if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
+#ifdef HAVE_FFTW_MKL
+	int nplans = howmany;
+#else
+	int nplans = 1;
+#endif
+	fft_plan* plan;
+	return sizeof(fft_plan) +
+		nplans * (sizeof(plan->forward) + sizeof(plan->inverse));
+#else
+	// Batched transform state is allocated by plan.
+	return sizeof(fft_plan);
+#endif
+}
+
 // Create fft processing plan.
 fft_plan* fft_create(
 	int n, real* in, real* out,
 	fft_kind kind, unsigned flags)
+{
+	return fft_create_at(NULL, n, in, out, kind, flags);
+}
+
+// Create fft processing plan with descriptor placed
+// into the specified memory block of fft_plan_size(1) bytes.
+fft_plan* fft_create_at(void* desc,
+	int n, real* in, real* out,
+	fft_kind kind, unsigned flags)
 {
 	// TODO: link existing plans **.
-	fft_plan* plan = (fft_plan*)malloc(sizeof(fft_plan) +
-		sizeof(plan->forward) + sizeof(plan->inverse));
+	fft_plan* plan = (fft_plan*)(desc ? desc : malloc(fft_plan_size(1)));
+	plan->allocated = !desc;
 #if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
 	plan->forward = (FFTW(plan)*)(plan + 1);
 	plan->inverse = plan->forward + 1;
 #endif
 
 	plan->in = in; plan->out = out;
+	plan->scratch = 0;
 #if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
+	pthread_mutex_lock(&planner_mutex);
 #ifdef HAVE_FFTW
 	if (!wisdom_file)
 	{
@@ -63,10 +201,11 @@ fft_plan* fft_create(
 		}
 	}
 #endif
-	plan->forward[0] = FFTW(plan_r2r_1d(n, in, out, FFTW_RODFT00, flags));
-	if (!plan->forward)
+	plan->forward[0] = FFTW(plan_r2r_1d(n, in, out, kind, flags));
+	if (!plan->forward[0])
 	{
-		free(plan);
+		pthread_mutex_unlock(&planner_mutex);
+		if (plan->allocated) free(plan);
 		return NULL;
 	}
 	plan->inverse[0] = plan->forward[0];
@@ -78,6 +217,23 @@ fft_plan* fft_create(
 		fclose(wisdom_file);
 	}
 #endif
+	pthread_mutex_unlock(&planner_mutex);
+#endif
+#ifdef HAVE_MKL_DFTI
+	plan->dfti = fft_dfti_create(n, 1, kind, dfti_nthreads);
+	if (!plan->dfti)
+	{
+		if (plan->allocated) free(plan);
+		return NULL;
+	}
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	plan->builtin = fft_builtin_create(n, 1, kind, 1);
+	if (!plan->builtin)
+	{
+		if (plan->allocated) free(plan);
+		return NULL;
+	}
 #endif
 	plan->n = n;
 	plan->howmany = 1;
@@ -85,28 +241,45 @@ fft_plan* fft_create(
 	plan->odist = 0;
 	plan->nplans = 1;
 	plan->kind = kind;
+#ifdef HAVE_FFTW_MKL
+	plan->nthreads = 1;
+#endif
 
 	return plan;
 }
 
-// Create fft processing plan.
+// Create batched fft processing plan.
 fft_plan* fft_create_multi(int n, int howmany,
 	real* in, real* out, int idist, int odist,
 	fft_kind kind, unsigned flags)
+{
+	return fft_create_multi_at(NULL, n, howmany,
+		in, out, idist, odist, kind, flags);
+}
+
+// Create batched fft processing plan with descriptor placed
+// into the specified memory block of fft_plan_size(howmany) bytes.
+fft_plan* fft_create_multi_at(void* desc, int n, int howmany,
+	real* in, real* out, int idist, int odist,
+	fft_kind kind, unsigned flags)
 {
 #ifdef HAVE_FFTW_MKL
 	int nplans = howmany;
 #else
 	int nplans = 1;
 #endif
-	fft_plan* plan = (fft_plan*)malloc(sizeof(fft_plan) +
-		nplans * (sizeof(plan->forward) + sizeof(plan->inverse)));
+	fft_plan* plan = (fft_plan*)(desc ? desc : malloc(fft_plan_size(howmany)));
+	plan->allocated = !desc;
 #if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
 	plan->forward = (FFTW(plan)*)(plan + 1);
 	plan->inverse = plan->forward + nplans;
 #endif
 
 	plan->in = in; plan->out = out;
+	plan->scratch = 0;
+#if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
+	pthread_mutex_lock(&planner_mutex);
+#endif
 #ifdef HAVE_FFTW
 	int* nmany = (int*)malloc(sizeof(int) * howmany);
 	fft_kind* kindmany = (FFTW(r2r_kind)*)malloc(sizeof(FFTW(r2r_kind)) * howmany);
@@ -119,7 +292,8 @@ fft_plan* fft_create_multi(int n, int howmany,
 	free(nmany);
 	if (!plan->forward[0])
 	{
-		free(plan);
+		pthread_mutex_unlock(&planner_mutex);
+		if (plan->allocated) free(plan);
 		return NULL;
 	}
 	plan->inverse[0] = plan->forward[0];
@@ -135,10 +309,32 @@ fft_plan* fft_create_multi(int n, int howmany,
 		{
 			for (int k = 0; k < i; k++)
 				FFTW(destroy_plan(plan->forward[k]));
-			free(plan);
+			pthread_mutex_unlock(&planner_mutex);
+			if (plan->allocated) free(plan);
 			return NULL;
 		}
 	}
+#endif
+#if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
+	pthread_mutex_unlock(&planner_mutex);
+#endif
+#ifdef HAVE_MKL_DFTI
+	// Single batched descriptor for all rows.
+	plan->dfti = fft_dfti_create(n, howmany, kind, dfti_nthreads);
+	if (!plan->dfti)
+	{
+		if (plan->allocated) free(plan);
+		return NULL;
+	}
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	// Blocks of rows are shared between threads.
+	plan->builtin = fft_builtin_create(n, howmany, kind, builtin_nthreads);
+	if (!plan->builtin)
+	{
+		if (plan->allocated) free(plan);
+		return NULL;
+	}
 #endif
 	plan->n = n;
 	plan->howmany = howmany;
@@ -146,31 +342,126 @@ fft_plan* fft_create_multi(int n, int howmany,
 	plan->odist = odist;
 	plan->nplans = nplans;
 	plan->kind = kind;
+#ifdef HAVE_FFTW_MKL
+	plan->nthreads = mkl_nthreads;
+#endif
+
+	return plan;
+}
+
+// Create batched fft processing plan for in and out arrays with
+// descriptor placed into the specified memory block, planning on
+// the scratch arrays of the same alignment instead, so that in
+// and out contents are preserved and may be in use meanwhile.
+// Scratch arrays may be released once the plan is created.
+fft_plan* fft_create_multi_scratch_at(void* desc, int n, int howmany,
+	real* in, real* out, int idist, int odist,
+	fft_kind kind, unsigned flags,
+	real* scratch_in, real* scratch_out)
+{
+	fft_plan* plan = fft_create_multi_at(desc, n, howmany,
+		scratch_in, scratch_out, idist, odist, kind, flags);
+	if (!plan) return NULL;
+
+	// Plan is executed on the new arrays.
+	plan->in = in; plan->out = out;
+	plan->scratch = 1;
 
 	return plan;
 }
 
+// Rebind the plan to the specified arrays, having the same
+// alignment and in-place property, as the arrays plan was
+// created for.
+void fft_set_arrays(fft_plan* plan, real* in, real* out)
+{
+	plan->in = in; plan->out = out;
+	plan->scratch = 1;
+}
+
 // Execute fft forward transform.
 void fft_forward(fft_plan* plan)
 {
-#if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
+	if (plan->scratch)
+	{
+		fft_forward_at(plan, plan->in, plan->out);
+		return;
+	}
+#ifdef HAVE_FFTW
+	FFTW(execute(plan->forward[0]));
+#endif
 #ifdef HAVE_FFTW_MKL
-	#pragma omp parallel for
+	execute_plans(plan, plan->forward, NULL, NULL);
 #endif
-	for (int i = 0; i < plan->nplans; i++)
-		FFTW(execute(plan->forward[i]));
+#ifdef HAVE_MKL_DFTI
+	fft_dfti_execute(plan->dfti,
+		plan->in, plan->idist, plan->out, plan->odist);
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	fft_builtin_execute(plan->builtin,
+		plan->in, plan->idist, plan->out, plan->odist);
 #endif
 }
 
 // Execute fft forward transform.
 void fft_inverse(fft_plan* plan)
 {
-#if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
+	if (plan->scratch)
+	{
+		fft_inverse_at(plan, plan->in, plan->out);
+		return;
+	}
+#ifdef HAVE_FFTW
+	FFTW(execute(plan->inverse[0]));
+#endif
 #ifdef HAVE_FFTW_MKL
-	#pragma omp parallel for
+	execute_plans(plan, plan->inverse, NULL, NULL);
 #endif
-	for (int i = 0; i < plan->nplans; i++)
-		FFTW(execute(plan->inverse[i]));
+#ifdef HAVE_MKL_DFTI
+	fft_dfti_execute(plan->dfti,
+		plan->in, plan->idist, plan->out, plan->odist);
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	fft_builtin_execute(plan->builtin,
+		plan->in, plan->idist, plan->out, plan->odist);
+#endif
+}
+
+// Execute fft plan forward transform on the specified arrays,
+// having the same alignment and in-place property, as the arrays
+// plan was created for.
+void fft_forward_at(fft_plan* plan, real* in, real* out)
+{
+#ifdef HAVE_FFTW
+	FFTW(execute_r2r(plan->forward[0], in, out));
+#endif
+#ifdef HAVE_FFTW_MKL
+	execute_plans(plan, plan->forward, in, out);
+#endif
+#ifdef HAVE_MKL_DFTI
+	fft_dfti_execute(plan->dfti, in, plan->idist, out, plan->odist);
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	fft_builtin_execute(plan->builtin, in, plan->idist, out, plan->odist);
+#endif
+}
+
+// Execute fft plan inverse transform on the specified arrays,
+// having the same alignment and in-place property, as the arrays
+// plan was created for.
+void fft_inverse_at(fft_plan* plan, real* in, real* out)
+{
+#ifdef HAVE_FFTW
+	FFTW(execute_r2r(plan->inverse[0], in, out));
+#endif
+#ifdef HAVE_FFTW_MKL
+	execute_plans(plan, plan->inverse, in, out);
+#endif
+#ifdef HAVE_MKL_DFTI
+	fft_dfti_execute(plan->dfti, in, plan->idist, out, plan->odist);
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	fft_builtin_execute(plan->builtin, in, plan->idist, out, plan->odist);
 #endif
 }
 
@@ -178,10 +469,33 @@ void fft_inverse(fft_plan* plan)
 void fft_dispose(fft_plan* plan)
 {
 #if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
+	pthread_mutex_lock(&planner_mutex);
 	for (int i = 0; i < plan->nplans; i++)
 		FFTW(destroy_plan(plan->forward[i]));
+	pthread_mutex_unlock(&planner_mutex);
+#endif
+#ifdef HAVE_MKL_DFTI
+	fft_dfti_dispose(plan->dfti);
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	fft_builtin_dispose(plan->builtin);
+#endif
+	if (plan->allocated) free(plan);
+}
+
+// Save the accumulated planner wisdom, if supported by fft library.
+void fft_export_wisdom()
+{
+#ifdef HAVE_FFTW
+	pthread_mutex_lock(&planner_mutex);
+	FILE* file = fopen(FFTW_WISDOM_FILENAME, "w");
+	if (file)
+	{
+		FFTW(export_wisdom_to_file(file));
+		fclose(file);
+	}
+	pthread_mutex_unlock(&planner_mutex);
 #endif
-	free(plan);
 }
 
 // Initialize threading support for further
@@ -193,17 +507,39 @@ void fft_init_threads()
 	FFTW(init_threads());
 #endif
 #endif
+#ifdef HAVE_FFTW_THREADS_CALLBACK
+	// Run FFTW threads on the external executor, if set.
+	FFTW(threads_set_callback(poisson2d_parallel_external() ?
+		fftw_loop : NULL, NULL));
+#endif
 }
 
 // Set the number of devices (cpu threads or gpus)
 // to use for further fft processing plans.
 void fft_plan_with_nthreads(int nthreads)
 {
+	plan_nthreads = nthreads;
 #if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
 #if defined(HAVE_FFTW_THREADS)
 	FFTW(plan_with_nthreads(nthreads));
 #endif
 #endif
+#ifdef HAVE_MKL_DFTI
+	dfti_nthreads = nthreads;
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	builtin_nthreads = nthreads;
+#endif
+#ifdef HAVE_FFTW_MKL
+	mkl_nthreads = nthreads;
+#endif
+}
+
+// Get the number of threads to use for further fft
+// processing plans.
+int fft_get_plan_nthreads()
+{
+	return plan_nthreads;
 }
 
 // Malloc aligned data array of the specified size.
@@ -212,6 +548,14 @@ void* fft_malloc(size_t size)
 #if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
 	return FFTW(malloc(size));
 #endif
+#ifdef HAVE_MKL_DFTI
+	return mkl_malloc(size, FFT_ALIGNMENT);
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	void* ptr = NULL;
+	if (posix_memalign(&ptr, FFT_ALIGNMENT, size)) return NULL;
+	return ptr;
+#endif
 }
 
 // Release data array previously allocated with fft_malloc.
@@ -220,4 +564,163 @@ void fft_free(void* desc)
 #if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
 	FFTW(free(desc));
 #endif
+#ifdef HAVE_MKL_DFTI
+	mkl_free(desc);
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	free(desc);
+#endif
+}
+
+// Defines header of memory mapping created by fft_malloc_placed,
+// stored in front of the returned data array.
+typedef struct
+{
+	size_t length;
+	unsigned flags;
+}
+fft_mapping;
+
+#define FFT_HUGE_PAGE_SIZE (2 << 20)
+
+// Defines arguments of the first touch of data array rows.
+struct touch_args_t
+{
+	char* data;
+	size_t size, rowsize;
+};
+
+// Touch data array rows begin .. end - 1.
+static void touch_part(void* arg, int part, long begin, long end)
+{
+	const struct touch_args_t* args = (const struct touch_args_t*)arg;
+	for (long i = begin; i < end; i++)
+	{
+		size_t offset = i * args->rowsize;
+		size_t count = (offset + args->rowsize > args->size) ?
+			args->size - offset : args->rowsize;
+		memset(args->data + offset, 0, count);
+	}
+}
+
+// Malloc aligned data array of the specified size, composed
+// of rows of rowsize bytes, with the flags defining placement
+// of memory pages.
+void* fft_malloc_placed(size_t size, size_t rowsize, unsigned flags)
+{
+	size_t header = FFT_ALIGN(sizeof(fft_mapping));
+	size_t length = size + header;
+	char* mapping = MAP_FAILED;
+
+	// Explicit huge pages come from the preallocated pool
+	// (vm.nr_hugepages) and may be unavailable: then fall back
+	// to the transparent ones.
+	if (flags & FFT_MALLOC_HUGE_EXPLICIT)
+	{
+		length = (length + FFT_HUGE_PAGE_SIZE - 1) & ~(size_t)(FFT_HUGE_PAGE_SIZE - 1);
+		mapping = mmap(NULL, length, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (mapping == MAP_FAILED)
+		{
+			flags &= ~FFT_MALLOC_HUGE_EXPLICIT;
+			flags |= FFT_MALLOC_HUGE_TRANSPARENT;
+		}
+	}
+	if (mapping == MAP_FAILED)
+	{
+		mapping = mmap(NULL, length, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapping == MAP_FAILED) return NULL;
+	}
+#ifdef MADV_HUGEPAGE
+	if (flags & FFT_MALLOC_HUGE_TRANSPARENT)
+	{
+		if (madvise(mapping, length, MADV_HUGEPAGE))
+			flags &= ~FFT_MALLOC_HUGE_TRANSPARENT;
+	}
+#else
+	flags &= ~FFT_MALLOC_HUGE_TRANSPARENT;
+#endif
+
+	fft_mapping* desc = (fft_mapping*)mapping;
+	desc->length = length;
+	desc->flags = flags;
+	char* data = mapping + header;
+
+	// Touch pages first by the same threads that process
+	// the corresponding rows in fft batches, so that pages
+	// are placed on their NUMA nodes. Rows are distributed
+	// between threads in contiguous blocks, like the static
+	// schedule of fft batches. The shutter splits columns
+	// instead, no row placement suits it.
+	if (flags & FFT_MALLOC_FIRST_TOUCH)
+	{
+		if (!rowsize) rowsize = size;
+		struct touch_args_t args = { data, size, rowsize };
+		poisson2d_parallel_for(poisson2d_parallel_nthreads(),
+			(size + rowsize - 1) / rowsize, touch_part, &args);
+	}
+
+	return data;
+}
+
+// Get the placement flags in effect for the data array
+// previously allocated with fft_malloc_placed.
+unsigned fft_malloc_flags(void* desc)
+{
+	fft_mapping* mapping = (fft_mapping*)((char*)desc -
+		FFT_ALIGN(sizeof(fft_mapping)));
+	return mapping->flags;
+}
+
+// Count memory pages of the specified data array residing
+// on each NUMA node. Returns the number of nodes reported
+// (at most maxnodes), or -1, if placement query is not
+// supported by the system.
+int fft_placement(void* desc, size_t size, long* npages, int maxnodes)
+{
+#ifdef SYS_move_pages
+	long pagesize = sysconf(_SC_PAGESIZE);
+	char* begin = (char*)((size_t)desc & ~(size_t)(pagesize - 1));
+	char* end = (char*)desc + size;
+
+	for (int i = 0; i < maxnodes; i++)
+		npages[i] = 0;
+
+	// Query pages in chunks: with NULL target nodes
+	// move_pages only reports the current node of each page.
+	enum { chunk = 1024 };
+	void* pages[chunk];
+	int status[chunk];
+	int nnodes = 0;
+	for (char* ptr = begin; ptr < end; )
+	{
+		int count = 0;
+		for ( ; (count < chunk) && (ptr < end); count++, ptr += pagesize)
+			pages[count] = ptr;
+		if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0))
+			return -1;
+		for (int i = 0; i < count; i++)
+		{
+			// Negative status is returned for pages not yet
+			// touched (-ENOENT).
+			if ((status[i] < 0) || (status[i] >= maxnodes)) continue;
+			npages[status[i]]++;
+			if (status[i] >= nnodes) nnodes = status[i] + 1;
+		}
+	}
+
+	return nnodes;
+#else
+	return -1;
+#endif
+}
+
+// Release data array previously allocated with fft_malloc_placed.
+void fft_free_placed(void* desc)
+{
+	if (!desc) return;
+	fft_mapping* mapping = (fft_mapping*)((char*)desc -
+		FFT_ALIGN(sizeof(fft_mapping)));
+	munmap(mapping, mapping->length);
 }
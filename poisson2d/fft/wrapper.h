@@ -30,8 +30,26 @@
 
 #include <breeze2d.h>
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
 #if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
 typedef fftw_r2r_kind fft_kind;
+#define FFT_RODFT00	FFTW_RODFT00
+#define FFT_REDFT00	FFTW_REDFT00
+#else
+// Transform kinds, in FFTW r2r conventions: sine transform
+// (DST-I) and cosine transform (DCT-I).
+typedef enum { FFT_RODFT00, FFT_REDFT00 } fft_kind;
+#endif
+
+#ifdef HAVE_MKL_DFTI
+struct fft_dfti_t;
+#endif
+#ifdef HAVE_BUILTIN_FFT
+struct fft_builtin_t;
 #endif
 
 #ifdef HAVE_FFTW
@@ -46,6 +64,13 @@ typedef fftw_r2r_kind fft_kind;
 #define FFT_WISDOM_ONLY	0
 #endif
 
+// Alignment of data arrays and workspace blocks.
+#define FFT_ALIGNMENT	64
+
+// Round the specified size up to FFT_ALIGNMENT.
+#define FFT_ALIGN(size) \
+	(((size) + FFT_ALIGNMENT - 1) & ~(size_t)(FFT_ALIGNMENT - 1))
+
 // Defines extended fft plan structure,
 // incorporating settings specific to different
 // fft libraries.
@@ -55,6 +80,11 @@ typedef struct
 	fft_kind kind;
 	int n, nplans, howmany;
 	int idist, odist;
+	int allocated; // descriptor memory is owned by plan
+	int scratch; // plan is created on scratch arrays, other than in and out
+#ifdef HAVE_FFTW_MKL
+	int nthreads; // threads sharing the plans of rows
+#endif
 #if defined(HAVE_FFTW) || defined(HAVE_FFTW_MKL)
 #ifdef HAVE_SINGLE
 	fftwf_plan *forward, *inverse;
@@ -63,28 +93,78 @@ typedef struct
 	fftw_plan *forward, *inverse;
 #endif
 #endif
+#ifdef HAVE_MKL_DFTI
+	struct fft_dfti_t* dfti;
+#endif
+#ifdef HAVE_BUILTIN_FFT
+	struct fft_builtin_t* builtin;
+#endif
 }
 fft_plan;
 
+// Get the size of memory block holding fft processing
+// plan descriptor for the specified number of transforms.
+size_t fft_plan_size(int howmany);
+
 // Create fft processing plan.
 fft_plan* fft_create(
 	int n, real* in, real* out,
 	fft_kind kind, unsigned flags);
 
+// Create fft processing plan with descriptor placed
+// into the specified memory block of fft_plan_size(1) bytes.
+fft_plan* fft_create_at(void* desc,
+	int n, real* in, real* out,
+	fft_kind kind, unsigned flags);
+
 // Create batched fft processing plan.
 fft_plan* fft_create_multi(int n, int howmany,
 	real* in, real* out, int idist, int odist,
 	fft_kind kind, unsigned flags);
 
+// Create batched fft processing plan with descriptor placed
+// into the specified memory block of fft_plan_size(howmany) bytes.
+fft_plan* fft_create_multi_at(void* desc, int n, int howmany,
+	real* in, real* out, int idist, int odist,
+	fft_kind kind, unsigned flags);
+
+// Create batched fft processing plan for in and out arrays with
+// descriptor placed into the specified memory block, planning on
+// the scratch arrays of the same alignment instead, so that in
+// and out contents are preserved and may be in use meanwhile.
+// Scratch arrays may be released once the plan is created.
+fft_plan* fft_create_multi_scratch_at(void* desc, int n, int howmany,
+	real* in, real* out, int idist, int odist,
+	fft_kind kind, unsigned flags,
+	real* scratch_in, real* scratch_out);
+
+// Rebind the plan to the specified arrays, having the same
+// alignment and in-place property, as the arrays plan was
+// created for.
+void fft_set_arrays(fft_plan* plan, real* in, real* out);
+
 // Execute fft plan forward transform.
 void fft_forward(fft_plan* plan);
 
 // Execute fft plan inverse transform.
 void fft_inverse(fft_plan* plan);
 
+// Execute fft plan forward transform on the specified arrays,
+// having the same alignment and in-place property, as the arrays
+// plan was created for.
+void fft_forward_at(fft_plan* plan, real* in, real* out);
+
+// Execute fft plan inverse transform on the specified arrays,
+// having the same alignment and in-place property, as the arrays
+// plan was created for.
+void fft_inverse_at(fft_plan* plan, real* in, real* out);
+
 // Destroy the fft processing plan.
 void fft_dispose(fft_plan* plan);
 
+// Save the accumulated planner wisdom, if supported by fft library.
+void fft_export_wisdom();
+
 // Initialize threading support for further
 // fft processing.
 void fft_init_threads();
@@ -93,11 +173,40 @@ void fft_init_threads();
 // to use for further fft processing plans.
 void fft_plan_with_nthreads(int nthreads);
 
+// Get the number of threads to use for further fft
+// processing plans (as set by fft_plan_with_nthreads).
+int fft_get_plan_nthreads();
+
 // Malloc aligned data array of the specified size.
 void* fft_malloc(size_t size);
 
 // Release data array previously allocated with fft_malloc.
 void fft_free(void* desc);
 
+// Placement flags for fft_malloc_placed.
+#define FFT_MALLOC_FIRST_TOUCH		1
+#define FFT_MALLOC_HUGE_TRANSPARENT	2
+#define FFT_MALLOC_HUGE_EXPLICIT	4
+
+// Malloc aligned data array of the specified size, composed
+// of rows of rowsize bytes, with the flags defining placement
+// of memory pages.
+void* fft_malloc_placed(size_t size, size_t rowsize, unsigned flags);
+
+// Get the placement flags in effect for the data array
+// previously allocated with fft_malloc_placed.
+unsigned fft_malloc_flags(void* desc);
+
+// Count memory pages of the specified data array residing
+// on each NUMA node.
+int fft_placement(void* desc, size_t size, long* npages, int maxnodes);
+
+// Release data array previously allocated with fft_malloc_placed.
+void fft_free_placed(void* desc);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
 #endif // FFT_WRAPPER_H
 
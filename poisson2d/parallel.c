@@ -0,0 +1,142 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <breeze2d.h>
+
+#include "parallel.h"
+
+#include <omp.h>
+#include <pthread.h>
+
+// The external executor, used if run is set. Loops run on
+// other threads (e.g. asynchronous solves) while it is set,
+// so it is only accessed under mutex, as a whole.
+static breeze2d_executor executor;
+static pthread_mutex_t executor_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// The executor of the calling thread, used instead of the
+// external one, if run is set (e.g. by solve queue workers).
+static __thread breeze2d_executor thread_executor;
+
+// Get the copy of the executor of the calling thread,
+// or of the external executor.
+static breeze2d_executor get_executor()
+{
+	if (thread_executor.run)
+		return thread_executor;
+
+	pthread_mutex_lock(&executor_mutex);
+	breeze2d_executor current = executor;
+	pthread_mutex_unlock(&executor_mutex);
+	return current;
+}
+
+// Defines parallel loop passed to the executor tasks.
+struct loop_t
+{
+	int nparts;
+	long count;
+	void (*body)(void* arg, int part, long begin, long end);
+	void* arg;
+};
+
+// Run the specified part of parallel loop.
+static void run_part(const struct loop_t* loop, int part)
+{
+	long chunk = loop->count / loop->nparts;
+	long rest = loop->count % loop->nparts;
+	long begin = part * chunk + (part < rest ? part : rest);
+	long end = begin + chunk + (part < rest ? 1 : 0);
+	loop->body(loop->arg, part, begin, end);
+}
+
+// Run the executor task.
+static void task(void* arg, int index)
+{
+	run_part((const struct loop_t*)arg, index);
+}
+
+// Set the external executor of the library parallel loops.
+void breeze2d_set_executor(const breeze2d_executor* desc)
+{
+	pthread_mutex_lock(&executor_mutex);
+	if (desc && desc->run && (desc->nthreads > 0))
+		executor = *desc;
+	else
+		executor.run = NULL;
+	pthread_mutex_unlock(&executor_mutex);
+}
+
+// Set the executor of parallel loops of the calling thread.
+void poisson2d_parallel_set_thread_executor(const breeze2d_executor* desc)
+{
+	if (desc && desc->run && (desc->nthreads > 0))
+		thread_executor = *desc;
+	else
+		thread_executor.run = NULL;
+}
+
+// Get the number of threads for parallel loops.
+int poisson2d_parallel_nthreads()
+{
+	breeze2d_executor executor = get_executor();
+	if (executor.run)
+		return executor.nthreads;
+	if (omp_get_active_level() >= omp_get_max_active_levels())
+		return 1;
+	return omp_get_max_threads();
+}
+
+// Check if the external executor is set.
+int poisson2d_parallel_external()
+{
+	return get_executor().run != NULL;
+}
+
+// Run parallel loop of nparts contiguous ranges.
+void poisson2d_parallel_for(int nparts, long count,
+	void (*body)(void* arg, int part, long begin, long end), void* arg)
+{
+	// The whole loop runs on the same executor.
+	breeze2d_executor executor = get_executor();
+	if (executor.run && (nparts > executor.nthreads))
+		nparts = executor.nthreads;
+	if (nparts > count) nparts = count;
+	if (nparts < 1) return;
+
+	struct loop_t loop = { nparts, count, body, arg };
+
+	if (nparts == 1)
+	{
+		run_part(&loop, 0);
+		return;
+	}
+
+	if (executor.run)
+	{
+		executor.run(executor.context, nparts, task, &loop);
+		return;
+	}
+
+	// The team may be smaller than requested.
+	#pragma omp parallel num_threads(nparts)
+	for (int part = omp_get_thread_num(); part < nparts;
+		part += omp_get_num_threads())
+		run_part(&loop, part);
+}
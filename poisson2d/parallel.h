@@ -0,0 +1,55 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef POISSON2D_PARALLEL_H
+#define POISSON2D_PARALLEL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+// Set the executor of parallel loops of the calling thread,
+// used instead of the external one, or remove it, if NULL.
+void poisson2d_parallel_set_thread_executor(const breeze2d_executor* executor);
+
+// Get the number of threads for parallel loops: the threads
+// of the executor of the calling thread or of the external
+// executor, if set, or the caller OpenMP threads (1 within
+// active parallel region, if nested parallelism is disabled).
+int poisson2d_parallel_nthreads();
+
+// Check if the executor of the calling thread
+// or the external executor is set.
+int poisson2d_parallel_external();
+
+// Split count iterations into nparts contiguous ranges, as
+// the OpenMP static schedule does, and call body(arg, part,
+// begin, end) for each range on the external executor, or on
+// OpenMP threads. Each part is run by a single thread, so that
+// it may use per-thread workspace of its index. A single part
+// is run in the calling thread.
+void poisson2d_parallel_for(int nparts, long count,
+	void (*body)(void* arg, int part, long begin, long end), void* arg);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // POISSON2D_PARALLEL_H
@@ -0,0 +1,397 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pcg.h"
+#include "../parallel.h"
+
+#include <math.h>
+
+// Compute the stencil in single point from the point
+// value x and its neighbours values.
+static inline real stencil(real x, real left, real right,
+	real below, real above, real kl, real kr, real kb, real ka,
+	real invhx2, real invhy2)
+{
+	return (kr * (right - x) - kl * (x - left)) * invhx2 +
+		(ka * (above - x) - kb * (x - below)) * invhy2;
+}
+
+// Arguments of the operator and vector loops, split between
+// parts: each part leaves its two partial sums in sums.
+struct pcg_args_t
+{
+	struct poisson2d_elliptic_t* op;
+	const real *x, *dot, *f;
+	real *y, *phi, *r, *p, *q, *w, *rhat;
+	real alpha, beta, omega;
+	int norm2;
+	double* sums;
+};
+
+// Run the loop body over count points or rows, and sum the
+// partial sums of parts in part order.
+static void reduce(struct poisson2d_elliptic_t* op, long count,
+	void (*body)(void*, int, long, long), struct pcg_args_t* args,
+	double* sum0, double* sum1)
+{
+	int nthreads = op->nthreads;
+	double sums[2 * nthreads];
+	for (int part = 0; part < 2 * nthreads; part++)
+		sums[part] = 0.0;
+	args->sums = sums;
+
+	poisson2d_parallel_for(nthreads, count, body, args);
+
+	double s0 = 0.0, s1 = 0.0;
+	for (int part = 0; part < nthreads; part++)
+	{
+		s0 += sums[2 * part];
+		s1 += sums[2 * part + 1];
+	}
+	if (sum0) *sum0 = s0;
+	if (sum1) *sum1 = s1;
+}
+
+// Apply the elliptic operator to the specified range of rows.
+static void apply_part(void* arg, int part, long begin, long end)
+{
+	struct pcg_args_t* args = (struct pcg_args_t*)arg;
+	struct poisson2d_elliptic_t* op = args->op;
+	int m = op->m, n = op->n;
+	real invhx2 = 1.0 / (op->hx * op->hx);
+	real invhy2 = 1.0 / (op->hy * op->hy);
+	const real *x = args->x, *dot = args->dot;
+	real* y = args->y;
+
+	double sum = 0.0, sum2 = 0.0;
+	for (int j = begin; j < end; j++)
+	{
+		const real* xj = x + j * m;
+		const real* below = j ? xj - m : op->zero;
+		const real* above = (j < n - 1) ? xj + m : op->zero;
+		const real* kx = op->kx + j * (m + 1);
+		const real* kb = op->ky + j * m;
+		const real* ka = kb + m;
+		real* yj = y + j * m;
+
+		// Points next to X boundaries.
+		yj[0] = stencil(xj[0], 0.0, (m > 1) ? xj[1] : 0.0,
+			below[0], above[0], kx[0], kx[1], kb[0], ka[0],
+			invhx2, invhy2);
+		if (m > 1)
+			yj[m - 1] = stencil(xj[m - 1], xj[m - 2], 0.0,
+				below[m - 1], above[m - 1], kx[m - 1], kx[m],
+				kb[m - 1], ka[m - 1], invhx2, invhy2);
+
+		#pragma omp simd
+		for (int i = 1; i < m - 1; i++)
+			yj[i] = stencil(xj[i], xj[i - 1], xj[i + 1],
+				below[i], above[i], kx[i], kx[i + 1], kb[i], ka[i],
+				invhx2, invhy2);
+
+		if (dot)
+		{
+			const real* dotj = dot + j * m;
+			#pragma omp simd reduction(+:sum)
+			for (int i = 0; i < m; i++)
+				sum += dotj[i] * yj[i];
+		}
+		if (args->norm2)
+		{
+			#pragma omp simd reduction(+:sum2)
+			for (int i = 0; i < m; i++)
+				sum2 += yj[i] * yj[i];
+		}
+	}
+
+	args->sums[2 * part] = sum;
+	args->sums[2 * part + 1] = sum2;
+}
+
+// Apply the elliptic operator: y = div(k grad x).
+// Return the dot product of y with the specified vector,
+// if not NULL, and the squared norm of y, if norm2 is not
+// NULL (fused into the same pass).
+double poisson2d_elliptic_apply(struct poisson2d_elliptic_t* op,
+	const real* x, real* y, const real* dot, double* norm2)
+{
+	struct pcg_args_t args = { .op = op, .x = x, .y = y, .dot = dot,
+		.norm2 = norm2 != NULL };
+	double sum;
+	reduce(op, op->n, apply_part, &args, &sum, norm2);
+	return sum;
+}
+
+// Initial residual r = f - q, copied to w, fused with
+// the squared norms of f and r.
+static void residual_part(void* arg, int part, long begin, long end)
+{
+	struct pcg_args_t* args = (struct pcg_args_t*)arg;
+	const real *f = args->f, *q = args->q;
+	real *r = args->r, *w = args->w;
+
+	double fnorm = 0.0, rnorm = 0.0;
+	#pragma omp simd reduction(+:fnorm,rnorm)
+	for (long i = begin; i < end; i++)
+	{
+		r[i] = f[i] - q[i];
+		w[i] = r[i];
+		fnorm += f[i] * f[i];
+		rnorm += r[i] * r[i];
+	}
+
+	args->sums[2 * part] = fnorm;
+	args->sums[2 * part + 1] = rnorm;
+}
+
+// Solution and residual updates phi += alpha * p,
+// r -= alpha * q, fused with residual norm and copy of
+// residual to w, if not NULL, or with (rhat, r) otherwise.
+static void update_part(void* arg, int part, long begin, long end)
+{
+	struct pcg_args_t* args = (struct pcg_args_t*)arg;
+	const real *p = args->p, *q = args->q, *rhat = args->rhat;
+	real *phi = args->phi, *r = args->r, *w = args->w;
+	real alpha = args->alpha;
+
+	double rnorm = 0.0, rhonew = 0.0;
+	if (w)
+	{
+		#pragma omp simd reduction(+:rnorm)
+		for (long i = begin; i < end; i++)
+		{
+			phi[i] += alpha * p[i];
+			r[i] -= alpha * q[i];
+			w[i] = r[i];
+			rnorm += r[i] * r[i];
+		}
+	}
+	else
+	{
+		#pragma omp simd reduction(+:rnorm,rhonew)
+		for (long i = begin; i < end; i++)
+		{
+			phi[i] += alpha * p[i];
+			r[i] -= alpha * q[i];
+			rnorm += r[i] * r[i];
+			rhonew += rhat[i] * r[i];
+		}
+	}
+
+	args->sums[2 * part] = rnorm;
+	args->sums[2 * part + 1] = rhonew;
+}
+
+// Dot product (r, w), fused with copy of w to p, if not NULL.
+static void dot_part(void* arg, int part, long begin, long end)
+{
+	struct pcg_args_t* args = (struct pcg_args_t*)arg;
+	const real *r = args->r, *w = args->w;
+	real* p = args->p;
+
+	double rw = 0.0;
+	if (p)
+	{
+		#pragma omp simd reduction(+:rw)
+		for (long i = begin; i < end; i++)
+		{
+			p[i] = w[i];
+			rw += r[i] * w[i];
+		}
+	}
+	else
+	{
+		#pragma omp simd reduction(+:rw)
+		for (long i = begin; i < end; i++)
+			rw += r[i] * w[i];
+	}
+
+	args->sums[2 * part] = rw;
+	args->sums[2 * part + 1] = 0.0;
+}
+
+// Search direction p = w + beta * p.
+static void direction_part(void* arg, int part, long begin, long end)
+{
+	struct pcg_args_t* args = (struct pcg_args_t*)arg;
+	const real* w = args->w;
+	real* p = args->p;
+	real beta = args->beta;
+
+	#pragma omp simd
+	for (long i = begin; i < end; i++)
+		p[i] = w[i] + beta * p[i];
+}
+
+// Search direction p = r + beta * (p - omega * q), or
+// p = r if beta is zero, fused with copy of p to w.
+static void bicgstab_direction_part(void* arg, int part, long begin, long end)
+{
+	struct pcg_args_t* args = (struct pcg_args_t*)arg;
+	const real *r = args->r, *q = args->q;
+	real *p = args->p, *w = args->w;
+	real beta = args->beta, omega = args->omega;
+
+	if (beta == 0.0)
+	{
+		#pragma omp simd
+		for (long i = begin; i < end; i++)
+			w[i] = p[i] = r[i];
+	}
+	else
+	{
+		#pragma omp simd
+		for (long i = begin; i < end; i++)
+			w[i] = p[i] = r[i] + beta * (p[i] - omega * q[i]);
+	}
+}
+
+// Solve using preconditioned conjugate gradient method.
+// The preconditioner right hand side receives the residual
+// in the same pass, as it is updated, and the preconditioner
+// solution is used as the preconditioned residual directly.
+int poisson2d_pcg(struct poisson2d_elliptic_t* op,
+	const real* f, real* phi)
+{
+	long size = (long)op->m * op->n;
+	real *r = op->r, *p = op->p, *q = op->v;
+	real *prhs = op->prhs, *z = op->psolution;
+
+	// Initial residual.
+	poisson2d_elliptic_apply(op, phi, q, NULL, NULL);
+	double fnorm, rnorm;
+	struct pcg_args_t args = { .op = op, .f = f, .q = q, .r = r, .w = prhs };
+	reduce(op, size, residual_part, &args, &fnorm, &rnorm);
+	if (fnorm == 0.0) fnorm = 1.0;
+	double tolerance2 = (double)op->tolerance * op->tolerance * fnorm;
+
+	op->residual = sqrt(rnorm / fnorm);
+	if (rnorm <= tolerance2) return 0;
+
+	breeze2d_poisson_solve(op->precond);
+
+	double rz;
+	args = (struct pcg_args_t){ .op = op, .r = r, .w = z, .p = p };
+	reduce(op, size, dot_part, &args, &rz, NULL);
+
+	for (int iter = 1; iter <= op->maxiters; iter++)
+	{
+		// Operator fused with (p, q).
+		double pq = poisson2d_elliptic_apply(op, p, q, p, NULL);
+		real alpha = rz / pq;
+
+		// Solution and residual updates fused with
+		// residual norm and preconditioner input.
+		args = (struct pcg_args_t){ .op = op, .phi = phi, .p = p,
+			.q = q, .r = r, .w = prhs, .alpha = alpha };
+		reduce(op, size, update_part, &args, &rnorm, NULL);
+
+		op->residual = sqrt(rnorm / fnorm);
+		if (rnorm <= tolerance2) return iter;
+
+		breeze2d_poisson_solve(op->precond);
+
+		double rznew;
+		args = (struct pcg_args_t){ .op = op, .r = r, .w = z };
+		reduce(op, size, dot_part, &args, &rznew, NULL);
+		real beta = rznew / rz;
+		rz = rznew;
+
+		args = (struct pcg_args_t){ .op = op, .w = z, .p = p, .beta = beta };
+		poisson2d_parallel_for(op->nthreads, size, direction_part, &args);
+	}
+
+	return -op->maxiters;
+}
+
+// Solve using preconditioned stabilized biconjugate gradient
+// method (right preconditioning). Preconditioner input is filled
+// in the same passes as search direction and intermediate residual
+// s (kept in r), and preconditioner solutions y and z are consumed
+// before the next preconditioner solve.
+// On breakdown (zero denominator), returns minus
+// the number of iterations performed.
+int poisson2d_bicgstab(struct poisson2d_elliptic_t* op,
+	const real* f, real* phi)
+{
+	long size = (long)op->m * op->n;
+	real *r = op->r, *rhat = op->rhat, *p = op->p, *v = op->v, *t = op->t;
+	real *prhs = op->prhs, *y = op->psolution;
+
+	// Initial residual.
+	poisson2d_elliptic_apply(op, phi, v, NULL, NULL);
+	double fnorm, rnorm;
+	struct pcg_args_t args = { .op = op, .f = f, .q = v, .r = r, .w = rhat };
+	reduce(op, size, residual_part, &args, &fnorm, &rnorm);
+	if (fnorm == 0.0) fnorm = 1.0;
+	double tolerance2 = (double)op->tolerance * op->tolerance * fnorm;
+
+	op->residual = sqrt(rnorm / fnorm);
+	if (rnorm <= tolerance2) return 0;
+
+	double rho = rnorm, rhonew = rnorm;
+	real alpha = 1.0, omega = 1.0;
+	for (int iter = 1; iter <= op->maxiters; iter++)
+	{
+		// Search direction, fused with preconditioner input.
+		real beta = (iter == 1) ? 0.0 : (rhonew / rho) * (alpha / omega);
+		args = (struct pcg_args_t){ .op = op, .r = r, .q = v, .p = p,
+			.w = prhs, .beta = beta, .omega = omega };
+		poisson2d_parallel_for(op->nthreads, size,
+			bicgstab_direction_part, &args);
+		rho = rhonew;
+
+		breeze2d_poisson_solve(op->precond);
+
+		// Operator fused with (rhat, v).
+		double rhatv = poisson2d_elliptic_apply(op, y, v, rhat, NULL);
+		if (rhatv == 0.0) return -iter;
+		alpha = rho / rhatv;
+
+		// Intermediate residual s, fused with its norm
+		// and preconditioner input.
+		args = (struct pcg_args_t){ .op = op, .phi = phi, .p = y,
+			.q = v, .r = r, .w = prhs, .alpha = alpha };
+		reduce(op, size, update_part, &args, &rnorm, NULL);
+
+		op->residual = sqrt(rnorm / fnorm);
+		if (rnorm <= tolerance2) return iter;
+
+		breeze2d_poisson_solve(op->precond);
+
+		// Operator fused with (s, t) and (t, t).
+		real* z = y;
+		double tt;
+		double ts = poisson2d_elliptic_apply(op, z, t, r, &tt);
+		if (tt == 0.0) return -iter;
+		omega = ts / tt;
+
+		// Residual update, fused with its norm and (rhat, r).
+		args = (struct pcg_args_t){ .op = op, .phi = phi, .p = z,
+			.q = t, .r = r, .rhat = rhat, .alpha = omega };
+		reduce(op, size, update_part, &args, &rnorm, &rhonew);
+
+		op->residual = sqrt(rnorm / fnorm);
+		if (rnorm <= tolerance2) return iter;
+		if ((omega == 0.0) || (rhonew == 0.0)) return -iter;
+	}
+
+	return -op->maxiters;
+}
@@ -0,0 +1,69 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PCG_H
+#define PCG_H
+
+#include <breeze2d.h>
+
+// Defines internal structure for iterative elliptic solver.
+struct poisson2d_elliptic_t
+{
+	int method;
+	int m, n;
+	real hx, hy;
+
+	// Face coefficients.
+	const real *kx, *ky;
+
+	// Preconditioner and its data arrays.
+	breeze2d_poisson_solver precond;
+	real *prhs, *psolution;
+
+	// Convergence criteria and the last reached residual.
+	real tolerance;
+	int maxiters;
+	real residual;
+
+	// Number of threads of the current solve.
+	int nthreads;
+
+	// Iteration vectors, and zero row standing for
+	// the boundaries in stencil.
+	real *r, *rhat, *p, *v, *t;
+	real* zero;
+};
+
+// Apply the elliptic operator: y = div(k grad x).
+// Return the dot product of y with the specified vector,
+// if not NULL, and the squared norm of y, if norm2 is not
+// NULL (fused into the same pass).
+double poisson2d_elliptic_apply(struct poisson2d_elliptic_t* op,
+	const real* x, real* y, const real* dot, double* norm2);
+
+// Solve using preconditioned conjugate gradient method.
+int poisson2d_pcg(struct poisson2d_elliptic_t* op,
+	const real* f, real* phi);
+
+// Solve using preconditioned stabilized biconjugate gradient method.
+int poisson2d_bicgstab(struct poisson2d_elliptic_t* op,
+	const real* f, real* phi);
+
+#endif // PCG_H
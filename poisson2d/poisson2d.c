@@ -21,15 +21,23 @@
 #include <breeze2d.h>
 #include <malloc.h>
 
+#include "capacitance/capacitance.h"
 #include "fft/fft.h"
+#include "fft/wrapper.h"
 
 // Defines internal structure for solver.
 struct breeze2d_poisson_solver_t
 {
 	int mode;
 	void* desc; // nested solver descriptor
+	int allocated; // solver memory is owned by solver
+	real *rhs, *solution;
+	unsigned int m, n;
+	unsigned int offset; // of the first element in padded arrays
 };
 
+#define SOLVER_SIZE FFT_ALIGN(sizeof(struct breeze2d_poisson_solver_t))
+
 // Initialize 2D Poisson equation solver for the
 // specified problem size and data arrays.
 // Note m and n are the numbers of INNER grid points,
@@ -43,11 +51,19 @@ breeze2d_poisson_solver breeze2d_poisson_solver_init(int mode,
 		(struct breeze2d_poisson_solver_t*)malloc(
 			sizeof(struct breeze2d_poisson_solver_t));
 	solver->mode = mode;
+	solver->allocated = 1;
+	solver->rhs = rhs; solver->solution = solution;
+	solver->m = m; solver->n = n; solver->offset = 0;
 
-	switch (solver->mode)
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
 	{
 	case BREEZE2D_POISSON_SOLVER_FFT :
 		solver->desc = poisson2d_fft_solver_init(
+			m, n, hx, hy, bx, ex, by, ey, rhs, solution, m,
+			mode & ~BREEZE2D_POISSON_SOLVER_MASK);
+		break;
+	case BREEZE2D_POISSON_SOLVER_CAPACITANCE :
+		solver->desc = poisson2d_capacitance_solver_init(
 			m, n, hx, hy, bx, ex, by, ey, rhs, solution);
 		break;
 	default :
@@ -56,6 +72,110 @@ breeze2d_poisson_solver breeze2d_poisson_solver_init(int mode,
 		return NULL;
 	}
 	
+	if (!solver->desc)
+	{
+		free(solver);
+		return NULL;
+	}
+
+	return (breeze2d_poisson_solver)solver;
+}
+
+// Get the size of workspace memory used by 2D Poisson
+// equation solver of the specified problem size.
+size_t breeze2d_poisson_solver_workspace_size(int mode,
+	unsigned int m, unsigned int n)
+{
+	switch (mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		return SOLVER_SIZE + poisson2d_fft_solver_workspace_size(
+			m, n, mode & ~BREEZE2D_POISSON_SOLVER_MASK);
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+	
+	return 0;
+}
+
+// Initialize 2D Poisson equation solver for the
+// specified problem size and data arrays, placing all
+// solver data into the caller-provided workspace.
+breeze2d_poisson_solver breeze2d_poisson_solver_init_workspace(int mode,
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* bx, real* ex, real* by, real* ey,
+	real* rhs, real* solution, void* workspace, size_t size)
+{
+	if (((size_t)workspace % FFT_ALIGNMENT) || (size < SOLVER_SIZE))
+	{
+		breeze2d_set_error(BREEZE2D_INSUFFICIENT_WORKSPACE);
+		return NULL;
+	}
+
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)workspace;
+	solver->mode = mode;
+	solver->allocated = 0;
+	solver->rhs = rhs; solver->solution = solution;
+	solver->m = m; solver->n = n; solver->offset = 0;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		solver->desc = poisson2d_fft_solver_init_workspace(
+			m, n, hx, hy, bx, ex, by, ey, rhs, solution, m,
+			mode & ~BREEZE2D_POISSON_SOLVER_MASK,
+			(char*)workspace + SOLVER_SIZE, size - SOLVER_SIZE);
+		if (!solver->desc) return NULL;
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+		return NULL;
+	}
+	
+	return (breeze2d_poisson_solver)solver;
+}
+
+// Initialize 2D Poisson equation solver for the specified
+// problem size and data arrays with padded rows.
+breeze2d_poisson_solver breeze2d_poisson_solver_init_padded(int mode,
+	unsigned int m, unsigned int n, real hx, real hy,
+	real* bx, real* ex, real* by, real* ey,
+	real* rhs, real* solution, unsigned int ld, unsigned int offset)
+{
+	if (ld < m)
+	{
+		breeze2d_set_error(BREEZE2D_INCOMPATIBLE_ARRAYS);
+		return NULL;
+	}
+
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)malloc(
+			sizeof(struct breeze2d_poisson_solver_t));
+	solver->mode = mode;
+	solver->allocated = 1;
+	solver->rhs = rhs; solver->solution = solution;
+	solver->m = m; solver->n = n; solver->offset = offset;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		solver->desc = poisson2d_fft_solver_init(
+			m, n, hx, hy, bx, ex, by, ey,
+			rhs + offset, solution + offset, ld,
+			mode & ~BREEZE2D_POISSON_SOLVER_MASK);
+		if (!solver->desc)
+		{
+			free(solver);
+			return NULL;
+		}
+		break;
+	default :
+		free(solver);
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+		return NULL;
+	}
+	
 	return (breeze2d_poisson_solver)solver;
 }
 
@@ -65,16 +185,20 @@ void breeze2d_poisson_solver_dispose(breeze2d_poisson_solver desc)
 	struct breeze2d_poisson_solver_t* solver =
 		(struct breeze2d_poisson_solver_t*)desc;
 
-	switch (solver->mode)
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
 	{
 	case BREEZE2D_POISSON_SOLVER_FFT :
 		poisson2d_fft_solver_dispose((poisson2d_fft_solver)solver->desc);
 		break;
+	case BREEZE2D_POISSON_SOLVER_CAPACITANCE :
+		poisson2d_capacitance_solver_dispose(
+			(poisson2d_capacitance_solver)solver->desc);
+		break;
 	default :
 		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
 	}
 
-	free(solver);
+	if (solver->allocated) free(solver);
 }
 
 // Solve 2D Poisson equation with the given right hand side.
@@ -85,12 +209,295 @@ void breeze2d_poisson_solve(breeze2d_poisson_solver desc)
 	struct breeze2d_poisson_solver_t* solver =
 		(struct breeze2d_poisson_solver_t*)desc;
 
-	switch (solver->mode)
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
 	{
 	case BREEZE2D_POISSON_SOLVER_FFT :
 		poisson2d_fft_solve((poisson2d_fft_solver)solver->desc);
 		break;
+	case BREEZE2D_POISSON_SOLVER_CAPACITANCE :
+		poisson2d_capacitance_solve(
+			(poisson2d_capacitance_solver)solver->desc);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Get the data arrays of the specified solver.
+void breeze2d_poisson_solver_get_arrays(breeze2d_poisson_solver desc,
+	real** rhs, real** solution)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	*rhs = solver->rhs;
+	*solution = solver->solution;
+}
+
+// Replace the right hand side and solution arrays.
+void breeze2d_poisson_solver_set_arrays(breeze2d_poisson_solver desc,
+	real* rhs, real* solution)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_solver_set_arrays((poisson2d_fft_solver)solver->desc,
+			rhs + solver->offset, solution + solver->offset);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+		return;
+	}
+
+	solver->rhs = rhs;
+	solver->solution = solution;
+}
+
+// Get the problem size of the specified solver.
+void breeze2d_poisson_solver_get_size(breeze2d_poisson_solver desc,
+	unsigned int* m, unsigned int* n)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	*m = solver->m;
+	*n = solver->n;
+}
+
+// Get the solver method and option flags.
+int breeze2d_poisson_solver_get_mode(breeze2d_poisson_solver desc)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	return solver->mode;
+}
+
+// Get statistics of solve stages.
+void breeze2d_poisson_solver_get_stats(breeze2d_poisson_solver desc,
+	breeze2d_poisson_stats* stats)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_solver_get_stats((poisson2d_fft_solver)solver->desc,
+			stats);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Reset statistics of solve stages.
+void breeze2d_poisson_solver_reset_stats(breeze2d_poisson_solver desc)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_solver_reset_stats((poisson2d_fft_solver)solver->desc);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Set the obstacles mask.
+void breeze2d_poisson_solver_set_mask(breeze2d_poisson_solver desc,
+	const int* mask)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_CAPACITANCE :
+		poisson2d_capacitance_solver_set_mask(
+			(poisson2d_capacitance_solver)solver->desc, mask);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Set the variable steps of Y grid.
+void breeze2d_poisson_solver_set_grid_y(breeze2d_poisson_solver desc,
+	const real* hy)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_solver_set_grid_y(
+			(poisson2d_fft_solver)solver->desc, hy);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Set arrays to output the solution gradient.
+void breeze2d_poisson_solver_set_gradient(breeze2d_poisson_solver desc,
+	real* dphidx, real* dphidy)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_solver_set_gradient(
+			(poisson2d_fft_solver)solver->desc, dphidx, dphidy);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Solve 2D Poisson equation with the same right hand side
+// as in the previous solve, and updated boundary conditions.
+void breeze2d_poisson_solve_bc(breeze2d_poisson_solver desc)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_solve_bc((poisson2d_fft_solver)solver->desc);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Solve 2D Poisson equation with the right hand side
+// being zero except the specified point sources.
+void breeze2d_poisson_solve_sparse(breeze2d_poisson_solver desc,
+	int nsources, const int* is, const int* js, const real* q)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_solve_sparse((poisson2d_fft_solver)solver->desc,
+			nsources, is, js, q);
+		break;
 	default :
 		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
 	}
 }
+
+// Project the staggered velocity field onto
+// divergence-free fields.
+void breeze2d_project(breeze2d_poisson_solver desc, real* u, real* v)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_project((poisson2d_fft_solver)solver->desc, u, v);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Transform the specified field into spectral space.
+void breeze2d_poisson_forward(breeze2d_poisson_solver desc,
+	real* field, real* spectral)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_forward((poisson2d_fft_solver)solver->desc,
+			field, spectral);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Solve 2D Poisson equation with the given right hand side
+// in spectral space.
+void breeze2d_poisson_solve_spectral(breeze2d_poisson_solver desc,
+	real* spectral_rhs, real* spectral_solution)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_solve_spectral((poisson2d_fft_solver)solver->desc,
+			spectral_rhs, spectral_solution);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Transform the specified spectral space field
+// back into physical space.
+void breeze2d_poisson_inverse(breeze2d_poisson_solver desc,
+	real* spectral, real* field)
+{
+	struct breeze2d_poisson_solver_t* solver =
+		(struct breeze2d_poisson_solver_t*)desc;
+
+	switch (solver->mode & BREEZE2D_POISSON_SOLVER_MASK)
+	{
+	case BREEZE2D_POISSON_SOLVER_FFT :
+		poisson2d_fft_inverse((poisson2d_fft_solver)solver->desc,
+			spectral, field);
+		break;
+	default :
+		breeze2d_set_error(BREEZE2D_UNDEFINED_POISSION_SOLVER_METHOD);
+	}
+}
+
+// Allocate m x n data array (right hand side or solution)
+// aligned and placed for the solver according to the
+// specified BREEZE2D_MALLOC_* flags.
+real* breeze2d_poisson_malloc(unsigned int m, unsigned int n, int flags)
+{
+	return (real*)fft_malloc_placed(sizeof(real) * m * n,
+		sizeof(real) * m, flags);
+}
+
+// Get the placement flags in effect for the data array.
+int breeze2d_poisson_malloc_flags(real* array)
+{
+	return fft_malloc_flags(array);
+}
+
+// Report the placement of m x n data array memory pages
+// on NUMA nodes.
+int breeze2d_poisson_placement(real* array,
+	unsigned int m, unsigned int n, long* npages, int maxnodes)
+{
+	return fft_placement(array, sizeof(real) * m * n, npages, maxnodes);
+}
+
+// Release data array allocated with breeze2d_poisson_malloc.
+void breeze2d_poisson_free(real* array)
+{
+	fft_free_placed(array);
+}
@@ -0,0 +1,368 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <breeze2d.h>
+
+#include "parallel.h"
+
+#include <omp.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#define DEFAULT_SPLIT 65536
+
+// Defines solve job.
+struct job_t
+{
+	breeze2d_poisson_solver solver;
+	real *rhs, *solution;
+	void (*callback)(breeze2d_poisson_solver desc, void* arg);
+	void* arg;
+};
+
+// Defines worker deque of jobs: ring buffer of count jobs
+// starting at head. The owner pops from the tail, thieves
+// steal from the head.
+struct deque_t
+{
+	pthread_mutex_t mutex;
+	struct job_t* jobs;
+	int head, count, capacity;
+};
+
+// Defines solve queue. Counters are guarded by mutex,
+// changed is signaled on submission, on completion, on
+// switching between small and large jobs, and on start
+// and completion of large job parallel loop.
+struct breeze2d_solve_queue_t
+{
+	int nworkers, nstarted;
+	long split;
+
+	pthread_t* threads;
+	struct deque_t* deques;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t changed;
+
+	// The number of jobs in deques, not taken by workers yet,
+	// and the number of jobs submitted but not completed.
+	long nqueued, npending;
+
+	// The number of small jobs running, the number of large
+	// jobs waiting for them to complete, and the flag of
+	// large job running.
+	int nrunning, nwaiting, exclusive;
+
+	// Parallel loop of the running large job: its tasks are
+	// taken by index by the job worker and by parked workers,
+	// and the number of tasks not completed yet.
+	void (*task)(void* arg, int index);
+	void* task_arg;
+	int ntasks, nexttask, nremaining;
+
+	int shutdown;
+	unsigned int next;
+};
+
+// Argument of worker thread.
+struct worker_t
+{
+	struct breeze2d_solve_queue_t* queue;
+	int index;
+};
+
+// Push job to the tail of deque.
+static void push(struct deque_t* deque, struct job_t* job)
+{
+	pthread_mutex_lock(&deque->mutex);
+	if (deque->count == deque->capacity)
+	{
+		int capacity = deque->capacity ? 2 * deque->capacity : 64;
+		struct job_t* jobs = (struct job_t*)malloc(sizeof(struct job_t) * capacity);
+		for (int i = 0; i < deque->count; i++)
+			jobs[i] = deque->jobs[(deque->head + i) % deque->capacity];
+		free(deque->jobs);
+		deque->jobs = jobs;
+		deque->head = 0;
+		deque->capacity = capacity;
+	}
+	deque->jobs[(deque->head + deque->count) % deque->capacity] = *job;
+	deque->count++;
+	pthread_mutex_unlock(&deque->mutex);
+}
+
+// Pop job from the tail (owner) or from the head (thief)
+// of deque, if not empty.
+static int pop(struct deque_t* deque, struct job_t* job, int steal)
+{
+	int found = 0;
+	pthread_mutex_lock(&deque->mutex);
+	if (deque->count)
+	{
+		if (steal)
+		{
+			*job = deque->jobs[deque->head];
+			deque->head = (deque->head + 1) % deque->capacity;
+		}
+		else
+			*job = deque->jobs[(deque->head + deque->count - 1) % deque->capacity];
+		deque->count--;
+		found = 1;
+	}
+	pthread_mutex_unlock(&deque->mutex);
+	return found;
+}
+
+// Run one of the tasks left of the large job parallel loop,
+// if any. Called with mutex held, released while running.
+// Returns 1, if the task was run.
+static int help(struct breeze2d_solve_queue_t* queue)
+{
+	if (!queue->task || (queue->nexttask == queue->ntasks))
+		return 0;
+
+	int index = queue->nexttask++;
+	void (*task)(void* arg, int index) = queue->task;
+	void* arg = queue->task_arg;
+	pthread_mutex_unlock(&queue->mutex);
+	task(arg, index);
+	pthread_mutex_lock(&queue->mutex);
+	if (!--queue->nremaining)
+		pthread_cond_broadcast(&queue->changed);
+	return 1;
+}
+
+// Run the large job parallel loop (executor of the job worker):
+// other workers are parked meanwhile, so they take tasks as well.
+static void run(void* context, int ntasks,
+	void (*task)(void* arg, int index), void* arg)
+{
+	struct breeze2d_solve_queue_t* queue =
+		(struct breeze2d_solve_queue_t*)context;
+
+	pthread_mutex_lock(&queue->mutex);
+	queue->task = task;
+	queue->task_arg = arg;
+	queue->ntasks = ntasks;
+	queue->nexttask = 0;
+	queue->nremaining = ntasks;
+	pthread_cond_broadcast(&queue->changed);
+	while (help(queue))
+		continue;
+	while (queue->nremaining)
+		pthread_cond_wait(&queue->changed, &queue->mutex);
+	queue->task = NULL;
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+// Perform jobs of the own deque, or stolen from others,
+// until shutdown. While waiting, take tasks of large job.
+static void* worker(void* arg)
+{
+	struct breeze2d_solve_queue_t* queue = ((struct worker_t*)arg)->queue;
+	int index = ((struct worker_t*)arg)->index;
+	free(arg);
+
+	for ( ; ; )
+	{
+		// Reserve one of queued jobs: it is in some deque
+		// until taken, as reservations never outnumber jobs.
+		pthread_mutex_lock(&queue->mutex);
+		while (!queue->nqueued && !queue->shutdown)
+			if (!help(queue))
+				pthread_cond_wait(&queue->changed, &queue->mutex);
+		if (!queue->nqueued)
+		{
+			pthread_mutex_unlock(&queue->mutex);
+			break;
+		}
+		queue->nqueued--;
+		pthread_mutex_unlock(&queue->mutex);
+
+		struct job_t job;
+		for (int victim = index; ; victim = (victim + 1) % queue->nworkers)
+			if (pop(&queue->deques[victim], &job, victim != index))
+				break;
+
+		if (job.rhs)
+			breeze2d_poisson_solver_set_arrays(job.solver, job.rhs, job.solution);
+
+		unsigned int m, n;
+		breeze2d_poisson_solver_get_size(job.solver, &m, &n);
+		int large = (long)m * n >= queue->split;
+
+		// Large job waits for running small jobs to complete,
+		// small jobs wait while large job is waiting or running.
+		pthread_mutex_lock(&queue->mutex);
+		if (large)
+		{
+			queue->nwaiting++;
+			while (queue->nrunning || queue->exclusive)
+				if (!help(queue))
+					pthread_cond_wait(&queue->changed, &queue->mutex);
+			queue->nwaiting--;
+			queue->exclusive = 1;
+		}
+		else
+		{
+			while (queue->nwaiting || queue->exclusive)
+				if (!help(queue))
+					pthread_cond_wait(&queue->changed, &queue->mutex);
+			queue->nrunning++;
+		}
+		pthread_mutex_unlock(&queue->mutex);
+
+		// Small job runs in the worker thread, large job loops
+		// run on all workers, instead of nested OpenMP teams.
+		breeze2d_executor executor = { run, queue, large ? queue->nworkers : 1 };
+		poisson2d_parallel_set_thread_executor(&executor);
+		breeze2d_poisson_solve(job.solver);
+		poisson2d_parallel_set_thread_executor(NULL);
+		if (job.callback)
+			job.callback(job.solver, job.arg);
+
+		pthread_mutex_lock(&queue->mutex);
+		if (large) queue->exclusive = 0;
+		else queue->nrunning--;
+		queue->npending--;
+		pthread_cond_broadcast(&queue->changed);
+		pthread_mutex_unlock(&queue->mutex);
+	}
+
+	return NULL;
+}
+
+// Stop the started workers and release the solve queue.
+static void release(struct breeze2d_solve_queue_t* queue)
+{
+	pthread_mutex_lock(&queue->mutex);
+	queue->shutdown = 1;
+	pthread_cond_broadcast(&queue->changed);
+	pthread_mutex_unlock(&queue->mutex);
+
+	for (int i = 0; i < queue->nstarted; i++)
+		pthread_join(queue->threads[i], NULL);
+	for (int i = 0; i < queue->nworkers; i++)
+	{
+		pthread_mutex_destroy(&queue->deques[i].mutex);
+		free(queue->deques[i].jobs);
+	}
+
+	pthread_mutex_destroy(&queue->mutex);
+	pthread_cond_destroy(&queue->changed);
+	free(queue->threads);
+	free(queue->deques);
+	free(queue);
+}
+
+// Create the solve queue.
+breeze2d_solve_queue breeze2d_solve_queue_init(int nworkers, long split)
+{
+	if (nworkers <= 0) nworkers = omp_get_num_procs();
+	if (split <= 0) split = DEFAULT_SPLIT;
+
+	struct breeze2d_solve_queue_t* queue =
+		(struct breeze2d_solve_queue_t*)calloc(1,
+			sizeof(struct breeze2d_solve_queue_t));
+	if (!queue)
+	{
+		breeze2d_set_error(BREEZE2D_OUT_OF_MEMORY);
+		return NULL;
+	}
+	queue->nworkers = nworkers;
+	queue->split = split;
+	queue->threads = (pthread_t*)malloc(sizeof(pthread_t) * nworkers);
+	queue->deques = (struct deque_t*)calloc(nworkers, sizeof(struct deque_t));
+	if (!queue->threads || !queue->deques)
+	{
+		free(queue->threads);
+		free(queue->deques);
+		free(queue);
+		breeze2d_set_error(BREEZE2D_OUT_OF_MEMORY);
+		return NULL;
+	}
+	pthread_mutex_init(&queue->mutex, NULL);
+	pthread_cond_init(&queue->changed, NULL);
+
+	for (int i = 0; i < nworkers; i++)
+		pthread_mutex_init(&queue->deques[i].mutex, NULL);
+
+	// Stop at the first worker failed to start,
+	// and release the workers started so far.
+	for ( ; queue->nstarted < nworkers; queue->nstarted++)
+	{
+		struct worker_t* arg = (struct worker_t*)malloc(sizeof(struct worker_t));
+		if (arg)
+		{
+			arg->queue = queue;
+			arg->index = queue->nstarted;
+			if (!pthread_create(&queue->threads[queue->nstarted], NULL, worker, arg))
+				continue;
+			free(arg);
+		}
+		release(queue);
+		breeze2d_set_error(BREEZE2D_THREAD_CREATION_FAILED);
+		return NULL;
+	}
+
+	return (breeze2d_solve_queue)queue;
+}
+
+// Submit the solve job to the queue.
+void breeze2d_solve_queue_submit(breeze2d_solve_queue handle,
+	breeze2d_poisson_solver desc, real* rhs, real* solution,
+	void (*callback)(breeze2d_poisson_solver desc, void* arg), void* arg)
+{
+	struct breeze2d_solve_queue_t* queue =
+		(struct breeze2d_solve_queue_t*)handle;
+
+	struct job_t job = { desc, rhs, solution, callback, arg };
+
+	pthread_mutex_lock(&queue->mutex);
+	int index = queue->next++ % queue->nworkers;
+	push(&queue->deques[index], &job);
+	queue->nqueued++;
+	queue->npending++;
+	pthread_cond_broadcast(&queue->changed);
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+// Wait for all submitted jobs to complete.
+void breeze2d_solve_queue_wait(breeze2d_solve_queue handle)
+{
+	struct breeze2d_solve_queue_t* queue =
+		(struct breeze2d_solve_queue_t*)handle;
+
+	pthread_mutex_lock(&queue->mutex);
+	while (queue->npending)
+		pthread_cond_wait(&queue->changed, &queue->mutex);
+	pthread_mutex_unlock(&queue->mutex);
+}
+
+// Wait for all submitted jobs to complete, stop workers and
+// release the solve queue.
+void breeze2d_solve_queue_dispose(breeze2d_solve_queue handle)
+{
+	struct breeze2d_solve_queue_t* queue =
+		(struct breeze2d_solve_queue_t*)handle;
+
+	breeze2d_solve_queue_wait(handle);
+	release(queue);
+}
@@ -0,0 +1,164 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <breeze2d.h>
+#include <breeze2d_timing.h>
+#include "poisson2d/fft/wrapper.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+#define ABS(x) (((x) >= 0) ? (x) : -(x))
+
+#ifdef HAVE_SINGLE
+#define TOLERANCE 1e-4
+#else
+#define TOLERANCE 1e-11
+#endif
+
+// Transform the row directly, in FFTW r2r conventions.
+static void transform(int n, const real* x, double* y, fft_kind kind)
+{
+	for (int k = 0; k < n; k++)
+	{
+		double sum = 0.0;
+		if (kind == FFT_RODFT00)
+		{
+			for (int j = 0; j < n; j++)
+				sum += 2.0 * x[j] * sin(M_PI * (j + 1) * (k + 1) / (n + 1));
+		}
+		else
+		{
+			sum = x[0] + ((k % 2) ? -x[n - 1] : x[n - 1]);
+			for (int j = 1; j < n - 1; j++)
+				sum += 2.0 * x[j] * cos(M_PI * j * k / (n - 1));
+		}
+		y[k] = sum;
+	}
+}
+
+// Check batched transform of padded rows, out of place
+// and in place, against the direct one, and return the
+// maximum relative error.
+static double check(int n, int howmany, fft_kind kind)
+{
+	int ld = n + 3;
+	real* in = (real*)fft_malloc(sizeof(real) * ld * howmany);
+	real* out = (real*)fft_malloc(sizeof(real) * ld * howmany);
+	double* y = (double*)malloc(sizeof(double) * n);
+
+	fft_plan* plan = fft_create_multi(n, howmany, in, out, ld, ld, kind, FFT_ESTIMATE);
+	fft_plan* inplace = fft_create_multi(n, howmany, in, in, ld, ld, kind, FFT_ESTIMATE);
+
+	for (int i = 0; i < ld * howmany; i++)
+		in[i] = (real)rand() / RAND_MAX - 0.5;
+
+	fft_forward(plan);
+
+	double err = 0.0;
+	for (int row = 0; row < howmany; row++)
+	{
+		transform(n, in + row * ld, y, kind);
+		double norm = 0.0;
+		for (int k = 0; k < n; k++)
+			norm = MAX(norm, ABS(y[k]));
+		for (int k = 0; k < n; k++)
+			err = MAX(err, ABS(out[row * ld + k] - y[k]) / norm);
+	}
+
+	fft_forward(inplace);
+
+	for (int i = 0; i < ld * howmany; i++)
+		if ((i % ld < n) && (in[i] != out[i]))
+			err = MAX(err, 1.0);
+
+	fft_dispose(plan);
+	fft_dispose(inplace);
+	fft_free(in);
+	fft_free(out);
+	free(y);
+
+	return err;
+}
+
+// Return average time of batched transform of
+// n x n array.
+static double benchmark(int n, fft_kind kind)
+{
+	const int count = 20;
+	real* data = (real*)fft_malloc(sizeof(real) * n * n);
+	fft_plan* plan = fft_create_multi(n, n, data, data, n, n, kind, FFT_MEASURE);
+
+	for (int i = 0; i < n * n; i++)
+		data[i] = (real)rand() / RAND_MAX - 0.5;
+
+	// Sine transform is involutory up to the scale:
+	// keep values bounded.
+	real scale = (kind == FFT_RODFT00) ? 0.5 / (n + 1) : 0.5 / (n - 1);
+
+	struct timespec start, finish;
+	breeze2d_get_time(&start);
+	for (int it = 0; it < count; it++)
+	{
+		fft_forward(plan);
+		for (int i = 0; i < n * n; i++)
+			data[i] *= scale;
+	}
+	breeze2d_get_time(&finish);
+
+	fft_dispose(plan);
+	fft_free(data);
+
+	return breeze2d_get_time_diff(start, finish) / count;
+}
+
+int main(int argc, char* argv[])
+{
+	const int sizes[] = { 1, 2, 3, 4, 5, 7, 8, 15, 16, 17, 31, 63, 100, 127, 255, 1000 };
+	const int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+
+	int nthreads = (argc > 1) ? atoi(argv[1]) : 1;
+	fft_init_threads();
+	fft_plan_with_nthreads(nthreads);
+
+	int failed = 0;
+	printf("%6s %14s %14s\n", "n", "sine error", "cosine error");
+	for (int i = 0; i < nsizes; i++)
+	{
+		int n = sizes[i];
+		double errs = check(n, 37, FFT_RODFT00);
+		double errc = (n > 1) ? check(n, 37, FFT_REDFT00) : 0.0;
+		printf("%6d %14e %14e\n", n, errs, errc);
+		if ((errs > TOLERANCE) || (errc > TOLERANCE)) failed = 1;
+	}
+
+	// Time of transform of n x n arrays, for comparison
+	// between backends.
+	const int bsizes[] = { 255, 256, 1023, 1025 };
+	printf("\n%6s %14s %14s\n", "n", "sine time", "cosine time");
+	for (int i = 0; i < sizeof(bsizes) / sizeof(bsizes[0]); i++)
+		printf("%6d %14f %14f\n", bsizes[i],
+			benchmark(bsizes[i], FFT_RODFT00), benchmark(bsizes[i], FFT_REDFT00));
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
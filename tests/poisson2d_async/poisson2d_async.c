@@ -0,0 +1,176 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NSOLVERS 4
+#define NSTEPS 3
+
+// Problem sizes of solvers, the last one solves in place.
+static const int ms[NSOLVERS] = { 31, 127, 255, 100 };
+static const int ns[NSOLVERS] = { 47, 63, 255, 77 };
+
+// Defines solver with its own arrays.
+struct problem_t
+{
+	int m, n, inplace;
+	real *rhs, *solution, *bx, *ex, *by, *ey;
+	breeze2d_poisson_solver solver;
+};
+
+static void init(struct problem_t* p, int m, int n, int inplace)
+{
+	p->m = m; p->n = n; p->inplace = inplace;
+	p->rhs = breeze2d_poisson_malloc(m, n, 0);
+	p->solution = inplace ? p->rhs : breeze2d_poisson_malloc(m, n, 0);
+	p->bx = (real*)calloc(n, sizeof(real));
+	p->ex = (real*)calloc(n, sizeof(real));
+	p->by = (real*)malloc(m * sizeof(real));
+	p->ey = (real*)malloc(m * sizeof(real));
+	p->solver = breeze2d_poisson_solver_init(BREEZE2D_POISSON_SOLVER_FFT,
+		m, n, 1.0 / (m + 1), 1.0 / (n + 1),
+		p->bx, p->ex, p->by, p->ey, p->rhs, p->solution);
+}
+
+// Fill the right hand side and boundary conditions of the step.
+static void fill(struct problem_t* p, int step)
+{
+	for (int i = 0; i < p->m * p->n; i++)
+		p->rhs[i] = sin(0.01 * i + step) + cos(0.003 * i * (step + 1));
+	for (int i = 0; i < p->m; i++)
+	{
+		p->by[i] = sin(0.1 * i + step);
+		p->ey[i] = cos(0.1 * i - step);
+	}
+}
+
+static void dispose(struct problem_t* p)
+{
+	breeze2d_poisson_solver_dispose(p->solver);
+	breeze2d_poisson_free(p->rhs);
+	if (!p->inplace) breeze2d_poisson_free(p->solution);
+	free(p->bx); free(p->ex); free(p->by); free(p->ey);
+}
+
+int main(int argc, char* argv[])
+{
+	printf("Asynchronous solves of %d solvers in flight\n\n", NSOLVERS);
+
+	struct problem_t problems[NSOLVERS];
+	for (int k = 0; k < NSOLVERS; k++)
+		init(&problems[k], ms[k], ns[k], k == NSOLVERS - 1);
+
+	breeze2d_poisson_async_set_nthreads(3);
+
+	// Solve all steps synchronously for reference. The in-place
+	// solver solves twice per step, as its second solve takes
+	// the first one solution as the right hand side.
+	real* reference[NSOLVERS][NSTEPS];
+	for (int step = 0; step < NSTEPS; step++)
+		for (int k = 0; k < NSOLVERS; k++)
+		{
+			struct problem_t* p = &problems[k];
+			fill(p, step);
+			breeze2d_poisson_solve(p->solver);
+			if (p->inplace)
+				breeze2d_poisson_solve(p->solver);
+			reference[k][step] = (real*)malloc(sizeof(real) * p->m * p->n);
+			memcpy(reference[k][step], p->solution, sizeof(real) * p->m * p->n);
+		}
+
+	// Same solves asynchronously, overlapped with computation,
+	// queueing both solves of the in-place solver at once.
+	int failed = 0;
+	for (int step = 0; step < NSTEPS; step++)
+	{
+		breeze2d_poisson_request requests[NSOLVERS + 1];
+		for (int k = 0; k < NSOLVERS; k++)
+		{
+			fill(&problems[k], step);
+			requests[k] = breeze2d_poisson_solve_async(problems[k].solver);
+		}
+		requests[NSOLVERS] = breeze2d_poisson_solve_async(
+			problems[NSOLVERS - 1].solver);
+
+		double sum = 0.0;
+		long iterations = 0;
+		int ndone = 0, done[NSOLVERS + 1] = { 0 };
+		while (ndone < NSOLVERS + 1)
+		{
+			for (int i = 0; i < 1000; i++)
+				sum += sin(0.001 * (iterations * 1000 + i));
+			iterations++;
+			for (int k = 0; k < NSOLVERS + 1; k++)
+				if (!done[k] && breeze2d_poisson_test(requests[k]))
+				{
+					done[k] = 1;
+					ndone++;
+				}
+		}
+
+		// Release completed requests.
+		for (int k = 0; k < NSOLVERS + 1; k++)
+			breeze2d_poisson_wait(requests[k]);
+
+		for (int k = 0; k < NSOLVERS; k++)
+		{
+			struct problem_t* p = &problems[k];
+			if (memcmp(reference[k][step], p->solution, sizeof(real) * p->m * p->n))
+			{
+				printf("Solver %d step %d differs from synchronous solve\n", k, step);
+				failed = 1;
+			}
+		}
+		printf("step %d: %ld overlapped iterations\n", step, iterations);
+	}
+
+	// Waiting is the same as testing until completion, also
+	// with the pool started again after finalization.
+	breeze2d_poisson_async_finalize();
+	for (int k = 0; k < NSOLVERS; k++)
+	{
+		fill(&problems[k], 0);
+		breeze2d_poisson_wait(breeze2d_poisson_solve_async(problems[k].solver));
+		if (!problems[k].inplace &&
+			memcmp(reference[k][0], problems[k].solution,
+				sizeof(real) * problems[k].m * problems[k].n))
+		{
+			printf("Solver %d wait differs from synchronous solve\n", k);
+			failed = 1;
+		}
+	}
+
+	breeze2d_poisson_async_finalize();
+
+	for (int k = 0; k < NSOLVERS; k++)
+	{
+		dispose(&problems[k]);
+		for (int step = 0; step < NSTEPS; step++)
+			free(reference[k][step]);
+	}
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
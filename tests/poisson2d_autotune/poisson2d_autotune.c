@@ -0,0 +1,167 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+#define ABS(x) (((x) > 0) ? (x) : -(x))
+
+// Tuned solves may use other numbers of threads and
+// planners, so solves are compared up to roundoff.
+#define TOLERANCE ((sizeof(real) == sizeof(float)) ? 1e-5 : 1e-13)
+
+// Private tuning database of the test.
+#define TUNING_FILENAME "poisson2d_autotune.tuning"
+
+// Set the right hand side on [0, pi] x [0, 2 pi] grid.
+static void init_f(int m, int n, real hx, real hy, real* f)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y) + sin(3.0 * x + y);
+		}
+}
+
+// Set boundary conditions: by Y given, by X zero.
+static void init_g(int m, int n, real hx,
+	real* gbx, real* gex, real* gby, real* gey)
+{
+	for (int j = 0; j < n; j++)
+		gbx[j] = gex[j] = 0.0;
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(2.0 * x);
+	}
+}
+
+// Count the tuning database records of m x n problem
+// of serial or parallel solver.
+static int count_records(int m, int n, const char* threading)
+{
+	int count = 0;
+	FILE* file = fopen(TUNING_FILENAME, "r");
+	if (!file) return 0;
+	char line[256];
+	while (fgets(line, sizeof(line), file))
+	{
+		char backend[32], precision[32], lthreading[32], planner[32];
+		int cores, lm, ln, nthreads;
+		if (sscanf(line, "%31s %31s %31s %d %d %d %d %31s", backend,
+			precision, lthreading, &cores, &lm, &ln, &nthreads, planner) != 8)
+			continue;
+		if (!strcmp(lthreading, threading) && (lm == m) && (ln == n) &&
+			(cores > 0) && (nthreads > 0))
+			count++;
+	}
+	fclose(file);
+	return count;
+}
+
+// Create solver with autotuning twice: the first init
+// must tune and save one record, the second one must find
+// it. Check the tuned solves against the reference.
+static int check(const char* threading, int flags,
+	int m, int n, real hx, real hy,
+	real* gbx, real* gex, real* gby, real* gey,
+	real* f, real* phi, const real* ref)
+{
+	int failed = 0;
+	for (int k = 0; k < 2; k++)
+	{
+		breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+			BREEZE2D_POISSON_SOLVER_FFT | BREEZE2D_POISSON_AUTOTUNE | flags,
+			m, n, hx, hy, gbx, gex, gby, gey, f, phi);
+		init_f(m, n, hx, hy, f);
+		breeze2d_poisson_solve(solver);
+		breeze2d_poisson_solver_dispose(solver);
+
+		real maxdiff = 0.0, maxref = 0.0;
+		for (int i = 0; i < m * n; i++)
+		{
+			maxdiff = MAX(maxdiff, ABS(phi[i] - ref[i]));
+			maxref = MAX(maxref, ABS(ref[i]));
+		}
+		maxdiff /= maxref;
+
+		int nrecords = count_records(m, n, threading);
+		int passed = (nrecords == 1) && (maxdiff < TOLERANCE);
+		printf("%s init %d: %d record(s), max relative difference = %e %s\n",
+			threading, k, nrecords, maxdiff, passed ? "PASSED" : "FAILED");
+		if (!passed) failed++;
+	}
+	return failed;
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 61, n = 47;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* phi = breeze2d_poisson_malloc(m, n, 0);
+	real* ref = breeze2d_poisson_malloc(m, n, 0);
+	real* gbx = (real*)malloc(n * sizeof(real));
+	real* gex = (real*)malloc(n * sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+	init_g(m, n, hx, gbx, gex, gby, gey);
+
+	// Reference: solve with default configuration.
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		gbx, gex, gby, gey, f, ref);
+	init_f(m, n, hx, hy, f);
+	breeze2d_poisson_solve(solver);
+	breeze2d_poisson_solver_dispose(solver);
+
+	// Start with empty private database.
+	setenv("BREEZE2D_TUNING_FILE", TUNING_FILENAME, 1);
+	remove(TUNING_FILENAME);
+
+	// Parallel and serial solvers are tuned under their own keys.
+	int failed = 0;
+	failed += check("parallel", 0, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi, ref);
+	failed += check("serial", BREEZE2D_POISSON_SERIAL, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi, ref);
+
+	remove(TUNING_FILENAME);
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(phi);
+	breeze2d_poisson_free(ref);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
@@ -0,0 +1,126 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+#define ABS(x) (((x) > 0) ? (x) : -(x))
+
+// Domain is [0, 1] x [0, ly], with hy / hx = ly.
+#define ly 1.25
+
+// Known exact solution, vanishing on X boundaries,
+// with non-zero right hand side there.
+static double phi(double x, double y)
+{
+	return x * (1.0 - x) * exp(y) + sin(M_PI * x) * cos(2.0 * y);
+}
+
+static double laplace_phi(double x, double y)
+{
+	return (x * (1.0 - x) - 2.0) * exp(y) -
+		(M_PI * M_PI + 4.0) * sin(M_PI * x) * cos(2.0 * y);
+}
+
+// Solve on (m + 2) x (m + 2) grid with the given option flags,
+// and return the maximum absolute error.
+static double solve(int m, int flags)
+{
+	int n = m;
+	real hx = 1.0 / (m + 1), hy = ly / (n + 1);
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* u = breeze2d_poisson_malloc(m, n, 0);
+	real* gbx = (real*)malloc(n * sizeof(real));
+	real* gex = (real*)malloc(n * sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT | flags,
+		m, n, hx, hy, gbx, gex, gby, gey, f, u);
+
+	for (int j = 0; j < n; j++)
+	{
+		gbx[j] = 0.0; gex[j] = 0.0;
+		for (int i = 0; i < m; i++)
+			f[j * m + i] = laplace_phi(hx * (i + 1), hy * (j + 1));
+	}
+	for (int i = 0; i < m; i++)
+	{
+		gby[i] = phi(hx * (i + 1), 0.0);
+		gey[i] = phi(hx * (i + 1), ly);
+	}
+
+	breeze2d_poisson_solve(solver);
+
+	double err = 0.0;
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+			err = MAX(err, ABS(u[j * m + i] -
+				phi(hx * (i + 1), hy * (j + 1))));
+
+	breeze2d_poisson_solver_dispose(solver);
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(u);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	return err;
+}
+
+int main(int argc, char* argv[])
+{
+	printf("Convergence order of 2D Poisson equation\n");
+	printf("FFT solver: 5-point stencil and fourth\n");
+	printf("order compact (Mehrstellen) scheme\n\n");
+
+	// Single precision roundoff hides the compact
+	// scheme error on finer grids.
+	int nlevels = (sizeof(real) == sizeof(float)) ? 2 : 5;
+
+	double err2[8], err4[8];
+	int status = 0;
+	printf("%6s %12s %6s %12s %6s\n", "m", "5-point", "order", "compact", "order");
+	for (int l = 0; l < nlevels; l++)
+	{
+		int m = (8 << l) - 1;
+		err2[l] = solve(m, 0);
+		err4[l] = solve(m, BREEZE2D_POISSON_COMPACT4);
+		if (!l)
+		{
+			printf("%6d %12e %6s %12e %6s\n", m, err2[l], "", err4[l], "");
+			continue;
+		}
+
+		double order2 = log2(err2[l - 1] / err2[l]);
+		double order4 = log2(err4[l - 1] / err4[l]);
+		printf("%6d %12e %6.2f %12e %6.2f\n", m, err2[l], order2, err4[l], order4);
+		if (l == nlevels - 1)
+			status = (order2 < 1.8) || (order4 < 3.6);
+	}
+
+	printf("\n%s\n", status ? "FAILED" : "PASSED");
+
+	return status;
+}
@@ -0,0 +1,143 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NSOLVES 5
+
+static const char* names[BREEZE2D_POISSON_NSTAGES] =
+	{ "forward", "shutter", "inverse", "solve" };
+
+// Set the right hand side on [0, pi] x [0, 2 pi] grid.
+static void init_f(int m, int n, real hx, real hy, real* f)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y) + sin(3.0 * x + y);
+		}
+}
+
+// Solve NSOLVES times, with the specified flags.
+static breeze2d_poisson_solver solve(int flags, int m, int n,
+	real hx, real hy, real* gbx, real* gex, real* gby, real* gey,
+	real* f, real* phi)
+{
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT | flags, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi);
+	for (int k = 0; k < NSOLVES; k++)
+	{
+		init_f(m, n, hx, hy, f);
+		breeze2d_poisson_solve(solver);
+	}
+	return solver;
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 255, n = 255;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* phi = breeze2d_poisson_malloc(m, n, 0);
+	real* ref = breeze2d_poisson_malloc(m, n, 0);
+	real* gbx = (real*)calloc(n, sizeof(real));
+	real* gex = (real*)calloc(n, sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(2.0 * x);
+	}
+
+	// Reference: the same solves without counters.
+	breeze2d_poisson_solver solver = solve(0, m, n, hx, hy,
+		gbx, gex, gby, gey, f, ref);
+	breeze2d_poisson_solver_dispose(solver);
+
+	solver = solve(BREEZE2D_POISSON_COUNTERS, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi);
+
+	int failed = 0;
+	if (memcmp(phi, ref, sizeof(real) * m * n))
+	{
+		printf("Solution differs from the solve without counters\n");
+		failed++;
+	}
+
+	// Each stage is run and timed once per solve, and the
+	// whole solve takes at least the time of its stages.
+	// Hardware events are checked, where counted.
+	breeze2d_poisson_stats stats;
+	breeze2d_poisson_solver_get_stats(solver, &stats);
+	unsigned int available = stats.counters[BREEZE2D_POISSON_STAGE_SOLVE].available;
+	printf("Hardware counters: %s\n", available ? "available" : "not available");
+	double stages = 0.0;
+	for (int stage = 0; stage < BREEZE2D_POISSON_NSTAGES; stage++)
+	{
+		const breeze2d_counters* counters = &stats.counters[stage];
+		int passed = (stats.ncalls[stage] == NSOLVES) && (counters->time > 0.0);
+		if (available & BREEZE2D_COUNTER_CYCLES)
+			passed &= counters->cycles > 0;
+		if (available & BREEZE2D_COUNTER_INSTRUCTIONS)
+			passed &= counters->instructions > 0;
+		printf("%-8s %u calls, %f s, %lld cycles, %lld instructions, ipc = %f %s\n",
+			names[stage], stats.ncalls[stage], counters->time,
+			counters->cycles, counters->instructions,
+			stats.metrics[stage].ipc, passed ? "PASSED" : "FAILED");
+		if (!passed) failed++;
+		if (stage != BREEZE2D_POISSON_STAGE_SOLVE)
+			stages += counters->time;
+	}
+	if (stages > stats.counters[BREEZE2D_POISSON_STAGE_SOLVE].time)
+	{
+		printf("Stages take longer than solves\n");
+		failed++;
+	}
+
+	// Statistics start over after reset.
+	breeze2d_poisson_solver_reset_stats(solver);
+	breeze2d_poisson_solver_get_stats(solver, &stats);
+	for (int stage = 0; stage < BREEZE2D_POISSON_NSTAGES; stage++)
+		if (stats.ncalls[stage] || (stats.counters[stage].time != 0.0))
+		{
+			printf("Stage %s is not reset\n", names[stage]);
+			failed++;
+		}
+	breeze2d_poisson_solver_dispose(solver);
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(phi);
+	breeze2d_poisson_free(ref);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
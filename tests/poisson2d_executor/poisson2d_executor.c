@@ -0,0 +1,178 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <breeze2d.h>
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NTHREADS 4
+#define NSOLVERS 8
+
+// Defines solver with its own data arrays.
+struct problem_t
+{
+	int m, n;
+	real *rhs, *solution;
+	real *bx, *ex, *by, *ey;
+	breeze2d_poisson_solver solver;
+};
+
+static void init(struct problem_t* p, int m, int n, int flags)
+{
+	p->m = m; p->n = n;
+	p->rhs = breeze2d_poisson_malloc(m, n, 0);
+	p->solution = breeze2d_poisson_malloc(m, n, 0);
+	p->bx = (real*)calloc(n, sizeof(real));
+	p->ex = (real*)calloc(n, sizeof(real));
+	p->by = (real*)malloc(m * sizeof(real));
+	p->ey = (real*)malloc(m * sizeof(real));
+	for (int i = 0; i < m; i++)
+	{
+		p->by[i] = sin(0.1 * i);
+		p->ey[i] = cos(0.1 * i);
+	}
+	p->solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT | flags,
+		m, n, 1.0 / (m + 1), 1.0 / (n + 1),
+		p->bx, p->ex, p->by, p->ey, p->rhs, p->solution);
+}
+
+static void solve(struct problem_t* p)
+{
+	for (int i = 0; i < p->m * p->n; i++)
+		p->rhs[i] = sin(0.01 * i) + cos(0.003 * i);
+	memset(p->solution, 0, sizeof(real) * p->m * p->n);
+	breeze2d_poisson_solve(p->solver);
+}
+
+static void dispose(struct problem_t* p)
+{
+	breeze2d_poisson_solver_dispose(p->solver);
+	breeze2d_poisson_free(p->rhs);
+	breeze2d_poisson_free(p->solution);
+	free(p->bx); free(p->ex); free(p->by); free(p->ey);
+}
+
+// Defines the test executor: a thread per task, counting
+// the tasks it has run.
+struct pool_t
+{
+	pthread_mutex_t mutex;
+	long ntasks;
+};
+
+struct task_t
+{
+	void (*task)(void* arg, int index);
+	void* arg;
+	int index;
+};
+
+static void* task_thread(void* arg)
+{
+	struct task_t* t = (struct task_t*)arg;
+	t->task(t->arg, t->index);
+	return NULL;
+}
+
+static void run(void* context, int ntasks,
+	void (*task)(void* arg, int index), void* arg)
+{
+	struct pool_t* pool = (struct pool_t*)context;
+	pthread_mutex_lock(&pool->mutex);
+	pool->ntasks += ntasks;
+	pthread_mutex_unlock(&pool->mutex);
+
+	pthread_t threads[NTHREADS];
+	struct task_t tasks[NTHREADS];
+	for (int i = 1; i < ntasks; i++)
+	{
+		tasks[i] = (struct task_t){ task, arg, i };
+		pthread_create(&threads[i], NULL, task_thread, &tasks[i]);
+	}
+	task(arg, 0);
+	for (int i = 1; i < ntasks; i++)
+		pthread_join(threads[i], NULL);
+}
+
+static int compare(const char* name, struct problem_t* p, const real* reference)
+{
+	if (!memcmp(reference, p->solution, sizeof(real) * p->m * p->n))
+		return 0;
+	printf("%s solve differs from default solve\n", name);
+	return 1;
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 300, n = 200;
+	printf("Solves on external executor and in caller threads\n\n");
+
+	// Default solve for reference.
+	struct problem_t p;
+	init(&p, m, n, 0);
+	solve(&p);
+	real* reference = (real*)malloc(sizeof(real) * m * n);
+	memcpy(reference, p.solution, sizeof(real) * m * n);
+	dispose(&p);
+
+	int failed = 0;
+
+	// Solve on the executor threads, including init.
+	struct pool_t pool;
+	pthread_mutex_init(&pool.mutex, NULL);
+	pool.ntasks = 0;
+	breeze2d_executor executor = { run, &pool, NTHREADS };
+	breeze2d_set_executor(&executor);
+	init(&p, m, n, 0);
+	solve(&p);
+	failed |= compare("Executor", &p, reference);
+	dispose(&p);
+	breeze2d_set_executor(NULL);
+	printf("executor tasks: %ld\n", pool.ntasks);
+	if (!pool.ntasks)
+	{
+		printf("No tasks were run on executor\n");
+		failed = 1;
+	}
+	pthread_mutex_destroy(&pool.mutex);
+
+	// Independent serial solves from caller threads.
+	struct problem_t problems[NSOLVERS];
+	for (int k = 0; k < NSOLVERS; k++)
+		init(&problems[k], m, n, BREEZE2D_POISSON_SERIAL);
+	#pragma omp parallel for num_threads(NTHREADS)
+	for (int k = 0; k < NSOLVERS; k++)
+		solve(&problems[k]);
+	for (int k = 0; k < NSOLVERS; k++)
+	{
+		failed |= compare("Serial", &problems[k], reference);
+		dispose(&problems[k]);
+	}
+
+	free(reference);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
@@ -60,8 +60,8 @@ void init_f(int m, int n, real hx, real hy, real* f)
 void init_g(int m, int n, real hx, real hy,
 	real* gbx, real* gex, real* gby, real* gey)
 {
-	real xN = x0 + hx * m;
-	real yN = y0 + hy * n;
+	real xN = x0 + hx * (m + 1);
+	real yN = y0 + hy * (n + 1);
 
 	for (int j = 0; j < n; j++)
 	{
@@ -81,6 +81,8 @@ void init_g(int m, int n, real hx, real hy,
 #define MIN(a,b) (((a) < (b)) ? (a) : (b))
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
+#define MAX_NODES 64
+
 void minmaxsum_diff(int n, real* A0, real* A1,
 	real* min, real* max, real* sum)
 {
@@ -99,6 +101,37 @@ void minmaxsum_diff(int n, real* A0, real* A1,
 	}
 }
 
+// Print time and hardware counter metrics of solve stages.
+static void print_stats(breeze2d_poisson_solver solver)
+{
+	static const char* names[BREEZE2D_POISSON_NSTAGES] =
+		{ "forward", "shutter", "inverse", "solve" };
+
+	breeze2d_poisson_stats stats;
+	breeze2d_poisson_solver_get_stats(solver, &stats);
+	unsigned int available =
+		stats.counters[BREEZE2D_POISSON_STAGE_SOLVE].available;
+	if (!available)
+		printf("Hardware counters unavailable, timing only\n");
+	else
+		printf("Memory bandwidth (STREAM triad) = %.2f GB/s\n",
+			breeze2d_stream_bandwidth() / 1e9);
+	for (int stage = 0; stage < BREEZE2D_POISSON_NSTAGES; stage++)
+	{
+		if (!stats.ncalls[stage]) continue;
+		breeze2d_counters* counters = &stats.counters[stage];
+		breeze2d_counter_metrics* metrics = &stats.metrics[stage];
+		printf("  %-8s time = %f", names[stage], counters->time);
+		if (available & BREEZE2D_COUNTER_CYCLES)
+			printf(", IPC = %.2f", metrics->ipc);
+		if (available & BREEZE2D_COUNTER_LLC_LOAD_MISSES)
+			printf(", bytes/point = %.1f, %.2f GB/s (%.0f%% of STREAM)",
+				metrics->bytes_per_point, metrics->bandwidth / 1e9,
+				100.0 * metrics->stream_fraction);
+		printf("\n");
+	}
+}
+
 int main(int argc, char* argv[])
 {
 	printf("Solve 2D Poisson equation\n");
@@ -109,14 +142,35 @@ int main(int argc, char* argv[])
 
 #define USAGE() \
 	{ \
-		printf("Usage: %s <m> <n>, where\n", argv[0]); \
+		printf("Usage: %s <m> <n> [inplace] [progressive] [autotune] [pipeline] [counters], where\n", argv[0]); \
 		printf("m, n - problem dimensions\n"); \
+		printf("inplace - solve in single buffer mode\n"); \
+		printf("progressive - create measured plans in background\n"); \
+		printf("autotune - select threads and planner by timing\n"); \
+		printf("pipeline - run solve stages as tasks\n"); \
+		printf("counters - report hardware counters of solve stages\n"); \
 		printf("Note m and n denote the number of INNER grid points,\n"); \
 		printf("i.e. including boundaries the total number is (m + 2) x (n + 2)\n"); \
 		return 0; \
 	}
 	
-	if (argc != 3) USAGE();
+	if ((argc < 3) || (argc > 8)) USAGE();
+	int inplace = 0, mode = BREEZE2D_POISSON_SOLVER_FFT;
+	for (int i = 3; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "inplace"))
+			inplace = 1;
+		else if (!strcmp(argv[i], "progressive"))
+			mode |= BREEZE2D_POISSON_PROGRESSIVE;
+		else if (!strcmp(argv[i], "autotune"))
+			mode |= BREEZE2D_POISSON_AUTOTUNE;
+		else if (!strcmp(argv[i], "pipeline"))
+			mode |= BREEZE2D_POISSON_PIPELINE;
+		else if (!strcmp(argv[i], "counters"))
+			mode |= BREEZE2D_POISSON_COUNTERS;
+		else
+			USAGE();
+	}
 
 	char* nthreads = getenv("OMP_NUM_THREADS");
 	if (nthreads)
@@ -133,9 +187,12 @@ int main(int argc, char* argv[])
 	struct timespec start, finish;
 	breeze2d_get_time(&start);
 
-	real* phi1 = (real*)malloc(m * n * sizeof(real));
-	real* phi2 = (real*)malloc(m * n * sizeof(real));
-	real* f = (real*)malloc(m * n * sizeof(real));
+	// Place grid arrays pages on NUMA nodes of solver threads.
+	int flags = BREEZE2D_MALLOC_FIRST_TOUCH |
+		BREEZE2D_MALLOC_HUGE_TRANSPARENT;
+	real* f = breeze2d_poisson_malloc(m, n, flags);
+	real* phi1 = inplace ? f : breeze2d_poisson_malloc(m, n, flags);
+	real* phi2 = breeze2d_poisson_malloc(m, n, flags);
 
 	real* gbx = (real*)malloc(n * sizeof(real));
 	real* gex = (real*)malloc(n * sizeof(real));
@@ -143,8 +200,7 @@ int main(int argc, char* argv[])
 	real* gey = (real*)malloc(m * sizeof(real));
 
 	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
-		BREEZE2D_POISSON_SOLVER_FFT,
-		m, n, hx, hy, gbx, gex, gby, gey,
+		mode, m, n, hx, hy, gbx, gex, gby, gey,
 		(real*)f, phi1);
 
 	init_f(m, n, hx, hy, f);
@@ -155,6 +211,16 @@ int main(int argc, char* argv[])
 	printf("Init time = %f\n", breeze2d_get_time_diff(
 		start, finish));
 
+	long npages[MAX_NODES];
+	int nnodes = breeze2d_poisson_placement(f, m, n, npages, MAX_NODES);
+	printf("Placement:%s", (breeze2d_poisson_malloc_flags(f) &
+		BREEZE2D_MALLOC_HUGE_TRANSPARENT) ? " huge pages," : "");
+	if (nnodes < 0)
+		printf(" unknown");
+	for (int i = 0; i < nnodes; i++)
+		printf(" node %d = %ld pages", i, npages[i]);
+	printf("\n");
+
 	breeze2d_get_time(&start);
 
 	breeze2d_poisson_solve(solver);
@@ -164,6 +230,8 @@ int main(int argc, char* argv[])
 	double solver_time =
 		breeze2d_get_time_diff(start, finish);
 	printf("Solver time = %f\n", solver_time);
+	if (mode & BREEZE2D_POISSON_COUNTERS)
+		print_stats(solver);
 	
 	breeze2d_get_time(&start);
 
@@ -205,7 +273,9 @@ int main(int argc, char* argv[])
 
 	breeze2d_poisson_solver_dispose(solver);
 
-	free(phi1); free(phi2); free(f);
+	if (!inplace) breeze2d_poisson_free(phi1);
+	breeze2d_poisson_free(phi2);
+	breeze2d_poisson_free(f);
 	free(gbx); free(gex); free(gby); free(gey);
 
 	breeze2d_get_time(&finish);
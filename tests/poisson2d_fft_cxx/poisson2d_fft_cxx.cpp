@@ -0,0 +1,117 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.hpp>
+
+#include <math.h>
+#include <stdio.h>
+
+// Note N is the number of INNER grid points,
+// i.e. including boundaries the total number is N + 2
+#define N 32
+
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+// Solve the problem with known exact solution sin(x) * cos(y)
+// on [0, 2 pi] x [0, 2 pi], report the residual and check it
+// against the discretization error bound: second order for
+// Dirichlet b.c., first order for Neumann b.c. closure by Y.
+// Returns 1 if the bound is exceeded, 0 otherwise.
+template<typename BCKindY, int M, int Nt>
+int test(const char* name)
+{
+	const int m = N, n = N;
+	real hx = 2.0 * M_PI / (m + 1);
+	real hy = 2.0 * M_PI / (n + 1);
+
+	real phi[N * N], f[N * N];
+	real gby[N], gey[N];
+
+	breeze2d::poisson_solver<real, breeze2d::dirichlet, BCKindY, M, Nt>
+		solver(m, n, hx, hy, gby, gey, f, phi);
+
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y);
+		}
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		if (std::is_same<BCKindY, breeze2d::neumann>::value)
+			gby[i] = gey[i] = 0;
+		else
+		{
+			gby[i] = sin(x);
+			gey[i] = sin(x) * cos(hy * (n + 1));
+		}
+	}
+
+	solver.solve();
+
+	real min = 0, max = 0, sum = 0;
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			real val = phi[j * m + i] - sin(x) * cos(y);
+			min = MIN(min, val);
+			max = MAX(max, val);
+			sum += val;
+		}
+	real bound = std::is_same<BCKindY, breeze2d::neumann>::value ?
+		hy : hy * hy / 4;
+	int failed = (MAX(-min, max) >= bound);
+	printf("%s: residual min = %f, max = %f, sum = %f, bound = %f %s\n",
+		name, min, max, sum, bound, failed ? "FAILED" : "PASSED");
+	return failed;
+}
+
+int main(int argc, char* argv[])
+{
+	printf("Solve 2D Poisson equation\n");
+	printf("with Dirichlet b.c. by X,\n");
+	printf("and Dirichlet or Neumann b.c. by Y:\n");
+	printf("Lx = f in D, phi = g on dD.\n\n");
+	printf("Method: 1d fft + shutter, C++ front-end\n\n");
+
+	// Solvers plan single-threaded transforms, keeping the number
+	// of threads of plans of other solvers.
+	fft_init_threads();
+	fft_plan_with_nthreads(3);
+
+	int failed = 0;
+	failed += test<breeze2d::dirichlet, N, N>("static, Dirichlet by Y");
+	failed += test<breeze2d::dirichlet, breeze2d::dynamic, breeze2d::dynamic>(
+		"dynamic, Dirichlet by Y");
+	failed += test<breeze2d::neumann, N, N>("static, Neumann by Y");
+
+	int nthreads = fft_get_plan_nthreads();
+	printf("planner nthreads after solvers = %d\n", nthreads);
+
+	if (nthreads != 3) failed++;
+
+	return failed;
+}
+
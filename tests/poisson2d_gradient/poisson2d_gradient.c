@@ -0,0 +1,108 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+// Set the right hand side on [0, pi] x [0, 2 pi] grid.
+static void init_f(int m, int n, real hx, real hy, real* f)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y) + sin(3.0 * x + y);
+		}
+}
+
+// Set boundary conditions: by Y given, by X zero.
+static void init_g(int m, int n, real hx,
+	real* gbx, real* gex, real* gby, real* gey)
+{
+	for (int j = 0; j < n; j++)
+		gbx[j] = gex[j] = 0.0;
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(2.0 * x);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 61, n = 47;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* u = breeze2d_poisson_malloc(m, n, 0);
+	real* dphidx = breeze2d_poisson_malloc(m, n, 0);
+	real* dphidy = breeze2d_poisson_malloc(m, n, 0);
+	real* gbx = (real*)malloc(n * sizeof(real));
+	real* gex = (real*)malloc(n * sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT | BREEZE2D_POISSON_GRADIENT,
+		m, n, hx, hy, gbx, gex, gby, gey, f, u);
+	breeze2d_poisson_solver_set_gradient(solver, dphidx, dphidy);
+	init_f(m, n, hx, hy, f);
+	init_g(m, n, hx, gbx, gex, gby, gey);
+	breeze2d_poisson_solve(solver);
+	breeze2d_poisson_solver_dispose(solver);
+
+	// Gradient outputs must be central differences of solution,
+	// with boundary conditions beyond the outermost inner points.
+	double norm = 0.0, diff = 0.0;
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			double w = i ? u[j * m + i - 1] : 0.0;
+			double e = (i < m - 1) ? u[j * m + i + 1] : 0.0;
+			double s = j ? u[(j - 1) * m + i] : gby[i];
+			double nn = (j < n - 1) ? u[(j + 1) * m + i] : gey[i];
+			double dx = (e - w) / (2.0 * hx);
+			double dy = (nn - s) / (2.0 * hy);
+			diff = MAX(diff, fabs(dphidx[j * m + i] - dx));
+			diff = MAX(diff, fabs(dphidy[j * m + i] - dy));
+			norm = MAX(norm, MAX(fabs(dx), fabs(dy)));
+		}
+	diff /= norm;
+	printf("relative difference with central differences = %e\n", diff);
+	int failed = diff > ((sizeof(real) == sizeof(float)) ? 1e-4 : 1e-10);
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(u);
+	breeze2d_poisson_free(dphidx);
+	breeze2d_poisson_free(dphidy);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
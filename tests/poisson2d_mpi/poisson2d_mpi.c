@@ -0,0 +1,238 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+// Set right hand side f(x,y) of rows first .. first + count - 1,
+// for the solution sin(x) cos(y), zero at X boundaries.
+static void init_f(int m, int first, int count, real hx, real hy, real* f)
+{
+	for (int j = 0; j < count; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (first + j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y);
+		}
+}
+
+// Set boundary conditions by Y.
+static void init_g(int m, int n, real hx, real hy, real* gby, real* gey)
+{
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(hy * (n + 1));
+	}
+}
+
+// Time nsolves serial solves of m x n grid.
+static double serial_time(int m, int n, real hx, real hy, int nsolves,
+	real* phi)
+{
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* solution = breeze2d_poisson_malloc(m, n, 0);
+	real* gbx = (real*)calloc(n, sizeof(real));
+	real* gex = (real*)calloc(n, sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		gbx, gex, gby, gey, f, solution);
+
+	double time = 0.0;
+	for (int k = 0; k < nsolves; k++)
+	{
+		init_f(m, 0, n, hx, hy, f);
+		init_g(m, n, hx, hy, gby, gey);
+		struct timespec start, finish;
+		breeze2d_get_time(&start);
+		breeze2d_poisson_solve(solver);
+		breeze2d_get_time(&finish);
+		time += breeze2d_get_time_diff(start, finish);
+	}
+	if (phi)
+		memcpy(phi, solution, sizeof(real) * m * n);
+
+	breeze2d_poisson_solver_dispose(solver);
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(solution);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	return time / nsolves;
+}
+
+int main(int argc, char* argv[])
+{
+	MPI_Init(&argc, &argv);
+
+	int rank, nranks;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+
+#define USAGE() \
+	{ \
+		if (!rank) \
+		{ \
+			printf("Usage: %s [<m> <n> [inplace] [weak] [nsolves]], where\n", argv[0]); \
+			printf("m, n - problem dimensions (n per process with weak)\n"); \
+			printf("inplace - solve in single buffer mode\n"); \
+			printf("weak - scale the problem with the number of processes\n"); \
+			printf("nsolves - the number of timed solves\n"); \
+		} \
+		MPI_Finalize(); \
+		return 0; \
+	}
+
+	int m = 255, n = 192, inplace = 0, weak = 0, nsolves = 10;
+	if ((argc == 2) || (argc > 6)) USAGE();
+	if (argc >= 3)
+	{
+		m = atoi(argv[1]);
+		n = atoi(argv[2]);
+	}
+	for (int i = 3; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "inplace"))
+			inplace = 1;
+		else if (!strcmp(argv[i], "weak"))
+			weak = 1;
+		else if (atoi(argv[i]) > 0)
+			nsolves = atoi(argv[i]);
+		else
+			USAGE();
+	}
+	if ((m <= 0) || (n <= 0)) USAGE();
+
+	// With weak scaling each process keeps n rows.
+	int nlocal = n;
+	if (weak) n *= nranks;
+
+	if (!rank)
+		printf("Distributed solve of %d x %d grid on %d processes, %s scaling\n\n",
+			m, n, nranks, weak ? "weak" : "strong");
+
+	real hx = M_PI / (m + 1);
+	real hy = 2.0 * M_PI / (n + 1);
+
+	unsigned int first, count;
+	breeze2d_poisson_mpi_get_rows(MPI_COMM_WORLD, n, &first, &count);
+	real* f = breeze2d_poisson_malloc(m, count, 0);
+	real* phi = inplace ? f : breeze2d_poisson_malloc(m, count, 0);
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	breeze2d_poisson_mpi_solver solver = breeze2d_poisson_mpi_solver_init(
+		MPI_COMM_WORLD, m, n, hx, hy, gby, gey, f, phi);
+
+	double time = 0.0;
+	for (int k = 0; k < nsolves; k++)
+	{
+		init_f(m, first, count, hx, hy, f);
+		init_g(m, n, hx, hy, gby, gey);
+		MPI_Barrier(MPI_COMM_WORLD);
+		double start = MPI_Wtime();
+		breeze2d_poisson_mpi_solve(solver);
+		double finish = MPI_Wtime();
+		double elapsed = finish - start, slowest;
+		MPI_Allreduce(&elapsed, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+		time += slowest;
+	}
+	time /= nsolves;
+
+	double times[3], maxtimes[3];
+	breeze2d_poisson_mpi_get_times(solver, &times[0], &times[1], &times[2]);
+	MPI_Reduce(times, maxtimes, 3, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+	// Gather the solution for comparison with serial solve.
+	real* gathered = NULL;
+	int *counts = NULL, *displs = NULL;
+	if (!rank)
+	{
+		gathered = (real*)malloc(sizeof(real) * m * n);
+		counts = (int*)malloc(sizeof(int) * nranks);
+		displs = (int*)malloc(sizeof(int) * nranks);
+	}
+	int size = m * count, offset = m * first;
+	MPI_Gather(&size, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Gather(&offset, 1, MPI_INT, displs, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Gatherv(phi, size, sizeof(real) == sizeof(float) ? MPI_FLOAT : MPI_DOUBLE,
+		gathered, counts, displs,
+		sizeof(real) == sizeof(float) ? MPI_FLOAT : MPI_DOUBLE, 0, MPI_COMM_WORLD);
+
+	breeze2d_poisson_mpi_solver_dispose(solver);
+	if (!inplace) breeze2d_poisson_free(phi);
+	breeze2d_poisson_free(f);
+	free(gby); free(gey);
+
+	int failed = 0;
+	if (!rank)
+	{
+		// Reference: serial solve of the whole grid, timed for
+		// strong scaling, and of the grid of one process, for weak.
+		real* reference = (real*)malloc(sizeof(real) * m * n);
+		double serial = serial_time(m, n, hx, hy, weak ? 1 : nsolves, reference);
+		if (weak)
+			serial = serial_time(m, nlocal, hx, hy, nsolves, NULL);
+
+		real diff = 0.0, norm = 0.0, error = 0.0;
+		for (int j = 0; j < n; j++)
+			for (int i = 0; i < m; i++)
+			{
+				real value = gathered[i + j * m];
+				real exact = sin(hx * (i + 1)) * cos(hy * (j + 1));
+				diff = MAX(diff, fabs(value - reference[i + j * m]));
+				norm = MAX(norm, fabs(reference[i + j * m]));
+				error = MAX(error, fabs(value - exact));
+			}
+		diff /= norm;
+		failed = (diff > ((sizeof(real) == sizeof(float)) ? 1e-4 : 1e-10));
+
+		printf("serial time = %f, distributed time = %f\n", serial, time);
+		if (weak)
+			printf("weak scaling efficiency = %.1f%%\n", 100.0 * serial / time);
+		else
+			printf("speedup = %.2f, strong scaling efficiency = %.1f%%\n",
+				serial / time, 100.0 * serial / time / nranks);
+		printf("max process time: transform = %f, shutter = %f, transpose wait = %f\n",
+			maxtimes[0] / nsolves, maxtimes[1] / nsolves, maxtimes[2] / nsolves);
+		printf("relative difference from serial solve = %e\n", diff);
+		printf("max error = %e\n", error);
+		printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+		free(reference);
+		free(gathered);
+		free(counts);
+		free(displs);
+	}
+
+	MPI_Bcast(&failed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	MPI_Finalize();
+
+	return failed;
+}
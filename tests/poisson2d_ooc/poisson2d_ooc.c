@@ -0,0 +1,218 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+// Set right hand side f(x,y), for the solution sin(x) cos(y),
+// zero at X boundaries.
+static void init_f(int m, int n, real hx, real hy, real* f)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y);
+		}
+}
+
+// Set boundary conditions by Y.
+static void init_g(int m, int n, real hx, real hy, real* gby, real* gey)
+{
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(hy * (n + 1));
+	}
+}
+
+// Write or read the whole array at the beginning of file.
+static int transfer(int fd, real* data, size_t size, int write)
+{
+	char* ptr = (char*)data;
+	for (off_t offset = 0; size; )
+	{
+		ssize_t done = write ? pwrite(fd, ptr, size, offset) :
+			pread(fd, ptr, size, offset);
+		if (done <= 0) return 1;
+		ptr += done; size -= done; offset += done;
+	}
+	return 0;
+}
+
+// Create temporary file for the grid, unlinked at once.
+static int create_file()
+{
+	char name[] = "poisson2d_ooc.XXXXXX";
+	int fd = mkstemp(name);
+	if (fd >= 0) unlink(name);
+	return fd;
+}
+
+int main(int argc, char* argv[])
+{
+#define USAGE() \
+	{ \
+		printf("Usage: %s [<m> <n> [memory] [inplace] [nsolves]], where\n", argv[0]); \
+		printf("m, n - problem dimensions\n"); \
+		printf("memory - the memory for bands in KB, 0 for the default\n"); \
+		printf("inplace - solve in single file mode\n"); \
+		printf("nsolves - the number of timed solves\n"); \
+		return 0; \
+	}
+
+	int m = 255, n = 383, inplace = 0, nsolves = 3;
+	size_t memory = 0;
+	if ((argc == 2) || (argc > 6)) USAGE();
+	if (argc >= 3)
+	{
+		m = atoi(argv[1]);
+		n = atoi(argv[2]);
+	}
+	if (argc >= 4)
+		memory = (size_t)atol(argv[3]) << 10;
+	for (int i = 4; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "inplace"))
+			inplace = 1;
+		else if (atoi(argv[i]) > 0)
+			nsolves = atoi(argv[i]);
+		else
+			USAGE();
+	}
+	if ((m <= 0) || (n <= 0)) USAGE();
+
+	real hx = M_PI / (m + 1);
+	real hy = 2.0 * M_PI / (n + 1);
+	size_t size = sizeof(real) * m * n;
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* phi = breeze2d_poisson_malloc(m, n, 0);
+	real* gbx = (real*)calloc(n, sizeof(real));
+	real* gex = (real*)calloc(n, sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	// Reference: in-memory solve.
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi);
+	double memory_time = 0.0;
+	for (int k = 0; k < nsolves; k++)
+	{
+		init_f(m, n, hx, hy, f);
+		init_g(m, n, hx, hy, gby, gey);
+		struct timespec start, finish;
+		breeze2d_get_time(&start);
+		breeze2d_poisson_solve(solver);
+		breeze2d_get_time(&finish);
+		memory_time += breeze2d_get_time_diff(start, finish);
+	}
+	memory_time /= nsolves;
+	breeze2d_poisson_solver_dispose(solver);
+
+	int rhs = create_file();
+	int solution = inplace ? rhs : create_file();
+	if ((rhs < 0) || (solution < 0))
+	{
+		printf("Cannot create temporary files\n");
+		return 1;
+	}
+
+	printf("Out-of-core solve of %d x %d grid (%.1f MB), %s\n\n", m, n,
+		size / 1048576.0, inplace ? "in place" : "out of place");
+
+	breeze2d_poisson_ooc_solver ooc = breeze2d_poisson_ooc_solver_init(
+		m, n, hx, hy, gby, gey, rhs, solution, memory);
+
+	// Files are written ahead of the timed solves, but may still
+	// be cached in memory.
+	double time = 0.0, io_time = 0.0, io_wait = 0.0;
+	breeze2d_poisson_ooc_stats stats;
+	init_f(m, n, hx, hy, f);
+	for (int k = 0; k < nsolves; k++)
+	{
+		if (transfer(rhs, f, size, 1))
+		{
+			printf("Cannot write the right hand side\n");
+			return 1;
+		}
+		breeze2d_poisson_ooc_solve(ooc);
+		breeze2d_poisson_ooc_get_stats(ooc, &stats);
+		time += stats.time;
+		io_time += stats.io_time;
+		io_wait += stats.io_wait;
+	}
+	time /= nsolves; io_time /= nsolves; io_wait /= nsolves;
+	breeze2d_poisson_ooc_solver_dispose(ooc);
+
+	real* result = breeze2d_poisson_malloc(m, n, 0);
+	if (transfer(solution, result, size, 0))
+	{
+		printf("Cannot read the solution\n");
+		return 1;
+	}
+	close(rhs);
+	if (!inplace) close(solution);
+
+	real diff = 0.0, norm = 0.0, error = 0.0;
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real value = result[i + j * m];
+			real exact = sin(hx * (i + 1)) * cos(hy * (j + 1));
+			diff = MAX(diff, fabs(value - phi[i + j * m]));
+			norm = MAX(norm, fabs(phi[i + j * m]));
+			error = MAX(error, fabs(value - exact));
+		}
+	diff /= norm;
+	int failed = (diff > ((sizeof(real) == sizeof(float)) ? 1e-4 : 1e-10));
+
+	size_t volume = stats.bytes_read + stats.bytes_written;
+	printf("I/O per solve: read = %zu, written = %zu bytes (%.2f grids)\n",
+		stats.bytes_read, stats.bytes_written, (double)volume / size);
+	printf("in-memory time = %f, out-of-core time = %f (%.2fx)\n",
+		memory_time, time, time / memory_time);
+	printf("I/O time = %f (%.2f GB/s), I/O wait = %f (%.1f%%)\n",
+		io_time, volume / io_time / 1e9, io_wait, 100.0 * io_wait / time);
+	printf("out-of-core throughput = %.2f GB/s of grid, %.1f%% of in-memory\n",
+		size / time / 1e9, 100.0 * memory_time / time);
+	printf("relative difference from in-memory solve = %e\n", diff);
+	printf("max error = %e\n", error);
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(phi);
+	breeze2d_poisson_free(result);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	return failed;
+}
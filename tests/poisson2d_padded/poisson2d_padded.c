@@ -0,0 +1,131 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Set the right hand side on [0, pi] x [0, 2 pi] grid.
+static void init_f(int m, int n, real hx, real hy, real* f)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y) + sin(3.0 * x + y);
+		}
+}
+
+// Set boundary conditions: by Y given, by X zero.
+static void init_g(int m, int n, real hx,
+	real* gbx, real* gex, real* gby, real* gey)
+{
+	for (int j = 0; j < n; j++)
+		gbx[j] = gex[j] = 0.0;
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(2.0 * x);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 61, n = 47;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+	size_t size = sizeof(real) * m * n;
+
+	// Arrays with halo of two points on each side.
+	int halo = 2, ld = m + 2 * halo, offset = halo * ld + halo;
+	int npadded = ld * (n + 2 * halo);
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* phi = breeze2d_poisson_malloc(m, n, 0);
+	real* u = (real*)malloc(size);
+	real* padded[2];
+	padded[0] = breeze2d_poisson_malloc(ld, n + 2 * halo, 0);
+	padded[1] = breeze2d_poisson_malloc(ld, n + 2 * halo, 0);
+	real* gbx = (real*)malloc(n * sizeof(real));
+	real* gex = (real*)malloc(n * sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	// Reference: solve of dense arrays.
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi);
+	init_f(m, n, hx, hy, f);
+	init_g(m, n, hx, gbx, gex, gby, gey);
+	breeze2d_poisson_solve(solver);
+	breeze2d_poisson_solver_dispose(solver);
+
+	// Solves of padded arrays, out of place and in place, must
+	// give the same solution bit by bit, and leave halo intact.
+	int failed = 0;
+	for (int inplace = 0; inplace <= 1; inplace++)
+	{
+		real* rhs = padded[0];
+		real* solution = padded[inplace ? 0 : 1];
+		solver = breeze2d_poisson_solver_init_padded(
+			BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+			gbx, gex, gby, gey, rhs, solution, ld, offset);
+		for (int i = 0; i < npadded; i++)
+			rhs[i] = solution[i] = -1.0;
+		init_f(m, n, hx, hy, u);
+		for (int j = 0; j < n; j++)
+			memcpy(rhs + offset + j * ld, u + j * m, sizeof(real) * m);
+		breeze2d_poisson_solve(solver);
+		breeze2d_poisson_solver_dispose(solver);
+
+		// Gather inner points, and count halo points changed.
+		int changed = 0;
+		for (int j = 0; j < n + 2 * halo; j++)
+			for (int i = 0; i < ld; i++)
+			{
+				if ((i >= halo) && (i < m + halo) &&
+					(j >= halo) && (j < n + halo))
+					u[(j - halo) * m + i - halo] = solution[j * ld + i];
+				else if (solution[j * ld + i] != -1.0)
+					changed++;
+			}
+		int differs = memcmp(u, phi, size) != 0;
+		printf("%s: %s, %d halo points changed\n",
+			inplace ? "in place" : "out of place",
+			differs ? "differs from dense solve" :
+			"bitwise equal to dense solve", changed);
+		failed |= differs || changed;
+	}
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(phi);
+	breeze2d_poisson_free(padded[0]);
+	breeze2d_poisson_free(padded[1]);
+	free(u);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
@@ -0,0 +1,157 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+#define ABS(x) (((x) > 0) ? (x) : -(x))
+
+// The maximum error expected at the default tolerance.
+#define MAXERR ((sizeof(real) == sizeof(float)) ? 1e-4 : 1e-8)
+
+// Set face coefficients k = 1 / rho with variable density.
+void init_k(int m, int n, real hx, real hy, real contrast,
+	real* kx, real* ky)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i <= m; i++)
+		{
+			real x = hx * (i + 0.5), y = hy * (j + 1);
+			kx[j * (m + 1) + i] = 1.0 / (1.0 + contrast * sin(x) * sin(x) * cos(y) * cos(y));
+		}
+	for (int j = 0; j <= n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1), y = hy * (j + 0.5);
+			ky[j * m + i] = 1.0 / (1.0 + contrast * sin(x) * sin(x) * cos(y) * cos(y));
+		}
+}
+
+// Known solution.
+void solution(int m, int n, real hx, real hy, real* phi)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1), y = hy * (j + 1);
+			phi[j * m + i] = sin(x) * sin(0.5 * y);
+		}
+}
+
+// Apply discrete operator div(k grad phi) to get right hand side.
+void init_f(int m, int n, real hx, real hy,
+	real* kx, real* ky, real* phi, real* f)
+{
+#define PHI(i, j) ((((i) < 0) || ((i) >= m) || ((j) < 0) || ((j) >= n)) ? \
+	0.0 : phi[(j) * m + (i)])
+
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real* k = kx + j * (m + 1);
+			f[j * m + i] =
+				(k[i + 1] * (PHI(i + 1, j) - PHI(i, j)) -
+				k[i] * (PHI(i, j) - PHI(i - 1, j))) / (hx * hx) +
+				(ky[(j + 1) * m + i] * (PHI(i, j + 1) - PHI(i, j)) -
+				ky[j * m + i] * (PHI(i, j) - PHI(i, j - 1))) / (hy * hy);
+		}
+}
+
+int main(int argc, char* argv[])
+{
+	printf("Solve 2D elliptic equation\n");
+	printf("with variable coefficients:\n");
+	printf("div(k grad phi) = f in D, phi = 0 on dD.\n\n");
+	printf("Method: PCG and BiCGStab, preconditioned\n");
+	printf("by 1d fft + shutter\n\n");
+
+	if ((argc != 4) && (argc != 5))
+	{
+		printf("Usage: %s <m> <n> <contrast> [<maxiters>], where\n", argv[0]);
+		printf("m, n - problem dimensions\n");
+		printf("contrast - density variation, rho = 1 .. 1 + contrast\n");
+		printf("maxiters - the number of iterations to fail the test above\n");
+		return 0;
+	}
+
+	int m = atoi(argv[1]), n = atoi(argv[2]);
+	real contrast = atof(argv[3]);
+	int maxiters = (argc == 5) ? atoi(argv[4]) : 100;
+	real hx = M_PI / (m + 1), hy = M_PI / (n + 1);
+
+	real* kx = (real*)malloc(sizeof(real) * (m + 1) * n);
+	real* ky = (real*)malloc(sizeof(real) * m * (n + 1));
+	real* f = (real*)malloc(sizeof(real) * m * n);
+	real* phi1 = (real*)malloc(sizeof(real) * m * n);
+	real* phi2 = (real*)malloc(sizeof(real) * m * n);
+	real* zero = (real*)calloc(MAX(m, n), sizeof(real));
+
+	init_k(m, n, hx, hy, contrast, kx, ky);
+	solution(m, n, hx, hy, phi2);
+	init_f(m, n, hx, hy, kx, ky, phi2, f);
+
+	// Preconditioner with zero boundary conditions,
+	// working in single buffer mode.
+	real* prhs = breeze2d_poisson_malloc(m, n, BREEZE2D_MALLOC_FIRST_TOUCH);
+	breeze2d_poisson_solver precond = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		zero, zero, zero, zero, prhs, prhs);
+
+	int methods[] = { BREEZE2D_ELLIPTIC_PCG, BREEZE2D_ELLIPTIC_BICGSTAB };
+	const char* names[] = { "PCG", "BiCGStab" };
+	int failed = 0;
+	for (int imethod = 0; imethod < 2; imethod++)
+	{
+		breeze2d_elliptic_solver solver = breeze2d_elliptic_solver_init(
+			methods[imethod], m, n, hx, hy, kx, ky, precond);
+
+		memset(phi1, 0, sizeof(real) * m * n);
+
+		struct timespec start, finish;
+		breeze2d_get_time(&start);
+
+		int niters = breeze2d_elliptic_solve(solver, f, phi1);
+
+		breeze2d_get_time(&finish);
+
+		real maxdiff = 0.0;
+		for (int i = 0; i < m * n; i++)
+			maxdiff = MAX(maxdiff, ABS(phi1[i] - phi2[i]));
+
+		int passed = (niters >= 0) && (niters <= maxiters) && (maxdiff < MAXERR);
+		printf("%s: iterations = %d, residual = %e, max error = %e, time = %f %s\n",
+			names[imethod], niters, breeze2d_elliptic_residual(solver), maxdiff,
+			breeze2d_get_time_diff(start, finish), passed ? "PASSED" : "FAILED");
+		if (!passed) failed++;
+
+		breeze2d_elliptic_solver_dispose(solver);
+	}
+
+	breeze2d_poisson_solver_dispose(precond);
+	breeze2d_poisson_free(prhs);
+	free(kx); free(ky); free(f); free(phi1); free(phi2); free(zero);
+
+	return failed;
+}
@@ -0,0 +1,149 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+#define ABS(x) (((x) > 0) ? (x) : -(x))
+
+// Estimated and measured plans may use different algorithms,
+// so solves are compared up to roundoff.
+#define TOLERANCE ((sizeof(real) == sizeof(float)) ? 1e-5 : 1e-13)
+
+// The number of solves, and the pause between them to let
+// background planning finish during the solves.
+#define NSOLVES 20
+#define PAUSE_NS 10000000
+
+// Set the right hand side on [0, pi] x [0, 2 pi] grid.
+static void init_f(int m, int n, real hx, real hy, real* f)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y) + sin(3.0 * x + y);
+		}
+}
+
+// Set boundary conditions: by Y given, by X zero.
+static void init_g(int m, int n, real hx,
+	real* gbx, real* gex, real* gby, real* gey)
+{
+	for (int j = 0; j < n; j++)
+		gbx[j] = gex[j] = 0.0;
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(2.0 * x);
+	}
+}
+
+// Get the maximum difference of solutions relative
+// to the maximum of the reference one.
+static real diff(int size, const real* phi, const real* ref)
+{
+	real maxdiff = 0.0, maxref = 0.0;
+	for (int i = 0; i < size; i++)
+	{
+		maxdiff = MAX(maxdiff, ABS(phi[i] - ref[i]));
+		maxref = MAX(maxref, ABS(ref[i]));
+	}
+	return maxdiff / maxref;
+}
+
+// Solve repeatedly, while measured plans are created in
+// background, and compare each solution with the reference.
+static int check(const char* name, breeze2d_poisson_solver solver,
+	int m, int n, real hx, real hy, real* f, real* phi, const real* ref)
+{
+	struct timespec pause = { 0, PAUSE_NS };
+	real maxdiff = 0.0;
+	for (int k = 0; k < NSOLVES; k++)
+	{
+		init_f(m, n, hx, hy, f);
+		breeze2d_poisson_solve(solver);
+		maxdiff = MAX(maxdiff, diff(m * n, phi, ref));
+		nanosleep(&pause, NULL);
+	}
+	int failed = maxdiff >= TOLERANCE;
+	printf("%s: %d solves, max relative difference = %e %s\n",
+		name, NSOLVES, maxdiff, failed ? "FAILED" : "PASSED");
+	return failed;
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 61, n = 47;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* phi = breeze2d_poisson_malloc(m, n, 0);
+	real* ref = breeze2d_poisson_malloc(m, n, 0);
+	real* gbx = (real*)malloc(n * sizeof(real));
+	real* gex = (real*)malloc(n * sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+	init_g(m, n, hx, gbx, gex, gby, gey);
+
+	// Reference: solve with measured plans.
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		gbx, gex, gby, gey, f, ref);
+	init_f(m, n, hx, hy, f);
+	breeze2d_poisson_solve(solver);
+	breeze2d_poisson_solver_dispose(solver);
+
+	// Solves must not be disturbed by planning in background,
+	// nor by the switch to measured plans, out of place with
+	// the cached right hand side plan, and in place.
+	int failed = 0;
+	solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT | BREEZE2D_POISSON_PROGRESSIVE |
+		BREEZE2D_POISSON_CACHE_RHS, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi);
+	failed += check("out of place", solver, m, n, hx, hy, f, phi, ref);
+	breeze2d_poisson_solver_dispose(solver);
+
+	solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT | BREEZE2D_POISSON_PROGRESSIVE,
+		m, n, hx, hy, gbx, gex, gby, gey, phi, phi);
+	failed += check("in place", solver, m, n, hx, hy, phi, phi, ref);
+	breeze2d_poisson_solver_dispose(solver);
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(phi);
+	breeze2d_poisson_free(ref);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
@@ -0,0 +1,91 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+// Get the maximum discrete divergence of staggered velocity field.
+static double max_divergence(int m, int n, real hx, real hy,
+	const real* u, const real* v)
+{
+	double div = 0.0;
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+			div = MAX(div, fabs(
+				((double)u[j * (m + 1) + i + 1] - u[j * (m + 1) + i]) / hx +
+				((double)v[(j + 1) * m + i] - v[j * m + i]) / hy));
+	return div;
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 61, n = 47;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* phi = breeze2d_poisson_malloc(m, n, 0);
+	real* u = (real*)malloc(sizeof(real) * (m + 1) * n);
+	real* v = (real*)malloc(sizeof(real) * m * (n + 1));
+	real* gbx = (real*)calloc(n, sizeof(real));
+	real* gex = (real*)calloc(n, sizeof(real));
+	real* gby = (real*)calloc(m, sizeof(real));
+	real* gey = (real*)calloc(m, sizeof(real));
+
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi);
+
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i <= m; i++)
+		{
+			real x = hx * i, y = hy * (j + 1);
+			u[j * (m + 1) + i] = cos(x) * sin(y) + x * y;
+		}
+	for (int j = 0; j <= n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1), y = hy * j;
+			v[j * m + i] = sin(2.0 * x) + 0.25 * y * y;
+		}
+	double before = max_divergence(m, n, hx, hy, u, v);
+
+	breeze2d_project(solver, u, v);
+	breeze2d_poisson_solver_dispose(solver);
+
+	// The divergence left is the solver roundoff.
+	double after = max_divergence(m, n, hx, hy, u, v) / before;
+	printf("maximum divergence after projection, relative = %e\n", after);
+	int failed = after > ((sizeof(real) == sizeof(float)) ? 1e-3 : 1e-9);
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(phi);
+	free(u); free(v);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
@@ -0,0 +1,181 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NSOLVERS 64
+#define NSTEPS 4
+
+// Defines solver with its own right hand side and solution
+// arrays for each step, and the step being solved in queue.
+struct problem_t
+{
+	int m, n, step;
+	real *rhs[NSTEPS], *solution[NSTEPS], *reference[NSTEPS];
+	real *bx, *ex, *by, *ey;
+	breeze2d_poisson_solver solver;
+	breeze2d_solve_queue queue;
+};
+
+static void init(struct problem_t* p, int m, int n)
+{
+	p->m = m; p->n = n;
+	for (int step = 0; step < NSTEPS; step++)
+	{
+		p->rhs[step] = breeze2d_poisson_malloc(m, n, 0);
+		p->solution[step] = breeze2d_poisson_malloc(m, n, 0);
+		p->reference[step] = (real*)malloc(sizeof(real) * m * n);
+	}
+	p->bx = (real*)calloc(n, sizeof(real));
+	p->ex = (real*)calloc(n, sizeof(real));
+	p->by = (real*)malloc(m * sizeof(real));
+	p->ey = (real*)malloc(m * sizeof(real));
+	for (int i = 0; i < m; i++)
+	{
+		p->by[i] = sin(0.1 * i);
+		p->ey[i] = cos(0.1 * i);
+	}
+	p->solver = breeze2d_poisson_solver_init(BREEZE2D_POISSON_SOLVER_FFT,
+		m, n, 1.0 / (m + 1), 1.0 / (n + 1),
+		p->bx, p->ex, p->by, p->ey, p->rhs[0], p->solution[0]);
+}
+
+// Fill the right hand sides of all steps.
+static void fill(struct problem_t* p)
+{
+	for (int step = 0; step < NSTEPS; step++)
+		for (int i = 0; i < p->m * p->n; i++)
+			p->rhs[step][i] = sin(0.01 * i + step) + cos(0.003 * i * (step + 1));
+}
+
+static void dispose(struct problem_t* p)
+{
+	breeze2d_poisson_solver_dispose(p->solver);
+	for (int step = 0; step < NSTEPS; step++)
+	{
+		breeze2d_poisson_free(p->rhs[step]);
+		breeze2d_poisson_free(p->solution[step]);
+		free(p->reference[step]);
+	}
+	free(p->bx); free(p->ex); free(p->by); free(p->ey);
+}
+
+// Submit the next step of the solver, as only one job
+// of the same solver may be queued at a time.
+static void next(breeze2d_poisson_solver solver, void* arg)
+{
+	struct problem_t* p = (struct problem_t*)arg;
+	if (++p->step == NSTEPS) return;
+	breeze2d_solve_queue_submit(p->queue, solver,
+		p->rhs[p->step], p->solution[p->step], next, p);
+}
+
+int main(int argc, char* argv[])
+{
+	int nworkers = 0;
+	if (argc == 2) nworkers = atoi(argv[1]);
+
+	printf("Queued solves of %d solvers x %d steps\n\n", NSOLVERS, NSTEPS);
+
+	// Mostly small grids, from 30 x 30, and a few large ones,
+	// up to 500 x 500.
+	struct problem_t* problems = (struct problem_t*)malloc(
+		sizeof(struct problem_t) * NSOLVERS);
+	long points = 0;
+	srand(1);
+	for (int k = 0; k < NSOLVERS; k++)
+	{
+		int m = 30 + rand() % 90, n = 30 + rand() % 90;
+		if (k % 16 == 0) { m = 400 + rand() % 101; n = 400 + rand() % 101; }
+		init(&problems[k], m, n);
+		points += (long)m * n * NSTEPS;
+	}
+
+	// Solve one by one for reference.
+	for (int k = 0; k < NSOLVERS; k++)
+		fill(&problems[k]);
+	struct timespec start, finish;
+	breeze2d_get_time(&start);
+	for (int k = 0; k < NSOLVERS; k++)
+	{
+		struct problem_t* p = &problems[k];
+		for (int step = 0; step < NSTEPS; step++)
+		{
+			breeze2d_poisson_solver_set_arrays(p->solver,
+				p->rhs[step], p->solution[step]);
+			breeze2d_poisson_solve(p->solver);
+		}
+	}
+	breeze2d_get_time(&finish);
+	double sequential = breeze2d_get_time_diff(start, finish);
+	for (int k = 0; k < NSOLVERS; k++)
+		for (int step = 0; step < NSTEPS; step++)
+			memcpy(problems[k].reference[step], problems[k].solution[step],
+				sizeof(real) * problems[k].m * problems[k].n);
+
+	// Same solves in queue, each solver chaining its steps.
+	breeze2d_solve_queue queue = breeze2d_solve_queue_init(nworkers, 0);
+	for (int k = 0; k < NSOLVERS; k++)
+	{
+		fill(&problems[k]);
+		memset(problems[k].solution[0], 0,
+			sizeof(real) * problems[k].m * problems[k].n);
+		problems[k].step = 0;
+		problems[k].queue = queue;
+	}
+	breeze2d_get_time(&start);
+	for (int k = 0; k < NSOLVERS; k++)
+		breeze2d_solve_queue_submit(queue, problems[k].solver,
+			problems[k].rhs[0], problems[k].solution[0], next, &problems[k]);
+	breeze2d_solve_queue_wait(queue);
+	breeze2d_get_time(&finish);
+	double queued = breeze2d_get_time_diff(start, finish);
+	breeze2d_solve_queue_dispose(queue);
+
+	int failed = 0;
+	for (int k = 0; k < NSOLVERS; k++)
+	{
+		struct problem_t* p = &problems[k];
+		for (int step = 0; step < NSTEPS; step++)
+			if (memcmp(p->reference[step], p->solution[step], sizeof(real) * p->m * p->n))
+			{
+				printf("Solver %d (%d x %d) step %d differs from sequential solve\n",
+					k, p->m, p->n, step);
+				failed = 1;
+			}
+	}
+
+	printf("sequential: %f s, %.1f solves/s, %.1f Mpoints/s\n", sequential,
+		NSOLVERS * NSTEPS / sequential, points / sequential * 1e-6);
+	printf("queued:     %f s, %.1f solves/s, %.1f Mpoints/s\n", queued,
+		NSOLVERS * NSTEPS / queued, points / queued * 1e-6);
+
+	for (int k = 0; k < NSOLVERS; k++)
+		dispose(&problems[k]);
+	free(problems);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
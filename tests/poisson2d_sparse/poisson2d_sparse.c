@@ -0,0 +1,98 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+// Set boundary conditions: by Y given, by X zero.
+static void init_g(int m, int n, real hx,
+	real* gbx, real* gex, real* gby, real* gey)
+{
+	for (int j = 0; j < n; j++)
+		gbx[j] = gex[j] = 0.0;
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(2.0 * x);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 61, n = 47;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* phi = breeze2d_poisson_malloc(m, n, 0);
+	real* u = breeze2d_poisson_malloc(m, n, 0);
+	real* gbx = (real*)malloc(n * sizeof(real));
+	real* gex = (real*)malloc(n * sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	// Point sources, the last one at the same point as the first.
+	int is[] = { 0, 30, 60, 17, 0 };
+	int js[] = { 0, 23, 46, 40, 0 };
+	real q[] = { 100.0, -250.0, 75.0, 30.0, 50.0 };
+	int nsources = sizeof(q) / sizeof(q[0]);
+
+	// Reference: solve with dense right hand side.
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi);
+	init_g(m, n, hx, gbx, gex, gby, gey);
+	memset(f, 0, sizeof(real) * m * n);
+	for (int k = 0; k < nsources; k++)
+		f[js[k] * m + is[k]] += q[k];
+	breeze2d_poisson_solve(solver);
+	breeze2d_poisson_solver_dispose(solver);
+
+	solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT | BREEZE2D_POISSON_SPARSE,
+		m, n, hx, hy, gbx, gex, gby, gey, f, u);
+	breeze2d_poisson_solve_sparse(solver, nsources, is, js, q);
+	breeze2d_poisson_solver_dispose(solver);
+
+	double norm = 0.0, diff = 0.0;
+	for (int i = 0; i < m * n; i++)
+	{
+		diff = MAX(diff, fabs(u[i] - phi[i]));
+		norm = MAX(norm, fabs(phi[i]));
+	}
+	diff /= norm;
+	printf("relative difference with dense solve = %e\n", diff);
+	int failed = diff > ((sizeof(real) == sizeof(float)) ? 1e-4 : 1e-10);
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(phi);
+	breeze2d_poisson_free(u);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
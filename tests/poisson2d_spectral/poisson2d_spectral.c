@@ -0,0 +1,131 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+// Set the right hand side on [0, pi] x [0, 2 pi] grid.
+static void init_f(int m, int n, real hx, real hy, real* f)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y) + sin(3.0 * x + y);
+		}
+}
+
+// Set boundary conditions: by Y given, by X zero.
+static void init_g(int m, int n, real hx,
+	real* gbx, real* gex, real* gby, real* gey)
+{
+	for (int j = 0; j < n; j++)
+		gbx[j] = gex[j] = 0.0;
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(2.0 * x);
+	}
+}
+
+// Get the maximum residual of 5-point scheme, relative
+// to the maximum right hand side.
+static double residual(int m, int n, real hx, real hy, const real* f,
+	const real* gby, const real* gey, const real* phi)
+{
+	double norm = 0.0, res = 0.0;
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			double u = phi[j * m + i];
+			double w = i ? phi[j * m + i - 1] : 0.0;
+			double e = (i < m - 1) ? phi[j * m + i + 1] : 0.0;
+			double s = j ? phi[(j - 1) * m + i] : gby[i];
+			double nn = (j < n - 1) ? phi[(j + 1) * m + i] : gey[i];
+			double laplace = (w - 2.0 * u + e) / ((double)hx * hx) +
+				(s - 2.0 * u + nn) / ((double)hy * hy);
+			res = MAX(res, fabs(laplace - f[j * m + i]));
+			norm = MAX(norm, fabs(f[j * m + i]));
+		}
+	return res / norm;
+}
+
+int main(int argc, char* argv[])
+{
+	// The plain solve normalizes in shutter, and the chain after
+	// inverse transform: m + 1 is a power of two, so that
+	// normalization is exact, and solutions are the same bitwise.
+	int m = 63, n = 47;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+	size_t size = sizeof(real) * m * n;
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* phi = breeze2d_poisson_malloc(m, n, 0);
+	real* u = breeze2d_poisson_malloc(m, n, 0);
+	real* rhs = (real*)malloc(size);
+	real* gbx = (real*)malloc(n * sizeof(real));
+	real* gex = (real*)malloc(n * sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		gbx, gex, gby, gey, f, u);
+	init_f(m, n, hx, hy, rhs);
+	init_g(m, n, hx, gbx, gex, gby, gey);
+
+	memcpy(f, rhs, size);
+	breeze2d_poisson_solve(solver);
+	memcpy(phi, u, size);
+
+	// Forward transform, solve in spectral space,
+	// and inverse transform.
+	memcpy(f, rhs, size);
+	breeze2d_poisson_forward(solver, f, u);
+	breeze2d_poisson_solve_spectral(solver, u, f);
+	breeze2d_poisson_inverse(solver, f, u);
+	breeze2d_poisson_solver_dispose(solver);
+
+	int failed = memcmp(u, phi, size) != 0;
+	printf("spectral solve %s\n", failed ?
+		"differs from solve" : "is bitwise equal to solve");
+
+	double res = residual(m, n, hx, hy, rhs, gby, gey, u);
+	printf("relative residual = %e\n", res);
+	failed |= res > ((sizeof(real) == sizeof(float)) ? 1e-3 : 1e-9);
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(phi);
+	breeze2d_poisson_free(u);
+	free(rhs);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
@@ -0,0 +1,159 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+// Set the right hand side on [0, pi] x [0, 2 pi] grid.
+static void init_f(int m, int n, real hx, real hy, real* f)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y) + sin(3.0 * x + y);
+		}
+}
+
+// Set boundary conditions: by Y given, by X zero.
+static void init_g(int m, int n, real hx,
+	real* gbx, real* gex, real* gby, real* gey)
+{
+	for (int j = 0; j < n; j++)
+		gbx[j] = gex[j] = 0.0;
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(2.0 * x);
+	}
+}
+
+// Get the maximum residual of 5-point scheme with variable Y steps,
+// relative to the maximum right hand side.
+static double residual(int m, int n, real hx, const real* hy, const real* f,
+	const real* gby, const real* gey, const real* phi)
+{
+	double norm = 0.0, res = 0.0;
+	for (int j = 0; j < n; j++)
+	{
+		// a U(j - 1) - (a + c) U(j) + c U(j + 1) by Y.
+		double h = (double)hy[j] + hy[j + 1];
+		double a = 2.0 / (hy[j] * h), c = 2.0 / (hy[j + 1] * h);
+		for (int i = 0; i < m; i++)
+		{
+			double u = phi[j * m + i];
+			double w = i ? phi[j * m + i - 1] : 0.0;
+			double e = (i < m - 1) ? phi[j * m + i + 1] : 0.0;
+			double s = j ? phi[(j - 1) * m + i] : gby[i];
+			double nn = (j < n - 1) ? phi[(j + 1) * m + i] : gey[i];
+			double laplace = (w - 2.0 * u + e) / ((double)hx * hx) +
+				a * s - (a + c) * u + c * nn;
+			res = MAX(res, fabs(laplace - f[j * m + i]));
+			norm = MAX(norm, fabs(f[j * m + i]));
+		}
+	}
+	return res / norm;
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 61, n = 47;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+	size_t size = sizeof(real) * m * n;
+	double tolerance = (sizeof(real) == sizeof(float)) ? 1e-3 : 1e-9;
+
+	real* f = breeze2d_poisson_malloc(m, n, 0);
+	real* phi = breeze2d_poisson_malloc(m, n, 0);
+	real* u = breeze2d_poisson_malloc(m, n, 0);
+	real* rhs = (real*)malloc(size);
+	real* hys = (real*)malloc((n + 1) * sizeof(real));
+	real* gbx = (real*)malloc(n * sizeof(real));
+	real* gex = (real*)malloc(n * sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	// Reference: solve on uniform grid.
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT, m, n, hx, hy,
+		gbx, gex, gby, gey, f, phi);
+	init_f(m, n, hx, hy, rhs);
+	init_g(m, n, hx, gbx, gex, gby, gey);
+	memcpy(f, rhs, size);
+	breeze2d_poisson_solve(solver);
+	breeze2d_poisson_solver_dispose(solver);
+
+	// Until steps are set, the solve is the uniform grid one.
+	solver = breeze2d_poisson_solver_init(
+		BREEZE2D_POISSON_SOLVER_FFT | BREEZE2D_POISSON_STRETCHED_Y,
+		m, n, hx, hy, gbx, gex, gby, gey, f, u);
+	memcpy(f, rhs, size);
+	breeze2d_poisson_solve(solver);
+	int failed = memcmp(u, phi, size) != 0;
+	printf("no steps set: %s\n", failed ?
+		"differs from uniform grid solve" :
+		"bitwise equal to uniform grid solve");
+
+	// Uniform steps: stretched shutter scales equations by
+	// inverse squared steps, rather than by hy squared, so the
+	// solution is the same up to roundoff.
+	for (int k = 0; k <= n; k++)
+		hys[k] = hy;
+	breeze2d_poisson_solver_set_grid_y(solver, hys);
+	memcpy(f, rhs, size);
+	breeze2d_poisson_solve(solver);
+	double norm = 0.0, diff = 0.0;
+	for (int i = 0; i < m * n; i++)
+	{
+		diff = MAX(diff, fabs(u[i] - phi[i]));
+		norm = MAX(norm, fabs(phi[i]));
+	}
+	diff /= norm;
+	printf("uniform steps: relative difference with uniform grid solve = %e\n", diff);
+	failed |= diff > ((sizeof(real) == sizeof(float)) ? 1e-5 : 1e-13);
+
+	// Steps refined towards Y boundaries.
+	for (int k = 0; k <= n; k++)
+		hys[k] = hy * (0.5 + sin(M_PI * (k + 0.5) / (n + 1)));
+	breeze2d_poisson_solver_set_grid_y(solver, hys);
+	memcpy(f, rhs, size);
+	breeze2d_poisson_solve(solver);
+	breeze2d_poisson_solver_dispose(solver);
+	double res = residual(m, n, hx, hys, rhs, gby, gey, u);
+	printf("stretched steps: relative residual = %e\n", res);
+	failed |= res > tolerance;
+
+	breeze2d_poisson_free(f);
+	breeze2d_poisson_free(phi);
+	breeze2d_poisson_free(u);
+	free(rhs); free(hys);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
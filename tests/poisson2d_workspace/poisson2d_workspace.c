@@ -0,0 +1,114 @@
+/*
+ * poisson2d - solver for 2D Poisson problem
+ *             with Dirichlet or Neumann boundary conditions
+ *
+ * Copyright (C) 2011 Dmitry Mikushin
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <breeze2d.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Set the right hand side on [0, pi] x [0, 2 pi] grid.
+static void init_f(int m, int n, real hx, real hy, real* f)
+{
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < m; i++)
+		{
+			real x = hx * (i + 1);
+			real y = hy * (j + 1);
+			f[j * m + i] = -2.0 * sin(x) * cos(y) + sin(3.0 * x + y);
+		}
+}
+
+// Set boundary conditions: by Y given, by X zero.
+static void init_g(int m, int n, real hx,
+	real* gbx, real* gex, real* gby, real* gey)
+{
+	for (int j = 0; j < n; j++)
+		gbx[j] = gex[j] = 0.0;
+	for (int i = 0; i < m; i++)
+	{
+		real x = hx * (i + 1);
+		gby[i] = sin(x);
+		gey[i] = sin(x) * cos(2.0 * x);
+	}
+}
+
+// Allocate array aligned as workspace.
+static void* aligned(size_t size)
+{
+	void* ptr = NULL;
+	if (posix_memalign(&ptr, 64, size)) return NULL;
+	return ptr;
+}
+
+int main(int argc, char* argv[])
+{
+	int m = 61, n = 47;
+	real hx = M_PI / (m + 1), hy = 2.0 * M_PI / (n + 1);
+	size_t size = sizeof(real) * m * n;
+	int mode = BREEZE2D_POISSON_SOLVER_FFT;
+
+	real* f = (real*)aligned(size);
+	real* phi = (real*)aligned(size);
+	real* u = (real*)aligned(size);
+	real* gbx = (real*)malloc(n * sizeof(real));
+	real* gex = (real*)malloc(n * sizeof(real));
+	real* gby = (real*)malloc(m * sizeof(real));
+	real* gey = (real*)malloc(m * sizeof(real));
+
+	// Reference: solver of plain init.
+	breeze2d_poisson_solver solver = breeze2d_poisson_solver_init(
+		mode, m, n, hx, hy, gbx, gex, gby, gey, f, phi);
+	init_f(m, n, hx, hy, f);
+	init_g(m, n, hx, gbx, gex, gby, gey);
+	breeze2d_poisson_solve(solver);
+	breeze2d_poisson_solver_dispose(solver);
+
+	size_t wsize = breeze2d_poisson_solver_workspace_size(mode, m, n);
+	void* workspace = aligned(wsize);
+	printf("Workspace of %d x %d solver: %zu bytes\n\n", m, n, wsize);
+
+	// Solves of the solver placed into workspace must give
+	// the same solution, bit by bit.
+	solver = breeze2d_poisson_solver_init_workspace(
+		mode, m, n, hx, hy, gbx, gex, gby, gey, f, u, workspace, wsize);
+	int failed = !solver;
+	for (int k = 0; solver && (k < 2); k++)
+	{
+		init_f(m, n, hx, hy, f);
+		breeze2d_poisson_solve(solver);
+		int differs = memcmp(u, phi, size) != 0;
+		printf("solve %d: %s\n", k, differs ?
+			"differs from plain solver" : "bitwise equal to plain solver");
+		failed |= differs;
+	}
+	if (solver) breeze2d_poisson_solver_dispose(solver);
+
+	free(workspace);
+	free(f); free(phi); free(u);
+	free(gbx); free(gex); free(gby); free(gey);
+
+	printf("\n%s\n", failed ? "FAILED" : "PASSED");
+
+	return failed;
+}
@@ -18,11 +18,23 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+
 #include "breeze2d.h"
 
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 
+#ifdef __linux__
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #ifdef CLOCK_GETTIME_NOT_IMPLEMENTED
 int clock_gettime(int id, struct timespec* t)
 {
@@ -72,3 +84,317 @@ void breeze2d_print_time_diff(
 	printf("%ld.%09ld", tv_sec, tv_nsec);
 }
 
+
+// The size of STREAM triad arrays (doubles), well beyond caches,
+// and the number of timed runs.
+#define STREAM_SIZE	((size_t)1 << 22)
+#define STREAM_NTIMES	5
+
+// The size of cache line transferred per last level cache miss.
+#define CACHE_LINE	64
+
+#define NEVENTS 4
+
+// Opened hardware counters: nfds counter descriptors (of capacity),
+// each counting events of kinds[i] in thread tids[i]. All fields
+// are guarded by mutex.
+static struct
+{
+	pthread_mutex_t mutex;
+	int nopened;
+	unsigned int available;
+	int nfds, capacity;
+	int *fds, *kinds;
+	pid_t* tids;
+	double stream;
+}
+counters = { PTHREAD_MUTEX_INITIALIZER, 0, 0, 0, 0, NULL, NULL, NULL, 0.0 };
+
+#ifdef __linux__
+// Hardware events of BREEZE2D_COUNTER_* flags, in order.
+static const struct
+{
+	__u32 type;
+	__u64 config;
+}
+events[NEVENTS] =
+{
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+		(PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+		(PERF_COUNT_HW_CACHE_OP_WRITE << 8) |
+		(PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+};
+
+// Open counter of the event in user space of the thread, or
+// return -1. Counters are not inherited: counts of inherited
+// counters are added to the parent only when the child exits,
+// so the threads of pools would not be counted at all.
+static int open_event(int kind, pid_t tid)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = events[kind].type;
+	attr.config = events[kind].config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+		PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0);
+}
+
+// Add counter descriptor to the opened ones,
+// or close it, if out of memory.
+static void add_fd(int fd, int kind, pid_t tid)
+{
+	if (counters.nfds == counters.capacity)
+	{
+		int capacity = counters.capacity ? 2 * counters.capacity : 4 * NEVENTS;
+		int* fds = (int*)realloc(counters.fds, sizeof(int) * capacity);
+		if (fds) counters.fds = fds;
+		int* kinds = (int*)realloc(counters.kinds, sizeof(int) * capacity);
+		if (kinds) counters.kinds = kinds;
+		pid_t* tids = (pid_t*)realloc(counters.tids, sizeof(pid_t) * capacity);
+		if (tids) counters.tids = tids;
+		if (!fds || !kinds || !tids)
+		{
+			close(fd);
+			return;
+		}
+		counters.capacity = capacity;
+	}
+	counters.fds[counters.nfds] = fd;
+	counters.kinds[counters.nfds] = kind;
+	counters.tids[counters.nfds++] = tid;
+}
+
+// Check if counters of the thread are opened.
+static int is_opened(pid_t tid)
+{
+	for (int i = 0; i < counters.nfds; i++)
+		if (counters.tids[i] == tid) return 1;
+	return 0;
+}
+
+// Open counters of available events for the threads
+// of the process, not counted yet.
+static void open_threads()
+{
+	DIR* dir = opendir("/proc/self/task");
+	if (!dir) return;
+	for (struct dirent* entry = readdir(dir); entry; entry = readdir(dir))
+	{
+		pid_t tid = atoi(entry->d_name);
+		if ((tid <= 0) || is_opened(tid)) continue;
+		for (int kind = 0; kind < NEVENTS; kind++)
+		{
+			if (!(counters.available & (1 << kind))) continue;
+			int fd = open_event(kind, tid);
+			if (fd >= 0) add_fd(fd, kind, tid);
+		}
+	}
+	closedir(dir);
+}
+
+// Open counters of events available in the calling thread,
+// for all threads of the process.
+static void open_all()
+{
+	// Start the OpenMP threads of the caller, so that
+	// they are counted from the first parallel region.
+	#pragma omp parallel
+	{ }
+
+	pid_t self = syscall(SYS_gettid);
+	for (int kind = 0; kind < NEVENTS; kind++)
+	{
+		int fd = open_event(kind, self);
+		if (fd < 0) continue;
+		add_fd(fd, kind, self);
+		counters.available |= 1 << kind;
+	}
+	if (!counters.available) return;
+
+	open_threads();
+}
+
+// Read the counter, scaled for the time it was not
+// scheduled, if events were multiplexed.
+static long long read_fd(int fd)
+{
+	__u64 values[3];
+	if (read(fd, values, sizeof(values)) != sizeof(values) || !values[2])
+		return 0;
+	if (values[2] == values[1])
+		return values[0];
+	return (long long)((double)values[0] * values[1] / values[2]);
+}
+#endif
+
+// Open hardware counters of all threads of the process.
+unsigned int breeze2d_counters_open()
+{
+	pthread_mutex_lock(&counters.mutex);
+#ifdef __linux__
+	if (!counters.nopened)
+		open_all();
+#endif
+	counters.nopened++;
+	unsigned int available = counters.available;
+	pthread_mutex_unlock(&counters.mutex);
+
+	return available;
+}
+
+// Close hardware counters, once closed by all openers.
+void breeze2d_counters_close()
+{
+	pthread_mutex_lock(&counters.mutex);
+	if (counters.nopened && !--counters.nopened)
+	{
+#ifdef __linux__
+		for (int i = 0; i < counters.nfds; i++)
+			close(counters.fds[i]);
+#endif
+		free(counters.fds);
+		free(counters.kinds);
+		free(counters.tids);
+		counters.fds = NULL;
+		counters.kinds = NULL;
+		counters.tids = NULL;
+		counters.nfds = 0;
+		counters.capacity = 0;
+		counters.available = 0;
+	}
+	pthread_mutex_unlock(&counters.mutex);
+}
+
+// Read the built-in timer and hardware counters. Threads
+// created since the previous read are counted from now on.
+void breeze2d_counters_read(breeze2d_counters* values)
+{
+	long long counts[NEVENTS] = { 0 };
+	pthread_mutex_lock(&counters.mutex);
+#ifdef __linux__
+	if (counters.available)
+		open_threads();
+	for (int i = 0; i < counters.nfds; i++)
+		counts[counters.kinds[i]] += read_fd(counters.fds[i]);
+#endif
+	values->available = counters.available;
+	pthread_mutex_unlock(&counters.mutex);
+
+	struct timespec t;
+	breeze2d_get_time(&t);
+	values->time = t.tv_sec + 0.000000001 * t.tv_nsec;
+	values->cycles = counts[0];
+	values->instructions = counts[1];
+	values->llc_load_misses = counts[2];
+	values->llc_store_misses = counts[3];
+}
+
+// Add counts between start and finish to sum.
+void breeze2d_counters_accumulate(breeze2d_counters* sum,
+	const breeze2d_counters* start, const breeze2d_counters* finish)
+{
+	sum->time += finish->time - start->time;
+	sum->cycles += finish->cycles - start->cycles;
+	sum->instructions += finish->instructions - start->instructions;
+	sum->llc_load_misses += finish->llc_load_misses - start->llc_load_misses;
+	sum->llc_store_misses += finish->llc_store_misses - start->llc_store_misses;
+	sum->available = start->available & finish->available;
+}
+
+// Derive metrics from counters of a code region.
+void breeze2d_counters_get_metrics(const breeze2d_counters* values,
+	double npoints, breeze2d_counter_metrics* metrics)
+{
+	metrics->ipc = 0.0;
+	metrics->bytes_per_point = 0.0;
+	metrics->bandwidth = 0.0;
+	metrics->stream_fraction = 0.0;
+
+	unsigned int cycles = BREEZE2D_COUNTER_CYCLES |
+		BREEZE2D_COUNTER_INSTRUCTIONS;
+	if (((values->available & cycles) == cycles) && values->cycles)
+		metrics->ipc = (double)values->instructions / values->cycles;
+
+	if (!(values->available & BREEZE2D_COUNTER_LLC_LOAD_MISSES))
+		return;
+
+	// Stores missing in cache load the line, then write it back.
+	double bytes = (double)CACHE_LINE * values->llc_load_misses;
+	if (values->available & BREEZE2D_COUNTER_LLC_STORE_MISSES)
+		bytes += 2.0 * CACHE_LINE * values->llc_store_misses;
+	if (npoints > 0)
+		metrics->bytes_per_point = bytes / npoints;
+	if (values->time > 0)
+	{
+		metrics->bandwidth = bytes / values->time;
+		double stream = breeze2d_stream_bandwidth();
+		if (stream > 0)
+			metrics->stream_fraction = metrics->bandwidth / stream;
+	}
+}
+
+// Measure memory bandwidth with STREAM triad, the best of runs,
+// counting the bytes of three arrays per run, as STREAM does.
+static double stream_triad()
+{
+	double* a = (double*)malloc(sizeof(double) * STREAM_SIZE);
+	double* b = (double*)malloc(sizeof(double) * STREAM_SIZE);
+	double* c = (double*)malloc(sizeof(double) * STREAM_SIZE);
+	if (!a || !b || !c)
+	{
+		free(a); free(b); free(c);
+		return 0.0;
+	}
+
+	// Pages are placed by the threads using them.
+	#pragma omp parallel for
+	for (long i = 0; i < STREAM_SIZE; i++)
+	{
+		a[i] = 1.0; b[i] = 2.0; c[i] = 0.0;
+	}
+
+	double best = 0.0;
+	for (int k = 0; k < STREAM_NTIMES; k++)
+	{
+		struct timespec start, finish;
+		breeze2d_get_time(&start);
+		#pragma omp parallel for
+		for (long i = 0; i < STREAM_SIZE; i++)
+			a[i] = b[i] + 3.0 * c[i];
+		breeze2d_get_time(&finish);
+		double time = breeze2d_get_time_diff(start, finish);
+		if (time > 0)
+		{
+			double bandwidth = 3.0 * sizeof(double) * STREAM_SIZE / time;
+			if (bandwidth > best) best = bandwidth;
+		}
+	}
+
+	free(a); free(b); free(c);
+	return best;
+}
+
+// Get memory bandwidth in bytes per second.
+double breeze2d_stream_bandwidth()
+{
+	pthread_mutex_lock(&counters.mutex);
+	if (counters.stream <= 0)
+	{
+		char* env = getenv("BREEZE2D_STREAM_BANDWIDTH");
+		counters.stream = env ? atof(env) * 1e9 : 0.0;
+		if (counters.stream <= 0)
+			counters.stream = stream_triad();
+	}
+	double stream = counters.stream;
+	pthread_mutex_unlock(&counters.mutex);
+
+	return stream;
+}